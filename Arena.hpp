@@ -0,0 +1,239 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <sys/mman.h>
+
+#include <cstdint>
+
+#include <algorithm>
+#include <vector>
+
+#include <format>
+
+#include <stdexcept>
+
+using std::vector;
+
+using std::format;
+
+using std::runtime_error;
+
+enum ArenaPages {
+	ArenaSmallPages,
+	ArenaTransparentHugePages,
+	ArenaExplicitHugePages
+};
+
+struct ArenaStatistics {
+	// Bytes handed out (including alignment padding)
+	size_t bytes_used;
+
+	// Bytes made accessible (rounded up to the commit granularity)
+	size_t bytes_committed;
+
+	// Reserved regions
+	size_t buffer_count;
+};
+
+/**
+	Bump allocator over lazily committed virtual memory.
+
+	Regions are reserved with mmap (no memory is used until committed) and made accessible in
+	steps of COMMIT_LENGTH as the watermark advances, so a fresh arena costs nothing and the
+	unused tail of a region is never committed. On Linux, regions are advised for transparent
+	huge pages, or backed by explicit (hugetlbfs) huge pages when requested and available.
+
+	Allocations that do not fit in the current region move on to the next one (reserving it if
+	needed). A mark records the current position; rewinding to it releases every allocation
+	made after the mark for reuse, keeping the committed memory.
+*/
+class Arena {
+public:
+	// Default region reservation (virtual memory only)
+	constexpr static size_t REGION_LENGTH = 1024UL * 1024 * 1024;
+
+	// Commit granularity: the size of a huge page
+	constexpr static size_t COMMIT_LENGTH = 2UL * 1024 * 1024;
+
+	struct Mark {
+		size_t region;
+		size_t watermark;
+	};
+
+private:
+	struct Region {
+		char *base;
+		size_t length;
+
+		size_t committed;
+		size_t watermark;
+	};
+
+	ArenaPages pages;
+	size_t region_length;
+
+	vector<Region> regions;
+
+	// Region currently allocated from (regions after it are empty)
+	size_t current;
+
+	constexpr static size_t align_up(size_t value, size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	char *reserve(size_t length) {
+#ifdef LINUX
+		if(pages == ArenaExplicitHugePages) {
+			// Without MAP_NORESERVE the huge pages are reserved up front: a later fault cannot fail
+			void *result = mmap(nullptr, length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+			// Falls back to transparent huge pages when not enough huge pages are configured
+			if(result != MAP_FAILED) {
+				return static_cast<char *>(result);
+			}
+		}
+
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#else
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+
+		// Over-reserves to align the region to a huge page boundary
+		void *result = mmap(nullptr, length + COMMIT_LENGTH, PROT_NONE, flags, -1, 0);
+
+		if(result == MAP_FAILED) {
+			throw runtime_error(format("Error reserving {} bytes for an arena\n", length));
+		}
+
+		char *start = static_cast<char *>(result);
+		char *base = reinterpret_cast<char *>(align_up(reinterpret_cast<uintptr_t>(start), COMMIT_LENGTH));
+
+		if(base != start) {
+			munmap(start, base - start);
+		}
+
+		if(base + length != start + length + COMMIT_LENGTH) {
+			munmap(base + length, (start + length + COMMIT_LENGTH) - (base + length));
+		}
+
+#ifdef LINUX
+		if(pages != ArenaSmallPages) {
+			madvise(base, length, MADV_HUGEPAGE);
+		}
+#endif
+
+		return base;
+	}
+
+	void commit(Region &region, size_t end) {
+		size_t committed = std::min(align_up(end, COMMIT_LENGTH), region.length);
+
+		if(mprotect(region.base + region.committed, committed - region.committed, PROT_READ | PROT_WRITE) != 0) {
+			throw runtime_error(format("Error committing {} bytes of an arena\n", committed - region.committed));
+		}
+
+		region.committed = committed;
+	}
+
+	// Moves to a region with at least length bytes, reusing empty regions left by a rewind
+	void next_region(size_t length) {
+		size_t next = (regions.empty() ? 0 : current + 1);
+
+		if(next < regions.size() && regions[next].length >= length) {
+			current = next;
+			return;
+		}
+
+		size_t reservation = align_up(std::max(length, region_length), COMMIT_LENGTH);
+
+		regions.insert(regions.begin() + next, Region{reserve(reservation), reservation, 0, 0});
+		current = next;
+	}
+
+public:
+	Arena(ArenaPages pages = ArenaTransparentHugePages, size_t region_length = REGION_LENGTH): pages{pages}, region_length{region_length}, current{0} {
+	}
+
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	~Arena() {
+		for(auto &region: regions) {
+			munmap(region.base, region.length);
+		}
+	}
+
+	/**
+		Allocates uninitialized memory.
+
+		@param length Number of bytes
+		@param alignment Alignment (a power of two, at most COMMIT_LENGTH)
+		@return Pointer to the allocated bytes
+	*/
+	inline char *allocate_bytes(size_t length, size_t alignment = 1) {
+		if(!regions.empty()) {
+			Region &region = regions[current];
+
+			size_t start = align_up(region.watermark, alignment);
+
+			if(start + length <= region.length) {
+				if(start + length > region.committed) {
+					commit(region, start + length);
+				}
+
+				region.watermark = start + length;
+
+				return region.base + start;
+			}
+		}
+
+		next_region(length);
+
+		Region &region = regions[current];
+
+		if(length > region.committed) {
+			commit(region, length);
+		}
+
+		region.watermark = length;
+
+		return region.base;
+	}
+
+	// Allocates uninitialized storage for quantity objects of type T
+	template<typename T>
+	inline T *allocate(size_t quantity) {
+		return reinterpret_cast<T *>(allocate_bytes(quantity * sizeof(T), alignof(T)));
+	}
+
+	inline Mark get_mark() const {
+		return Mark{current, (regions.empty() ? 0 : regions[current].watermark)};
+	}
+
+	// Releases every allocation made after the mark was taken
+	inline void rewind(const Mark &mark) {
+		if(regions.empty()) {
+			return;
+		}
+
+		for(size_t i = mark.region + 1; i <= current; i++) {
+			regions[i].watermark = 0;
+		}
+
+		current = mark.region;
+		regions[current].watermark = mark.watermark;
+	}
+
+	ArenaStatistics get_statistics() const {
+		ArenaStatistics result{0, 0, regions.size()};
+
+		for(auto &region: regions) {
+			result.bytes_used += region.watermark;
+			result.bytes_committed += region.committed;
+		}
+
+		return result;
+	}
+};
+
+#endif /* ARENA_H */
@@ -0,0 +1,68 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+
+using std::queue;
+using std::mutex;
+using std::condition_variable;
+
+template<typename T>
+class BoundedQueue {
+private:
+	queue<T> elements;
+	size_t capacity;
+
+	bool closed;
+
+	mutex serializer;
+
+	condition_variable not_empty;
+	condition_variable not_full;
+
+public:
+	BoundedQueue(size_t capacity): capacity{capacity}, closed{false} {
+	}
+
+	// Blocks while the queue is full
+	inline void push(T element) {
+		std::unique_lock<mutex> lock(serializer);
+
+		not_full.wait(lock, [this] { return elements.size() < capacity; });
+
+		elements.push(std::move(element));
+
+		not_empty.notify_one();
+	}
+
+	// Blocks while the queue is empty; returns false once it is closed and drained
+	inline bool pop(T &element) {
+		std::unique_lock<mutex> lock(serializer);
+
+		not_empty.wait(lock, [this] { return !elements.empty() || closed; });
+
+		if(elements.empty()) {
+			return false;
+		}
+
+		element = std::move(elements.front());
+		elements.pop();
+
+		not_full.notify_one();
+
+		return true;
+	}
+
+	// No more elements will be pushed: wakes up every waiting consumer
+	inline void close() {
+		std::lock_guard<mutex> lock(serializer);
+
+		closed = true;
+
+		not_empty.notify_all();
+	}
+};
+
+#endif /* BOUNDED_QUEUE_H */
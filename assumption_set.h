@@ -0,0 +1,83 @@
+#ifndef ASSUMPTION_SET_H
+#define ASSUMPTION_SET_H
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+/**
+	Set of assumptions (ASM derivations, numbered densely in certificate order) packed in
+	64-bit words, without trailing zero words. Unions are word-parallel ORs and membership
+	is a bit test.
+
+	Sets are built once and then only read: derivations that inherit their dependencies
+	unchanged share the set of their premise instead of copying it.
+*/
+class AssumptionSet {
+	vector<uint64_t> words;
+
+	inline void trim() {
+		while(!words.empty() && words.back() == 0) {
+			words.pop_back();
+		}
+	}
+
+public:
+	inline bool empty() const {
+		return words.empty();
+	}
+
+	inline bool contains(unsigned long id) const {
+		unsigned long word = (id >> 6);
+
+		return (word < words.size() && ((words[word] >> (id & 63)) & 1) != 0);
+	}
+
+	inline void insert(unsigned long id) {
+		unsigned long word = (id >> 6);
+
+		if(word >= words.size()) {
+			words.resize(word + 1, 0);
+		}
+
+		words[word] |= (1ULL << (id & 63));
+	}
+
+	inline void erase(unsigned long id) {
+		unsigned long word = (id >> 6);
+
+		if(word < words.size()) {
+			words[word] &= ~(1ULL << (id & 63));
+
+			trim();
+		}
+	}
+
+	inline void add(const AssumptionSet &other) {
+		if(other.words.size() > words.size()) {
+			words.resize(other.words.size(), 0);
+		}
+
+		for(unsigned long word = 0; word < other.words.size(); word++) {
+			words[word] |= other.words[word];
+		}
+	}
+
+	// Calls f(id) for every id in the set, in increasing order
+	template<typename F>
+	inline void for_each(F f) const {
+		for(unsigned long word = 0; word < words.size(); word++) {
+			uint64_t bits = words[word];
+
+			while(bits != 0) {
+				f((word << 6) + std::countr_zero(bits));
+
+				bits &= (bits - 1);
+			}
+		}
+	}
+};
+
+#endif /* ASSUMPTION_SET_H */
@@ -3,33 +3,134 @@
 
 #include <string.h>
 
+#include <string>
+
+#include "number_pool.h"
+
 using std::string;
 
+/**
+	Tagged 8-byte number. The low byte holds the NumberFlags and the tag; the remaining 56 bits
+	hold either the value of a small integer (inline) or the identifier of an interned number.
+
+	Small integers are only inlined when their text is canonical (no sign other than a leading
+	'-' of a non-zero value, no leading zeros), so that both forms render exactly as the
+	certificate wrote them and equal texts always yield equal bits.
+*/
 struct Number {
-	char *numerator;
-	char *denominator;
+	uint64_t bits;
+
+	// Tag bit of inline integers (above the NumberFlags)
+	constexpr static uint64_t INLINE_TAG = 32;
+	constexpr static uint64_t FLAG_MASK = 31;
+
+	constexpr static unsigned int PAYLOAD_SHIFT = 8;
+
+	// Integers with at most 16 digits always fit in the 56-bit payload
+	constexpr static size_t MAXIMUM_INLINE_DIGITS = 16;
 
-	bool is_integral;
-	bool is_positive_infinity;
-	bool is_negative_infinity;
+	Number(): bits{INLINE_TAG | NumberZero | NumberIntegral} {}
 
-	Number(): numerator{"0"}, denominator{"1"}, is_integral{true}, is_positive_infinity{false}, is_negative_infinity{false} {}
+	explicit Number(const char *text): Number(from_text(text, strlen(text))) {}
 
-	Number(char *integral): numerator{integral}, denominator{"1"}, is_integral(true), is_positive_infinity{false}, is_negative_infinity{false} {}
-	Number(char *numerator, char *denominator): numerator{numerator}, denominator{denominator}, is_integral(false), is_positive_infinity{false}, is_negative_infinity{false} {}
+	static inline Number from_bits(uint64_t bits) {
+		Number result;
 
-	inline string get_string() noexcept {
-		if(is_integral) {
-			return string(numerator);
+		result.bits = bits;
+
+		return result;
+	}
+
+	// Inlines canonical small integers and interns everything else
+	static inline Number from_text(const char *text, size_t length) {
+		size_t start = (length > 0 && text[0] == '-');
+		size_t digits = length - start;
+
+		if(digits == 0 || digits > MAXIMUM_INLINE_DIGITS || (text[start] == '0' && (digits > 1 || start == 1))) {
+			return from_pool(number_pool.intern(text, length));
 		}
-		else {
-			return string(numerator) + "/" + string(denominator);
+
+		int64_t value = 0;
+
+		for(size_t i = start; i < length; i++) {
+			unsigned int digit = static_cast<unsigned char>(text[i]) - '0';
+
+			if(digit > 9) {
+				return from_pool(number_pool.intern(text, length));
+			}
+
+			value = 10 * value + digit;
 		}
+
+		return from_integer(start == 1 ? -value : value);
+	}
+
+	// The magnitude of value must have at most MAXIMUM_INLINE_DIGITS digits
+	static inline Number from_integer(int64_t value) {
+		uint64_t flags = INLINE_TAG | NumberIntegral;
+
+		if(value == 0) {
+			flags |= NumberZero;
+		}
+
+		if(value < 0) {
+			flags |= NumberNegative;
+		}
+
+		return from_bits((static_cast<uint64_t>(value) << PAYLOAD_SHIFT) | flags);
+	}
+
+	// Copies the flags of the entry: flag tests never touch the pool
+	static inline Number from_pool(uint32_t id) {
+		NumberEntry &entry = number_pool.get(id);
+
+		if(entry.small) {
+			return from_integer(entry.small_value);
+		}
+
+		return from_bits((static_cast<uint64_t>(id) << PAYLOAD_SHIFT) | entry.flags);
+	}
+
+	inline bool is_inline() const {
+		return (bits & INLINE_TAG) != 0;
+	}
+
+	inline int64_t get_inline_value() const {
+		return static_cast<int64_t>(bits) >> PAYLOAD_SHIFT;
+	}
+
+	// Only for numbers that are not inline
+	inline NumberEntry &get_entry() const {
+		return number_pool.get(static_cast<uint32_t>(bits >> PAYLOAD_SHIFT));
+	}
+
+	inline string get_string() const noexcept {
+		if(is_inline()) {
+			return std::to_string(get_inline_value());
+		}
+
+		return string(get_entry().text);
+	}
+
+	inline bool is_zero() const {
+		return (bits & NumberZero) != 0;
+	}
+
+	inline bool is_negative() const {
+		return (bits & NumberNegative) != 0;
+	}
+
+	inline bool is_integral() const {
+		return (bits & NumberIntegral) != 0;
+	}
+
+	inline bool is_positive_infinity() const {
+		return (bits & NumberPositiveInfinity) != 0;
 	}
 
-	inline bool is_zero() {
-		return (strcmp(numerator, "0") == 0);
+	inline bool is_negative_infinity() const {
+		return (bits & NumberNegativeInfinity) != 0;
 	}
 };
 
-#endif /* BASIC_TYPES_H */
\ No newline at end of file
+#endif /* BASIC_TYPES_H */
@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "file_helper.h"
+#include "smt_operators.h"
+
+using std::vector;
+
+FileHelper file_helper;
+
+// Nodes of the emitted stream: an operator applied to two integers
+struct Node {
+	int op;
+	int64_t operands[2];
+};
+
+double measure(const char *name, const vector<Node> &nodes, void (*emit)(const Node &)) {
+	file_helper.open_output("/dev/null");
+
+	auto begin = std::chrono::high_resolution_clock::now();
+
+	for(const Node &node: nodes) {
+		emit(node);
+	}
+
+	size_t bytes = file_helper.get_output_position();
+
+	file_helper.close_output();
+
+	double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+
+	fprintf(stdout, "%-44s %8.3lf GB/s (%lu bytes)\n", name, bytes / (elapsed * 1e9), bytes);
+
+	return elapsed;
+}
+
+// Before: separate writes for "(", the name (with strlen) and " ", and snprintf for integers
+
+void write_integer_snprintf(int64_t value) {
+	char buffer[MAXIMUM_INTEGER_LENGTH];
+
+	if(value < 0) {
+		snprintf(buffer, MAXIMUM_INTEGER_LENGTH, "(- %lu)", -static_cast<uint64_t>(value));
+	}
+	else {
+		snprintf(buffer, MAXIMUM_INTEGER_LENGTH, "%ld", value);
+	}
+
+	file_helper.write_output(buffer);
+}
+
+void emit_separate(const Node &node) {
+	file_helper.write_output("(");
+	file_helper.write_output(OP_STRINGS[node.op]);
+	file_helper.write_output(" ");
+
+	write_integer_snprintf(node.operands[0]);
+	file_helper.write_output(" ");
+	write_integer_snprintf(node.operands[1]);
+
+	file_helper.write_output(")");
+}
+
+// After: one write per prefix, and integers formatted by digit pairs
+
+void write_integer_pairs(int64_t value) {
+	char buffer[MAXIMUM_INTEGER_LENGTH];
+
+	char *end = buffer + MAXIMUM_INTEGER_LENGTH;
+	char *output = format_smt_integer(value, end);
+
+	file_helper.write_output(output, end - output);
+}
+
+void emit_fused(const Node &node) {
+	file_helper.write_output(OP_PREFIXES[node.op].text, OP_PREFIXES[node.op].length);
+
+	write_integer_pairs(node.operands[0]);
+	file_helper.write_output(" ", 1);
+	write_integer_pairs(node.operands[1]);
+
+	file_helper.write_output(")", 1);
+}
+
+int main(int argc, char **argv) {
+	unsigned long number_nodes = (argc > 1 ? atol(argv[1]) : 20000000);
+
+	std::mt19937_64 generator(42);
+
+	// Mostly small coefficients, as in certificates, with some 12-digit ones
+	auto random_operand = [&] () -> int64_t {
+		int64_t magnitude = (generator() % 8 == 0 ? 1000000000000L : 100);
+
+		return static_cast<int64_t>(generator() % (2 * magnitude + 1)) - magnitude;
+	};
+
+	vector<Node> nodes(number_nodes);
+
+	for(Node &node: nodes) {
+		node.op = generator() % NUMBER_OPERATORS;
+		node.operands[0] = random_operand();
+		node.operands[1] = random_operand();
+	}
+
+	fprintf(stdout, "%lu nodes, one core\n", number_nodes);
+
+	double separate = measure("separate writes, snprintf", nodes, emit_separate);
+	double fused = measure("fused prefixes, digit pairs", nodes, emit_fused);
+
+	fprintf(stdout, "Speedup: %.2lfx\n", separate / fused);
+
+	return EXIT_SUCCESS;
+}
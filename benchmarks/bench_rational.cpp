@@ -0,0 +1,174 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rational.h"
+
+using std::string;
+using std::vector;
+
+// Keeps results alive so that the measured loops are not optimized away
+static volatile int sink;
+
+template<typename F>
+double measure(const char *name, unsigned long operations, F &&function) {
+	auto begin = std::chrono::high_resolution_clock::now();
+
+	function();
+
+	double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+
+	fprintf(stdout, "%-44s %12.1lf ns/op\n", name, (elapsed * 1e9) / operations);
+
+	return elapsed;
+}
+
+string random_digits(std::mt19937_64 &generator, size_t length) {
+	string result(1, '1' + generator() % 9);
+
+	for(size_t i = 1; i < length; i++) {
+		result += static_cast<char>('0' + generator() % 10);
+	}
+
+	return result;
+}
+
+vector<uint64_t> random_limbs(std::mt19937_64 &generator, size_t length) {
+	vector<uint64_t> result(length);
+
+	for(auto &limb: result) {
+		limb = generator();
+	}
+
+	result.back() |= 1;
+
+	return result;
+}
+
+int main(int argc, char **argv) {
+	unsigned long repetitions = (argc > 1 ? atol(argv[1]) : 1000000);
+
+	std::mt19937_64 generator(42);
+
+	// Inline int64 path: sparse dot products with small integral coefficients
+
+	vector<Rational> small_coefficients;
+	vector<Rational> small_values;
+
+	for(unsigned long i = 0; i < 1024; i++) {
+		small_coefficients.emplace_back(static_cast<int64_t>(generator() % 2001) - 1000);
+		small_values.emplace_back(static_cast<int64_t>(generator() % 2001) - 1000);
+	}
+
+	measure("integral multiply-add (int64 path)", repetitions, [&] {
+		Rational sum;
+
+		for(unsigned long i = 0; i < repetitions; i++) {
+			sum += small_coefficients[i % 1024] * small_values[(i * 7) % 1024];
+		}
+
+		sink = sum.sign();
+	});
+
+	// Fractional path: gcd normalization on every operation
+
+	vector<Rational> fractions;
+
+	for(unsigned long i = 0; i < 1024; i++) {
+		fractions.emplace_back(Integer(static_cast<int64_t>(generator() % 2001) - 1000), Integer(static_cast<int64_t>(generator() % 64) + 1));
+	}
+
+	measure("fractional multiply-add", repetitions / 4, [&] {
+		Rational sum;
+
+		for(unsigned long i = 0; i < repetitions / 4; i++) {
+			sum += fractions[i % 1024] * fractions[(i * 7) % 1024];
+		}
+
+		sink = sum.sign();
+	});
+
+	// Overflow into limbs
+
+	measure("overflowing multiply (2^62 * 2^62)", repetitions / 4, [&] {
+		Integer factor(static_cast<int64_t>(1) << 62);
+
+		for(unsigned long i = 0; i < repetitions / 4; i++) {
+			sink = (factor * factor).sign();
+		}
+	});
+
+	// Schoolbook against Karatsuba (also checks that they agree)
+
+	for(size_t limbs: { 16, 64, 256, 1024 }) {
+		vector<uint64_t> a = random_limbs(generator, limbs);
+		vector<uint64_t> b = random_limbs(generator, limbs);
+
+		unsigned long operations = std::max(1UL, repetitions / (limbs * limbs));
+
+		vector<uint64_t> schoolbook;
+		vector<uint64_t> karatsuba;
+
+		char name[64];
+
+		snprintf(name, sizeof(name), "schoolbook multiply (%zu limbs)", limbs);
+		measure(name, operations, [&] {
+			for(unsigned long i = 0; i < operations; i++) {
+				schoolbook = Integer::multiply_schoolbook(a, b);
+			}
+		});
+
+		snprintf(name, sizeof(name), "karatsuba multiply (%zu limbs)", limbs);
+		measure(name, operations, [&] {
+			for(unsigned long i = 0; i < operations; i++) {
+				karatsuba = Integer::multiply_karatsuba(a, b);
+			}
+		});
+
+		if(schoolbook != karatsuba) {
+			fprintf(stderr, "Karatsuba and schoolbook products differ (%zu limbs)\n", limbs);
+
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Parse-time conversion of long decimal tokens
+
+	for(size_t digits: { 18, 100, 1000, 5000 }) {
+		string numerator = random_digits(generator, digits);
+		string text = numerator + "/" + random_digits(generator, digits / 2 + 1);
+
+		unsigned long operations = std::max(1UL, repetitions / (digits * 4));
+
+		char name[64];
+
+		snprintf(name, sizeof(name), "parse rational (%zu-digit numerator)", digits);
+		measure(name, operations, [&] {
+			for(unsigned long i = 0; i < operations; i++) {
+				sink = Rational::parse(text.c_str(), text.size()).sign();
+			}
+		});
+
+		if(Integer::parse(numerator.c_str()).to_string() != numerator) {
+			fprintf(stderr, "Decimal round trip failed (%zu digits)\n", digits);
+
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Exact floor/ceil of long fractions (RND derivations)
+
+	Rational long_fraction = Rational::parse((random_digits(generator, 400) + "/" + random_digits(generator, 200)).c_str(), 601);
+
+	measure("floor + ceil (400/200 digits)", repetitions / 100, [&] {
+		for(unsigned long i = 0; i < repetitions / 100; i++) {
+			sink = long_fraction.floor().sign() + long_fraction.ceil().sign();
+		}
+	});
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sparse_dot.h"
+
+using std::string;
+using std::vector;
+
+// Keeps results alive so that the measured loops are not optimized away
+static volatile int sink;
+
+// Rows in compressed sparse form, as in the ConstraintStore
+struct Rows {
+	vector<unsigned long> offsets;
+	vector<unsigned long> indexes;
+	vector<Number> coefficients;
+};
+
+template<typename F>
+double measure(const char *name, unsigned long nonzeros, F &&function) {
+	auto begin = std::chrono::high_resolution_clock::now();
+
+	function();
+
+	double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+
+	fprintf(stdout, "%-52s %10.1lf M nonzeros/s\n", name, nonzeros / (elapsed * 1e6));
+
+	return elapsed;
+}
+
+Number random_integer(std::mt19937_64 &generator, int64_t magnitude) {
+	return Number::from_integer(static_cast<int64_t>(generator() % (2 * magnitude + 1)) - magnitude);
+}
+
+Number random_fraction(std::mt19937_64 &generator) {
+	string text = std::to_string(static_cast<int64_t>(generator() % 2001) - 1000) + "/" + std::to_string(generator() % 63 + 2);
+
+	return Number(text.c_str());
+}
+
+/**
+	Random rows over a dense vector of the given number of columns.
+
+	@param magnitude Bound on the magnitude of the integral coefficients
+	@param fraction_probability Probability of a fractional coefficient
+*/
+Rows random_rows(std::mt19937_64 &generator, unsigned long number_rows, unsigned long columns, unsigned long row_length, int64_t magnitude, double fraction_probability) {
+	Rows result;
+
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	result.offsets.emplace_back(0);
+
+	for(unsigned long row = 0; row < number_rows; row++) {
+		unsigned long length = row_length / 2 + generator() % row_length;
+
+		vector<unsigned long> indexes;
+
+		for(unsigned long k = 0; k < length; k++) {
+			indexes.emplace_back(generator() % columns);
+		}
+
+		std::sort(indexes.begin(), indexes.end());
+		indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
+		for(unsigned long index: indexes) {
+			result.indexes.emplace_back(index);
+			result.coefficients.emplace_back(uniform(generator) < fraction_probability ? random_fraction(generator) : random_integer(generator, magnitude));
+		}
+
+		result.offsets.emplace_back(result.indexes.size());
+	}
+
+	return result;
+}
+
+// Times the kernel (with fallback) against the scalar exact path, and checks that they agree
+bool compare(const char *name, Rows &rows, vector<Number> &values) {
+	unsigned long number_rows = rows.offsets.size() - 1;
+	unsigned long nonzeros = rows.indexes.size();
+
+	vector<Rational> kernel(number_rows);
+	vector<Rational> exact(number_rows);
+
+	char label[96];
+
+	snprintf(label, sizeof(label), "%s: kernel", name);
+	measure(label, nonzeros, [&] {
+		for(unsigned long row = 0; row < number_rows; row++) {
+			unsigned long start = rows.offsets[row];
+
+			kernel[row] = sparse_dot(&rows.indexes[start], &rows.coefficients[start], rows.offsets[row + 1] - start, values.data());
+		}
+
+		sink = kernel[0].sign();
+	});
+
+	snprintf(label, sizeof(label), "%s: scalar exact", name);
+	measure(label, nonzeros, [&] {
+		for(unsigned long row = 0; row < number_rows; row++) {
+			unsigned long start = rows.offsets[row];
+
+			exact[row] = sparse_dot_exact(&rows.indexes[start], &rows.coefficients[start], rows.offsets[row + 1] - start, values.data());
+		}
+
+		sink = exact[0].sign();
+	});
+
+	if(kernel != exact) {
+		fprintf(stderr, "Kernel and exact dot products differ (%s)\n", name);
+
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char **argv) {
+	unsigned long number_rows = (argc > 1 ? atol(argv[1]) : 100000);
+
+	constexpr unsigned long COLUMNS = 100000;
+
+	std::mt19937_64 generator(42);
+
+	// Dense vectors: small integers (AVX2 lanes), 16-digit integers (128-bit scalar terms)
+
+	vector<Number> small_values;
+	vector<Number> large_values;
+
+	for(unsigned long i = 0; i < COLUMNS; i++) {
+		small_values.emplace_back(random_integer(generator, 1000));
+		large_values.emplace_back(random_integer(generator, 9999999999999999L));
+	}
+
+	Rows small_rows = random_rows(generator, number_rows, COLUMNS, 32, 1000, 0.0);
+	Rows large_rows = random_rows(generator, number_rows, COLUMNS, 32, 9999999999999999L, 0.0);
+	Rows fractional_rows = random_rows(generator, number_rows, COLUMNS, 32, 1000, 0.01);
+
+	fprintf(stdout, "%lu rows, %lu columns\n", number_rows, COLUMNS);
+
+	bool agree = true;
+
+	agree &= compare("small integers", small_rows, small_values);
+	agree &= compare("16-digit integers", large_rows, large_values);
+	agree &= compare("1% fractional coefficients", fractional_rows, small_values);
+
+	return (agree ? EXIT_SUCCESS : EXIT_FAILURE);
+}
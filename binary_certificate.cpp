@@ -0,0 +1,528 @@
+#include "binary_certificate.h"
+
+#include <string_view>
+#include <unordered_map>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+#include "file_helper.h"
+
+using std::string_view;
+using std::unordered_map;
+
+/////////////
+// Writing //
+/////////////
+
+struct BinaryCertificateWriter {
+	vector<char> string_table;
+	unordered_map<string_view, uint64_t> string_offsets;
+
+	// Number table: string offsets of the texts, and positions by tagged number
+	vector<uint64_t> numbers;
+	unordered_map<uint64_t, uint32_t> number_positions;
+
+	uint64_t add_string(const char *value) {
+		string_view key(value);
+
+		auto iterator = string_offsets.find(key);
+
+		if(iterator != string_offsets.end()) {
+			return iterator->second;
+		}
+
+		uint64_t offset = string_table.size();
+
+		string_table.insert(string_table.end(), value, value + key.size() + 1);
+		string_offsets.emplace(key, offset);
+
+		return offset;
+	}
+
+	uint32_t add_number(Number &number) {
+		auto iterator = number_positions.find(number.bits);
+
+		if(iterator != number_positions.end()) {
+			return iterator->second;
+		}
+
+		uint32_t position = numbers.size();
+
+		if(number.is_inline()) {
+			// Rendered text has no stable address: appended as is (numbers are deduplicated above)
+			string text = number.get_string();
+
+			numbers.push_back(string_table.size());
+			string_table.insert(string_table.end(), text.c_str(), text.c_str() + text.size() + 1);
+		}
+		else {
+			numbers.push_back(add_string(number.get_entry().text));
+		}
+
+		number_positions.emplace(number.bits, position);
+
+		return position;
+	}
+
+	void add_entries(vector<Number> &numbers, vector<BinaryEntry> &entries) {
+		for(unsigned long i = 0; i < numbers.size(); i++) {
+			if(numbers[i].is_zero()) {
+				continue;
+			}
+
+			entries.push_back(BinaryEntry{i, add_number(numbers[i]), 0});
+		}
+	}
+};
+
+// Appends an array to the file, padded to the next 8-byte boundary, and returns its offset
+template<typename T>
+uint64_t write_array(FileHelper &file_helper, uint64_t &position, const T *data, size_t length) {
+	constexpr char padding[8] = { 0 };
+
+	uint64_t offset = position;
+	size_t bytes = length * sizeof(T);
+
+	file_helper.write_output(reinterpret_cast<const char *>(data), bytes);
+	position += bytes;
+
+	if(position % 8 != 0) {
+		file_helper.write_output(padding, 8 - (position % 8));
+		position += 8 - (position % 8);
+	}
+
+	return offset;
+}
+
+/**
+	Writes a parsed certificate in the binary format.
+
+	@param certificate Parsed certificate (before precomputation)
+	@param filename Name of the binary certificate file
+*/
+void write_binary_certificate(Certificate &certificate, const char *filename) {
+	BinaryCertificateWriter writer;
+
+	BinaryHeader header;
+	memset(&header, 0, sizeof(BinaryHeader));
+
+	memcpy(header.magic, BINARY_CERTIFICATE_MAGIC, sizeof(header.magic));
+	header.version = BINARY_CERTIFICATE_VERSION;
+	header.byte_order = BINARY_CERTIFICATE_BYTE_ORDER;
+
+	header.feasible = certificate.feasible;
+	header.minimization = certificate.minimization;
+
+	if(certificate.feasible) {
+		header.feasible_lower_bound = writer.add_number(certificate.feasible_lower_bound);
+		header.feasible_upper_bound = writer.add_number(certificate.feasible_upper_bound);
+	}
+
+	header.number_variables = certificate.number_variables;
+	header.number_integral_variables = certificate.number_integral_variables;
+	header.number_problem_constraints = certificate.number_problem_constraints;
+	header.number_derived_constraints = certificate.number_derived_constraints;
+	header.number_solutions = certificate.number_solutions;
+
+	// VAR and INT
+
+	vector<uint64_t> variable_names;
+	vector<uint8_t> variable_integral_flags;
+
+	for(unsigned long i = 0; i < certificate.number_variables; i++) {
+		variable_names.push_back(writer.add_string(certificate.variable_names[i]));
+		variable_integral_flags.push_back(certificate.variable_integral_flags[i] ? 1 : 0);
+	}
+
+	// OBJ
+
+	vector<BinaryEntry> objective_entries;
+
+	writer.add_entries(certificate.objective_coefficients, objective_entries);
+
+	// CON and DER constraints
+
+	vector<BinaryConstraint> constraints;
+	vector<uint64_t> coefficient_indexes;
+	vector<uint32_t> coefficient_numbers;
+
+	// Rows sharing coefficients in the store (such as OBJ rows) share them in the file
+	unordered_map<unsigned long *, uint64_t> coefficient_starts;
+
+	for(unsigned long i = 0; i < certificate.constraints.size(); i++) {
+		Constraint &constraint = certificate.constraints[i];
+
+		auto iterator = coefficient_starts.find(constraint.coefficient_indexes);
+
+		uint64_t coefficients_start = coefficient_indexes.size();
+
+		if(constraint.number_coefficients != 0 && iterator != coefficient_starts.end()) {
+			coefficients_start = iterator->second;
+		}
+		else {
+			// Empty rows may alias the storage of the next row
+			if(constraint.number_coefficients != 0) {
+				coefficient_starts.emplace(constraint.coefficient_indexes, coefficients_start);
+			}
+
+			for(unsigned long j = 0; j < constraint.number_coefficients; j++) {
+				coefficient_indexes.push_back(constraint.coefficient_indexes[j]);
+				coefficient_numbers.push_back(writer.add_number(constraint.coefficient_numbers[j]));
+			}
+		}
+
+		constraints.push_back(BinaryConstraint{writer.add_string(certificate.constraints.get_name(i)), coefficients_start, constraint.number_coefficients, static_cast<uint32_t>(constraint.direction), writer.add_number(constraint.target)});
+	}
+
+	// SOL
+
+	vector<BinarySolution> solutions;
+	vector<BinaryEntry> solution_entries;
+
+	for(auto &solution: certificate.solutions) {
+		uint64_t entries_start = solution_entries.size();
+
+		writer.add_entries(solution.assignments, solution_entries);
+
+		solutions.push_back(BinarySolution{writer.add_string(solution.name), entries_start, solution_entries.size() - entries_start});
+	}
+
+	// DER reasons
+
+	vector<BinaryDerivation> derivations;
+	vector<uint64_t> reason_indexes;
+	vector<uint32_t> reason_multipliers;
+
+	for(auto &derivation: certificate.derivations) {
+		Reason &reason = derivation.reason;
+
+		derivations.push_back(BinaryDerivation{derivation.constraint_index, derivation.largest_index, static_cast<uint32_t>(reason.type), 0, reason_indexes.size(), reason.constraint_indexes.size(), reason_multipliers.size(), reason.constraint_multipliers.size()});
+
+		for(auto &index: reason.constraint_indexes) {
+			reason_indexes.push_back(index);
+		}
+
+		for(auto &multiplier: reason.constraint_multipliers) {
+			reason_multipliers.push_back(writer.add_number(multiplier));
+		}
+	}
+
+	header.number_numbers = writer.numbers.size();
+	header.number_objective_entries = objective_entries.size();
+	header.number_coefficients = coefficient_indexes.size();
+	header.number_solution_entries = solution_entries.size();
+	header.number_reason_indexes = reason_indexes.size();
+	header.number_reason_multipliers = reason_multipliers.size();
+	header.string_table_length = writer.string_table.size();
+
+	// Offsets are assigned in writing order, so the header is written last (over its placeholder)
+
+	FileHelper file_helper;
+	file_helper.open_output(filename);
+
+	uint64_t position = 0;
+
+	write_array(file_helper, position, &header, 1);
+
+	header.numbers_offset = write_array(file_helper, position, writer.numbers.data(), writer.numbers.size());
+	header.variable_names_offset = write_array(file_helper, position, variable_names.data(), variable_names.size());
+	header.variable_integral_flags_offset = write_array(file_helper, position, variable_integral_flags.data(), variable_integral_flags.size());
+	header.objective_entries_offset = write_array(file_helper, position, objective_entries.data(), objective_entries.size());
+	header.constraints_offset = write_array(file_helper, position, constraints.data(), constraints.size());
+	header.coefficient_indexes_offset = write_array(file_helper, position, coefficient_indexes.data(), coefficient_indexes.size());
+	header.coefficient_numbers_offset = write_array(file_helper, position, coefficient_numbers.data(), coefficient_numbers.size());
+	header.solutions_offset = write_array(file_helper, position, solutions.data(), solutions.size());
+	header.solution_entries_offset = write_array(file_helper, position, solution_entries.data(), solution_entries.size());
+	header.derivations_offset = write_array(file_helper, position, derivations.data(), derivations.size());
+	header.reason_indexes_offset = write_array(file_helper, position, reason_indexes.data(), reason_indexes.size());
+	header.reason_multipliers_offset = write_array(file_helper, position, reason_multipliers.data(), reason_multipliers.size());
+	header.string_table_offset = write_array(file_helper, position, writer.string_table.data(), writer.string_table.size());
+
+	header.file_length = position;
+
+	file_helper.close_output();
+
+	int fd = open(filename, O_WRONLY);
+
+	if(fd == -1 || pwrite(fd, &header, sizeof(BinaryHeader), 0) != sizeof(BinaryHeader)) {
+		throw runtime_error(format("Error writing header of {}\n", filename));
+	}
+
+	close(fd);
+}
+
+/////////////
+// Reading //
+/////////////
+
+/**
+	Checks the magic bytes of a file.
+
+	@param filename Name of the file
+	@return True if the file starts with the binary certificate magic bytes
+*/
+bool BinaryCertificateReader::is_binary_certificate(const char *filename) {
+	char magic[sizeof(BINARY_CERTIFICATE_MAGIC)];
+
+	int fd = open(filename, O_RDONLY);
+
+	if(fd == -1) {
+		return false;
+	}
+
+	bool result = (pread(fd, magic, sizeof(magic), 0) == sizeof(magic) && memcmp(magic, BINARY_CERTIFICATE_MAGIC, sizeof(magic)) == 0);
+
+	close(fd);
+
+	return result;
+}
+
+/**
+	Maps a binary certificate and validates its header.
+
+	@param filename Name of the binary certificate file
+*/
+BinaryCertificateReader::BinaryCertificateReader(const char *filename): mapping{nullptr}, mapping_length{0}, header{nullptr} {
+	int fd = open(filename, O_RDONLY);
+
+	if(fd == -1) {
+		throw runtime_error(format("Error opening {}\n", filename));
+	}
+
+	struct stat input_stat;
+
+	if(fstat(fd, &input_stat) == -1 || input_stat.st_size < static_cast<off_t>(sizeof(BinaryHeader))) {
+		close(fd);
+
+		throw runtime_error(format("Error in binary certificate {}: truncated header\n", filename));
+	}
+
+	mapping_length = input_stat.st_size;
+
+	void *result = mmap(nullptr, mapping_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+
+	close(fd);
+
+	if(result == MAP_FAILED) {
+		throw runtime_error(format("Error mapping {}\n", filename));
+	}
+
+	mapping = static_cast<char *>(result);
+	header = reinterpret_cast<BinaryHeader *>(mapping);
+
+	if(header->byte_order != BINARY_CERTIFICATE_BYTE_ORDER) {
+		throw runtime_error(format("Error in binary certificate {}: written on a machine with another byte order\n", filename));
+	}
+
+	if(header->version != BINARY_CERTIFICATE_VERSION) {
+		throw runtime_error(format("Error in binary certificate {}: unsupported version {}\n", filename, header->version));
+	}
+
+	if(header->file_length != mapping_length) {
+		throw runtime_error(format("Error in binary certificate {}: expected {} bytes, found {}\n", filename, header->file_length, mapping_length));
+	}
+
+	char *string_table = get_array<char>(header->string_table_offset, header->string_table_length);
+
+	// Every string offset below the table length is then '\0'-terminated inside the mapping
+	if(header->string_table_length != 0 && string_table[header->string_table_length - 1] != '\0') {
+		throw runtime_error(format("Error in binary certificate {}: unterminated string table\n", filename));
+	}
+
+	// The only text processing: each distinct number is converted (or interned) once
+	uint64_t *numbers = get_array<uint64_t>(header->numbers_offset, header->number_numbers);
+
+	number_values.reserve(header->number_numbers);
+
+	for(uint64_t i = 0; i < header->number_numbers; i++) {
+		char *text = get_string(numbers[i]);
+
+		number_values.emplace_back(Number::from_text(text, strlen(text)));
+	}
+}
+
+BinaryCertificateReader::~BinaryCertificateReader() {
+	if(mapping != nullptr) {
+		munmap(mapping, mapping_length);
+	}
+}
+
+char *BinaryCertificateReader::get_string(uint64_t offset) {
+	if(offset >= header->string_table_length) {
+		throw runtime_error(format("Error in binary certificate: string offset {} out of bounds\n", offset));
+	}
+
+	return mapping + header->string_table_offset + offset;
+}
+
+Number BinaryCertificateReader::get_number(uint32_t number) {
+	if(number >= number_values.size()) {
+		throw runtime_error(format("Error in binary certificate: number {} out of bounds\n", number));
+	}
+
+	return number_values[number];
+}
+
+void BinaryCertificateReader::check_range(uint64_t start, uint64_t length, uint64_t limit, const char *description) {
+	if(start > limit || length > limit - start) {
+		throw runtime_error(format("Error in binary certificate: {} range out of bounds\n", description));
+	}
+}
+
+/**
+	Fills a certificate from the mapped file. Strings are not copied: the reader must
+	outlive the certificate.
+
+	@param certificate Empty certificate
+*/
+void BinaryCertificateReader::read(Certificate &certificate) {
+	uint64_t number_constraints = header->number_problem_constraints + header->number_derived_constraints;
+
+	if(number_constraints < header->number_problem_constraints) {
+		throw runtime_error(format("Error in binary certificate: invalid number of constraints\n"));
+	}
+
+	uint64_t *variable_names = get_array<uint64_t>(header->variable_names_offset, header->number_variables);
+	uint8_t *variable_integral_flags = get_array<uint8_t>(header->variable_integral_flags_offset, header->number_variables);
+	BinaryEntry *objective_entries = get_array<BinaryEntry>(header->objective_entries_offset, header->number_objective_entries);
+	BinaryConstraint *constraints = get_array<BinaryConstraint>(header->constraints_offset, number_constraints);
+	uint64_t *coefficient_indexes = get_array<uint64_t>(header->coefficient_indexes_offset, header->number_coefficients);
+	uint32_t *coefficient_numbers = get_array<uint32_t>(header->coefficient_numbers_offset, header->number_coefficients);
+	BinarySolution *solutions = get_array<BinarySolution>(header->solutions_offset, header->number_solutions);
+	BinaryEntry *solution_entries = get_array<BinaryEntry>(header->solution_entries_offset, header->number_solution_entries);
+	BinaryDerivation *derivations = get_array<BinaryDerivation>(header->derivations_offset, header->number_derived_constraints);
+	uint64_t *reason_indexes = get_array<uint64_t>(header->reason_indexes_offset, header->number_reason_indexes);
+	uint32_t *reason_multipliers = get_array<uint32_t>(header->reason_multipliers_offset, header->number_reason_multipliers);
+
+	certificate.feasible = header->feasible;
+	certificate.minimization = header->minimization;
+
+	if(certificate.feasible) {
+		certificate.feasible_lower_bound = get_number(header->feasible_lower_bound);
+		certificate.feasible_upper_bound = get_number(header->feasible_upper_bound);
+	}
+
+	certificate.number_variables = header->number_variables;
+	certificate.number_integral_variables = header->number_integral_variables;
+	certificate.number_problem_constraints = header->number_problem_constraints;
+	certificate.number_derived_constraints = header->number_derived_constraints;
+	certificate.number_solutions = header->number_solutions;
+
+	// VAR and INT
+
+	certificate.variable_names.reserve(certificate.number_variables);
+	certificate.variable_integral_flags.resize(certificate.number_variables);
+
+	for(unsigned long i = 0; i < certificate.number_variables; i++) {
+		certificate.variable_names.emplace_back(get_string(variable_names[i]));
+		certificate.variable_integral_flags[i] = (variable_integral_flags[i] != 0);
+	}
+
+	// OBJ
+
+	certificate.objective_coefficients.resize(certificate.number_variables);
+
+	for(unsigned long i = 0; i < header->number_objective_entries; i++) {
+		check_range(objective_entries[i].index, 1, certificate.number_variables, "objective entry");
+
+		certificate.objective_coefficients[objective_entries[i].index] = get_number(objective_entries[i].number);
+	}
+
+	// CON and DER constraints
+
+	certificate.constraints.reserve(number_constraints);
+
+	// Rows that share a coefficient range in the file share it in the store
+	unordered_map<uint64_t, unsigned long> shared_rows;
+
+	vector<unsigned long> indexes;
+	vector<Number> numbers;
+
+	for(unsigned long i = 0; i < number_constraints; i++) {
+		BinaryConstraint &constraint = constraints[i];
+
+		check_range(constraint.coefficients_start, constraint.number_coefficients, header->number_coefficients, "constraint coefficient");
+
+		if(constraint.direction > Direction::GreaterEqual) {
+			throw runtime_error(format("Error in binary certificate: invalid direction in constraint {}\n", i));
+		}
+
+		auto iterator = shared_rows.find(constraint.coefficients_start);
+
+		if(constraint.number_coefficients != 0 && iterator != shared_rows.end() && certificate.constraints[iterator->second].number_coefficients == constraint.number_coefficients) {
+			certificate.constraints.add_shared(get_string(constraint.name), certificate.constraints[iterator->second], static_cast<Direction>(constraint.direction), get_number(constraint.target));
+			continue;
+		}
+
+		if(constraint.number_coefficients != 0) {
+			shared_rows.emplace(constraint.coefficients_start, i);
+		}
+
+		indexes.assign(coefficient_indexes + constraint.coefficients_start, coefficient_indexes + constraint.coefficients_start + constraint.number_coefficients);
+
+		numbers.clear();
+
+		for(unsigned long j = 0; j < constraint.number_coefficients; j++) {
+			numbers.emplace_back(get_number(coefficient_numbers[constraint.coefficients_start + j]));
+		}
+
+		certificate.constraints.add(get_string(constraint.name), indexes, numbers, static_cast<Direction>(constraint.direction), get_number(constraint.target));
+	}
+
+	// SOL
+
+	certificate.solutions.reserve(certificate.number_solutions);
+
+	for(unsigned long i = 0; i < certificate.number_solutions; i++) {
+		BinarySolution &solution = solutions[i];
+
+		check_range(solution.entries_start, solution.number_entries, header->number_solution_entries, "solution entry");
+
+		vector<Number> assignments;
+		assignments.resize(certificate.number_variables);
+
+		for(unsigned long j = solution.entries_start; j < solution.entries_start + solution.number_entries; j++) {
+			check_range(solution_entries[j].index, 1, certificate.number_variables, "solution entry");
+
+			assignments[solution_entries[j].index] = get_number(solution_entries[j].number);
+		}
+
+		certificate.solutions.emplace_back(Solution(get_string(solution.name), assignments));
+	}
+
+	// DER reasons
+
+	certificate.derivations.reserve(certificate.number_derived_constraints);
+
+	for(unsigned long i = 0; i < certificate.number_derived_constraints; i++) {
+		BinaryDerivation &derivation = derivations[i];
+
+		check_range(derivation.indexes_start, derivation.number_indexes, header->number_reason_indexes, "reason index");
+		check_range(derivation.multipliers_start, derivation.number_multipliers, header->number_reason_multipliers, "reason multiplier");
+
+		if(derivation.type > ReasonType::TypeSOL || derivation.constraint_index >= number_constraints) {
+			throw runtime_error(format("Error in binary certificate: invalid derivation {}\n", i));
+		}
+
+		// UNS reasons are accessed by position (i1, l1, i2, l2)
+		if(derivation.type == ReasonType::TypeUNS && derivation.number_indexes != 4) {
+			throw runtime_error(format("Error in binary certificate: invalid unsplitting derivation {}\n", i));
+		}
+
+		indexes.assign(reason_indexes + derivation.indexes_start, reason_indexes + derivation.indexes_start + derivation.number_indexes);
+
+		numbers.clear();
+
+		for(unsigned long j = 0; j < derivation.number_multipliers; j++) {
+			numbers.emplace_back(get_number(reason_multipliers[derivation.multipliers_start + j]));
+		}
+
+		Reason reason(static_cast<ReasonType>(derivation.type), indexes, numbers);
+
+		certificate.derivations.emplace_back(Derivation(derivation.constraint_index, reason, derivation.largest_index));
+	}
+}
@@ -0,0 +1,158 @@
+#ifndef BINARY_CERTIFICATE_H
+#define BINARY_CERTIFICATE_H
+
+#include <cstdint>
+
+#include <stdexcept>
+#include <format>
+
+#include "certificate.h"
+
+using std::runtime_error;
+using std::format;
+
+// Binary certificate (.viprb) layout: a fixed header followed by flat arrays, all of them
+// 8-byte aligned and addressed by offsets from the beginning of the file. Every string
+// (names and number texts) lives once in a trailing string table and is referenced by its
+// offset; every distinct number appears once in the number table and is referenced by its
+// 32-bit position there. Loading interns each distinct number once and otherwise only
+// copies fixed-size records, never parsing a token.
+//
+//     BinaryHeader
+//     number texts                uint64_t[number_numbers] (string offsets)
+//     variable name offsets       uint64_t[number_variables]
+//     variable integral flags     uint8_t[number_variables] (padded)
+//     objective entries           BinaryEntry[number_objective_entries]
+//     constraints                 BinaryConstraint[number_problem_constraints + number_derived_constraints]
+//     coefficient indexes         uint64_t[number_coefficients]
+//     coefficient numbers         uint32_t[number_coefficients]
+//     solutions                   BinarySolution[number_solutions]
+//     solution entries            BinaryEntry[number_solution_entries]
+//     derivations                 BinaryDerivation[number_derived_constraints]
+//     reason indexes              uint64_t[number_reason_indexes]
+//     reason multipliers          uint32_t[number_reason_multipliers]
+//     string table                char[string_table_length] ('\0'-terminated strings)
+//
+// The objective and the solutions are stored sparsely (zero entries are implicit).
+
+constexpr char BINARY_CERTIFICATE_MAGIC[8] = { 'V', 'I', 'P', 'R', 'B', 'I', 'N', '\0' };
+constexpr uint32_t BINARY_CERTIFICATE_VERSION = 2;
+
+// Written in native byte order: reads back differently on a machine with another endianness
+constexpr uint32_t BINARY_CERTIFICATE_BYTE_ORDER = 0x01020304;
+
+struct BinaryEntry {
+	uint64_t index;
+	uint32_t number;
+	uint32_t padding;
+};
+
+struct BinaryConstraint {
+	uint64_t name;
+	uint64_t coefficients_start;
+	uint64_t number_coefficients;
+	uint32_t direction;
+	uint32_t target;
+};
+
+struct BinarySolution {
+	uint64_t name;
+	uint64_t entries_start;
+	uint64_t number_entries;
+};
+
+struct BinaryDerivation {
+	uint64_t constraint_index;
+	int64_t largest_index;
+	uint32_t type;
+	uint32_t padding;
+	uint64_t indexes_start;
+	uint64_t number_indexes;
+	uint64_t multipliers_start;
+	uint64_t number_multipliers;
+};
+
+struct BinaryHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+
+	uint64_t file_length;
+
+	// Certificate scalars
+	uint32_t feasible;
+	uint32_t minimization;
+
+	uint32_t feasible_lower_bound;
+	uint32_t feasible_upper_bound;
+
+	uint64_t number_variables;
+	uint64_t number_integral_variables;
+	uint64_t number_problem_constraints;
+	uint64_t number_derived_constraints;
+	uint64_t number_solutions;
+
+	// Array lengths (in elements)
+	uint64_t number_numbers;
+	uint64_t number_objective_entries;
+	uint64_t number_coefficients;
+	uint64_t number_solution_entries;
+	uint64_t number_reason_indexes;
+	uint64_t number_reason_multipliers;
+	uint64_t string_table_length;
+
+	// Array offsets (in bytes, from the beginning of the file)
+	uint64_t numbers_offset;
+	uint64_t variable_names_offset;
+	uint64_t variable_integral_flags_offset;
+	uint64_t objective_entries_offset;
+	uint64_t constraints_offset;
+	uint64_t coefficient_indexes_offset;
+	uint64_t coefficient_numbers_offset;
+	uint64_t solutions_offset;
+	uint64_t solution_entries_offset;
+	uint64_t derivations_offset;
+	uint64_t reason_indexes_offset;
+	uint64_t reason_multipliers_offset;
+	uint64_t string_table_offset;
+};
+
+// Writes a parsed certificate in the binary format
+void write_binary_certificate(Certificate &certificate, const char *filename);
+
+class BinaryCertificateReader {
+	// Private (copy-on-write) mapping of the whole file: certificate strings point into it
+	char *mapping;
+	size_t mapping_length;
+
+	BinaryHeader *header;
+
+	// Numbers of the number table
+	vector<Number> number_values;
+
+public:
+	BinaryCertificateReader(const char *filename);
+	virtual ~BinaryCertificateReader();
+
+	// Checks the magic bytes of a file
+	static bool is_binary_certificate(const char *filename);
+
+	// Fills a certificate (the reader must outlive it)
+	void read(Certificate &certificate);
+
+private:
+	template<typename T>
+	T *get_array(uint64_t offset, uint64_t length) {
+		if(offset % alignof(T) != 0 || offset > mapping_length || length > (mapping_length - offset) / sizeof(T)) {
+			throw runtime_error(format("Error in binary certificate: array at offset {} out of bounds\n", offset));
+		}
+
+		return reinterpret_cast<T *>(mapping + offset);
+	}
+
+	char *get_string(uint64_t offset);
+	Number get_number(uint32_t number);
+	void check_range(uint64_t start, uint64_t length, uint64_t limit, const char *description);
+};
+
+#endif /* BINARY_CERTIFICATE_H */
@@ -1,8 +1,15 @@
 #include "certificate.h"
 
 #include "file_helper.h"
+#include "smt_operators.h"
+#include "sparse_dot.h"
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cmath>
+#include <string_view>
+#include <unordered_map>
 
 using std::string;
 
@@ -13,53 +20,19 @@ Number zero("0");
 //////////////////////////
 
 #define LAMBDA(CODE) [&]() -> void { CODE; }
-#define LITERAL(VAR) (LAMBDA(write_output(#VAR)))
-
-constexpr int OP_ASSERT = 0;
-constexpr int OP_NOT = 1;
-constexpr int OP_AND = 2;
-constexpr int OP_OR = 3;
-constexpr int OP_EQ = 4;
-constexpr int OP_NEQ = 5;
-constexpr int OP_PLUS = 6;
-constexpr int OP_MINUS = 7;
-constexpr int OP_TIMES = 8;
-constexpr int OP_DIVIDE = 9;
-constexpr int OP_LEQ = 10;
-constexpr int OP_GEQ = 11;
-constexpr int OP_L = 12;
-constexpr int OP_G = 13;
-constexpr int OP_INTEGRAL = 14;
-constexpr int OP_RND_DOWN = 15;
-constexpr int OP_ITE = 16;
-constexpr int OP_IMPLICATION = 17;
-
-constexpr const char *OP_STRINGS[] = {
-	"assert",
-	"not",
-	"and",
-	"or",
-	"=",
-	"distinct",
-	"+",
-	"-",
-	"*",
-	"/",
-	"<=",
-	">=",
-	"<",
-	">",
-	"is_int",
-	"to_int",
-	"ite",
-	"=>"
-};
+#define LITERAL(VAR) (LAMBDA(print_inline_integer(VAR)))
 
 //////////////////////////
 // Precomputation tasks //
 //////////////////////////
 
 void Certificate::precompute() {
+	precompute_variables();
+
+	calculate_dependencies();
+}
+
+void Certificate::precompute_variables() {
 	number_total_constraints = number_problem_constraints + number_derived_constraints;
 
 	for(unsigned long i = 0; i < number_variables; i++) {
@@ -69,1642 +42,3554 @@ void Certificate::precompute() {
 		else {
 			variable_non_integral_vector.push_back(i);
 		}
-	}
 
-	calculate_dependencies();
+		if(!objective_coefficients[i].is_zero()) {
+			objective_support.push_back(i);
+		}
+	}
 }
 
 void Certificate::calculate_dependencies() {
 	dependencies.resize(number_total_constraints);
+	assumption_counts.resize(number_total_constraints, 0);
 
 	for(unsigned long i = number_problem_constraints; i < number_total_constraints; i++) {
-		dependencies[i] = new unordered_set<unsigned long>();
+		calculate_dependency(i);
+	}
+}
 
-		switch(get_derivation_from_offset(i).reason.type) {
-			case ReasonType::TypeASM:
-				dependencies[i]->insert(i);
-				break;
-			case ReasonType::TypeLIN:
-			case ReasonType::TypeRND:
-				for(unsigned long dependency_index: get_derivation_from_offset(i).reason.constraint_indexes) {
-					// If it is one of the problem constraints, there are no assumptions
-					if(dependency_index < number_problem_constraints) {
-						continue;
-					}
+void Certificate::erase_assumption(AssumptionSet &set, unsigned long constraint_index) {
+	uint32_t id = get_assumption_id(constraint_index);
 
-	 				// If the dependency has index bigger than or equal to the current one
-					if(dependency_index >= i) {
-						throw runtime_error(format("Constraint {} has dependency {} with index bigger than or equal to itself\n", i, dependency_index));
-					}
+	if(id != NO_ASSUMPTION) {
+		set.erase(id);
+	}
+}
 
-					auto &other_dependency = dependencies[dependency_index];
+void Certificate::calculate_dependency(unsigned long i) {
+	switch(get_derivation_from_offset(i).reason.type) {
+		case ReasonType::TypeASM: {
+			auto dependency = std::make_shared<AssumptionSet>();
 
-					dependencies[i]->insert(other_dependency->begin(), other_dependency->end());
+			assumption_positions.push_back(i);
+			dependency->insert(number_assumptions++);
+
+			dependencies[i] = dependency;
+			break;
+		}
+		case ReasonType::TypeLIN:
+		case ReasonType::TypeRND: {
+			// Distinct non-empty sets of the premises: a single one is shared, not copied
+			vector<const AssumptionSet *> premises;
+
+			for(unsigned long dependency_index: get_derivation_from_offset(i).reason.constraint_indexes) {
+				// If it is one of the problem constraints, there are no assumptions
+				if(dependency_index < number_problem_constraints) {
+					continue;
 				}
-				break;
-			case ReasonType::TypeUNS:
-				for(unsigned long dependency_index: get_derivation_from_offset(i).reason.constraint_indexes) {
-	 				// If the dependency has index bigger than or equal to the current one
-					if(dependency_index >= i) {
-						throw runtime_error(format("Constraint {} has dependency {} with index bigger than or equal to itself\n", i, dependency_index));
-					}
+
+ 				// If the dependency has index bigger than or equal to the current one
+				if(dependency_index >= i) {
+					throw runtime_error(format("Constraint {} has dependency {} with index bigger than or equal to itself\n", i, dependency_index));
 				}
 
-				unsigned long dependency_index1 = get_derivation_from_offset(i).reason.get_i1();
+				auto &other_dependency = dependencies[dependency_index];
 
-				if(dependency_index1 >= number_problem_constraints) {
-					auto &other_dependency1 = dependencies[dependency_index1];
-					unsigned long exclusion1 = get_derivation_from_offset(i).reason.get_l1();
+				if(other_dependency == nullptr || std::find(premises.begin(), premises.end(), other_dependency.get()) != premises.end()) {
+					continue;
+				}
 
-					dependencies[i]->insert(other_dependency1->begin(), other_dependency1->end());
-					dependencies[i]->erase(exclusion1);
+				if(premises.empty()) {
+					dependencies[i] = other_dependency;
 				}
 
-				unsigned long dependency_index2 = get_derivation_from_offset(i).reason.get_i2();
+				premises.push_back(other_dependency.get());
+			}
 
-				if(dependency_index2 >= number_problem_constraints) {
-					auto &other_dependency2 = dependencies[dependency_index2];
-					unsigned long exclusion2 = get_derivation_from_offset(i).reason.get_l2();
+			if(premises.size() > 1) {
+				auto dependency = std::make_shared<AssumptionSet>();
 
-					// Only exclude if exclusion2 was not added twice
+				for(auto premise: premises) {
+					dependency->add(*premise);
+				}
 
-					bool exclude = !(dependencies[i]->contains(exclusion2));
+				dependencies[i] = dependency;
+			}
+			break;
+		}
+		case ReasonType::TypeUNS: {
+			for(unsigned long dependency_index: get_derivation_from_offset(i).reason.constraint_indexes) {
+ 				// If the dependency has index bigger than or equal to the current one
+				if(dependency_index >= i) {
+					throw runtime_error(format("Constraint {} has dependency {} with index bigger than or equal to itself\n", i, dependency_index));
+				}
+			}
 
-					dependencies[i]->insert(other_dependency2->begin(), other_dependency2->end());
+			auto dependency = std::make_shared<AssumptionSet>();
 
-					if(exclude) {
-						dependencies[i]->erase(exclusion2);
-					}
+			unsigned long dependency_index1 = get_derivation_from_offset(i).reason.get_i1();
+
+			if(dependency_index1 >= number_problem_constraints && dependencies[dependency_index1] != nullptr) {
+				unsigned long exclusion1 = get_derivation_from_offset(i).reason.get_l1();
+
+				dependency->add(*dependencies[dependency_index1]);
+				erase_assumption(*dependency, exclusion1);
+			}
+
+			unsigned long dependency_index2 = get_derivation_from_offset(i).reason.get_i2();
+
+			if(dependency_index2 >= number_problem_constraints) {
+				unsigned long exclusion2 = get_derivation_from_offset(i).reason.get_l2();
+
+				// Only exclude if exclusion2 was not added twice
+
+				uint32_t exclusion2_id = get_assumption_id(exclusion2);
+
+				bool exclude = (exclusion2_id == NO_ASSUMPTION || !dependency->contains(exclusion2_id));
+
+				if(dependencies[dependency_index2] != nullptr) {
+					dependency->add(*dependencies[dependency_index2]);
 				}
 
-				break;
-			// case ReasonType::TypeSOL:
-				// No action
-				// break;
+				if(exclude) {
+					erase_assumption(*dependency, exclusion2);
+				}
+			}
+
+			if(!dependency->empty()) {
+				dependencies[i] = dependency;
+			}
+
+			break;
 		}
+		// case ReasonType::TypeSOL:
+			// No action
+			// break;
 	}
+
+	assumption_counts[i] = number_assumptions;
 }
 
 //////////////////////////////
 // Basic printing functions //
 //////////////////////////////
 
-// Space for the 64-bit decimal digits
-constexpr size_t BUFFER_LONG_STRING_SIZE = 32;
-
 thread_local FileHelper file_helper;
 
+// Term DAG being built by the print functions instead of text (nullptr while they print text)
+thread_local TermDag *term_dag = nullptr;
+
+// Term DAG of the derivations of a thread (with --dag)
+thread_local TermDag der_dag;
+
 inline void open_output(string filename) {
 	file_helper.open_output(filename.c_str());
 }
 
-inline void write_output(const char *message) {
-	file_helper.write_output(message);
+// String literals, with the length known at compile time
+template<size_t LENGTH>
+inline void write_output(const char (&literal)[LENGTH]) {
+	// Only separators are written directly while building a term DAG
+	if(term_dag != nullptr) {
+		return;
+	}
+
+	file_helper.write_output(literal, LENGTH - 1);
 }
 
-inline void close_output() {
-	file_helper.close_output();
+inline void write_output(const char *message, size_t length) {
+	if(term_dag != nullptr) {
+		return;
+	}
+
+	file_helper.write_output(message, length);
 }
 
-inline void print_bool(bool variable) {
-	write_output(variable ? "true" : "false");
+// Other strings (terminated by '\0')
+inline void write_string(const char *message) {
+	if(term_dag != nullptr) {
+		return;
+	}
+
+	file_helper.write_output(message, strlen(message));
 }
 
-inline void print_unsigned_long(unsigned long variable) {
-	char buffer[BUFFER_LONG_STRING_SIZE];
+// Returns the length of the file
+inline size_t close_output() {
+	size_t length = file_helper.get_output_position();
+
+	file_helper.close_output();
 
-	snprintf(buffer, BUFFER_LONG_STRING_SIZE, "%lu", variable);
-	write_output(buffer);
+	return length;
 }
 
-inline void print_integral_string(char *number) {
-	if(number[0] == '-') {
-		write_output("(- ");
-		write_output(number + 1);
-		write_output(")");
-	}
-	else {
-		write_output(number);
+//////////////////////
+// Constant folding //
+//////////////////////
+
+// Operator of atoms (booleans and numbers)
+constexpr int NO_OPERATOR = -1;
+
+enum TermKind {
+	TermOpaque,
+	TermBoolean,
+	TermInteger
+};
+
+/**
+	Term printed inside the operator being generated. Booleans and inline integers are
+	constants; anything else is opaque. Operator terms keep their operator and number of
+	operands, so that nested associative operators can be flattened.
+*/
+struct Term {
+	// Positions in the output
+	size_t start;
+	size_t end;
+
+	int op;
+	TermKind kind;
+
+	// Value of constants (0 or 1 for booleans)
+	int64_t value;
+
+	unsigned long number_operands;
+};
+
+// Operator being generated: where its text starts, and its first term in term_stack
+struct TermFrame {
+	int op;
+	size_t start;
+	size_t first_term;
+};
+
+thread_local vector<TermFrame> frame_stack;
+thread_local vector<Term> term_stack;
+
+// Off in the full model: operators are written as they are generated (set by with_encoding)
+thread_local bool folding = true;
+
+inline size_t get_output_position() {
+	return file_helper.get_output_position();
+}
+
+inline void add_term(const Term &term) {
+	// Terms outside of operators (or without folding) are never folded
+	if(!frame_stack.empty()) {
+		term_stack.push_back(term);
 	}
 }
 
-inline void print_number(Number &number) {
-	if(number.is_integral) {
-		print_integral_string(number.numerator);
+inline void add_atom(size_t start, TermKind kind, int64_t value) {
+	add_term(Term{start, get_output_position(), NO_OPERATOR, kind, value, 0});
+}
+
+// Whether an atom written at position could run into the previous token (after folding)
+inline bool needs_separator(size_t position) {
+	if(position == 0) {
+		return false;
 	}
-	else {
-		write_output("(/ ");
-		print_integral_string(number.numerator);
-		write_output(" ");
-		print_integral_string(number.denominator);
-		write_output(")");
+
+	// Unknown (flushed) previous bytes get a separator as well
+	if(!file_helper.is_buffered(position - 1)) {
+		return true;
 	}
-}
 
-////////////////////////
-// Generate functions //
-////////////////////////
+	char previous = *file_helper.get_buffered(position - 1);
 
-inline void generate(bool variable) {
-	print_bool(variable);
+	return (previous != ' ' && previous != '\n' && previous != '(' && previous != ')');
 }
 
-inline void generate(unsigned long variable) {
-	print_unsigned_long(variable);
-}
+// Starts an atom (a token that does not begin with a parenthesis), returning its position
+inline size_t begin_atom() {
+	if(needs_separator(get_output_position())) {
+		write_output(" ");
+	}
 
-template<typename F>
-inline void generate(F &&function) {
-	function();
+	return get_output_position();
 }
 
-template<>
-inline void generate(bool &variable) {
-	print_bool(variable);
-}
+////////////////////
+// Printing atoms //
+////////////////////
 
-template<>
-inline void generate(unsigned long &variable) {
-	print_unsigned_long(variable);
-}
+inline void print_bool(bool variable) {
+	if(term_dag != nullptr) {
+		term_dag->add_boolean(variable);
+		return;
+	}
 
-template<>
-inline void generate(Number &variable) {
-	print_number(variable);
-}
+	size_t start = begin_atom();
 
-template<>
-inline void generate(const char *&literal) {
-	write_output(literal);
+	if(variable) {
+		write_output("true");
+	}
+	else {
+		write_output("false");
+	}
+
+	add_atom(start, TermBoolean, variable);
 }
 
-template<typename T, typename U, typename W>
-inline void ensure_minimum(T count, U minimum, W &&function) {
-	for(auto i = count + 1; i <= minimum; i++) {
-		function();
-		write_output(" ");
+inline void print_unsigned_long(unsigned long variable) {
+	if(term_dag != nullptr) {
+		term_dag->add_integer(variable);
+		return;
 	}
-}
 
-// For handling minimum arguments
-#define MIN_SET(val) unsigned long __count = 0; unsigned long __minimum = val;
-#define MIN_COUNT __count++;
-#define MIN_ENSURE(CODE) ensure_minimum(__count, __minimum, CODE);
+	char buffer[MAXIMUM_INTEGER_LENGTH];
 
-#define MIN_ENSURE_ZERO MIN_ENSURE(LAMBDA(print_integral_string("0")))
+	size_t start = begin_atom();
 
-#define MIN_ENSURE_TRUE MIN_ENSURE(LAMBDA(print_bool(true)));
-#define MIN_ENSURE_FALSE MIN_ENSURE(LAMBDA(print_bool(false)));
+	char *end = buffer + MAXIMUM_INTEGER_LENGTH;
+	char *output = format_unsigned(variable, end);
 
-//////////////////////////////////////////////////
-// Generating operators and logical constraints //
-//////////////////////////////////////////////////
+	write_output(output, end - output);
 
-template<int OP_INDEX, typename T>
-inline void print_op1(T &&variable) {
-	write_output("(");
-	write_output(OP_STRINGS[OP_INDEX]); // TODO: Construct at compile time?
-	write_output(" ");
-	generate<T>(std::forward<T>(variable));
-	write_output(")");
+	add_atom(start, (variable <= INT64_MAX ? TermInteger : TermOpaque), static_cast<int64_t>(variable));
 }
 
-template<int OP_INDEX, typename T, typename U>
-inline void print_op2(T &&variable1, U &&variable2) {
-	write_output("(");
-	write_output(OP_STRINGS[OP_INDEX]); // TODO: Construct at compile time?
-	write_output(" ");
-	generate<T>(std::forward<T>(variable1));
-	write_output(" ");
-	generate<U>(std::forward<U>(variable2));
-	write_output(")");
+inline void write_inline_integer(int64_t value) {
+	char buffer[MAXIMUM_INTEGER_LENGTH];
+
+	char *end = buffer + MAXIMUM_INTEGER_LENGTH;
+	char *output = format_smt_integer(value, end);
+
+	write_output(output, end - output);
 }
 
-template<typename T, typename U>
-inline void print_direction_op2(Direction direction, T &&variable1, U &&variable2) {
-	write_output("(");
-	switch(direction) {
-		case Direction::SmallerEqual:
-			write_output(OP_STRINGS[OP_LEQ]);
-			break;
-		case Direction::Equal:
-			write_output(OP_STRINGS[OP_EQ]);
-			break;
-		case Direction::GreaterEqual:
-			write_output(OP_STRINGS[OP_GEQ]);
-			break;
+inline void print_inline_integer(int64_t value) {
+	if(term_dag != nullptr) {
+		term_dag->add_integer(value);
+		return;
 	}
-	write_output(" ");
-	generate<T>(std::forward<T>(variable1));
-	write_output(" ");
-	generate<U>(std::forward<U>(variable2));
-	write_output(")");
-}
 
-template<typename T, typename U, typename W>
-inline void print_ifelse(T &&test, U &&if_value, W &&else_value) {
-	print_op1<OP_ITE>(
-		[&test, &if_value, &else_value] {
-			generate<T>(std::forward<T>(test));
-			write_output(" ");
-			generate<U>(std::forward<U>(if_value));
-			write_output(" ");
-			generate<W>(std::forward<W>(else_value));
-		}
-	);
-}
+	size_t start = (value < 0 ? get_output_position() : begin_atom());
 
-template<typename T>
-inline void print_ceil(T &&parameter) {
-	print_op1<OP_MINUS>(
-		[&parameter] {
-			print_op1<OP_RND_DOWN>(
-				[&parameter] { print_op1<OP_MINUS>(parameter); }
-			);
-		}
-	);
+	write_inline_integer(value);
+
+	add_atom(start, TermInteger, value);
 }
 
-inline void print_s(Direction direction) {
-	switch(direction) {
-		case Direction::SmallerEqual:
-			print_op1<OP_MINUS>(
-				LITERAL(1)
-			);
-			break;
-		case Direction::Equal:
-			print_integral_string("0");
-			break;
-		case Direction::GreaterEqual:
-			print_integral_string("1");
-			break;
+inline void print_number(Number &number) {
+	if(term_dag != nullptr) {
+		term_dag->add_number(number);
+		return;
 	}
-}
 
-///////////////////////////
-// Print header & footer //
-///////////////////////////
+	if(number.is_inline()) {
+		print_inline_integer(number.get_inline_value());
+		return;
+	}
 
-void print_header() {
-    write_output("(set-info :smt-lib-version 2.6)\n");
-    write_output("(set-logic QF_LIRA)\n");
-    write_output("(set-info :source \"Transformed from a VIPR certificate\")\n");
-    write_output("; --- END HEADER --- \n\n");
-}
+	NumberEntry &entry = number.get_entry();
 
-void print_footer() {
-    write_output("(check-sat)\n");
-}
+	size_t start = (entry.smt[0] == '(' ? get_output_position() : begin_atom());
 
-/////////////////////////////
-// Print model constraints //
-/////////////////////////////
+	// Rendered once, when the number was interned
+	write_output(entry.smt, entry.smt_length);
 
-bool Certificate::get_PUB() {
-	return (feasible && !feasible_upper_bound.is_positive_infinity);
+	add_atom(start, TermOpaque, 0);
 }
 
-bool Certificate::get_PLB() {
-	return (feasible && !feasible_lower_bound.is_negative_infinity);
-}
+// Symbol bound by a let (the prefix followed by the index)
+inline void print_symbol(const char *prefix, unsigned long index) {
+	char buffer[MAXIMUM_INTEGER_LENGTH];
 
-Number &Certificate::get_U() {
-	return (get_PUB() ? feasible_upper_bound : zero);
-}
+	size_t start = begin_atom();
 
-Number &Certificate::get_L() {
-	return (get_PLB() ? feasible_lower_bound : zero);
+	char *end = buffer + MAXIMUM_INTEGER_LENGTH;
+	char *output = format_unsigned(index, end);
+
+	write_string(prefix);
+	write_output(output, end - output);
+
+	add_atom(start, TermOpaque, 0);
 }
 
-void Certificate::print_pub() {
-	print_op2<OP_AND>(
-		feasible,
-		LAMBDA(print_bool(!(feasible_upper_bound.is_positive_infinity)))
-	);
+inline void print_symbol(const char *name) {
+	size_t start = begin_atom();
+
+	write_string(name);
+
+	add_atom(start, TermOpaque, 0);
 }
 
-void Certificate::print_plb() {
-	print_op2<OP_AND>(
-		feasible,
-		LAMBDA(print_bool(!(feasible_lower_bound.is_negative_infinity)))
-	);
+/////////////////////////////////////
+// Folding operators at generation //
+/////////////////////////////////////
+
+// Length of "(op "
+static inline size_t get_prefix_length(int op) {
+	return OP_PREFIXES[op].length;
 }
 
-void Certificate::print_respect_bound(vector<Number> &coefficients, vector<Number> &assignments, Direction direction, Number &target) {
-	print_direction_op2(
-		direction,
-		LAMBDA(
-			print_op1<OP_PLUS>(LAMBDA(
-#ifndef FULL_MODEL
-				MIN_SET(2);
-#endif /* !FULL_MODEL */
+// Whether the text of the operator outside of its terms is only blanks
+static bool has_blank_gaps(const TermFrame &frame, const Term *terms, size_t number_terms, size_t end) {
+	size_t position = frame.start + get_prefix_length(frame.op);
 
-				for(unsigned long i = 0; i < number_variables; i++) {
-#ifndef FULL_MODEL
-					auto &coefficient = coefficients[i];
-					auto &assignment = assignments[i];
+	auto blank_until = [&position] (size_t limit) {
+		for(; position < limit; position++) {
+			char character = *file_helper.get_buffered(position);
 
-					if(coefficient.is_zero() || assignment.is_zero()) {
-						continue;
-					}
+			if(character != ' ' && character != '\n') {
+				return false;
+			}
+		}
 
-					MIN_COUNT;
-#endif /* !FULL_MODEL */
+		return true;
+	};
 
-					print_op2<OP_TIMES>(
-						LAMBDA(print_number(coefficient)),
-						LAMBDA(print_number(assignment))
-					);
+	for(size_t i = 0; i < number_terms; i++) {
+		if(!blank_until(terms[i].start)) {
+			return false;
+		}
 
-					// Space between multiplicative terms on the left-hand side
-					write_output(" ");
-				}
+		position = terms[i].end;
+	}
 
-#ifndef FULL_MODEL
-				MIN_ENSURE_ZERO;
-#endif /* !FULL_MODEL */
-			));
-		),
-		LAMBDA(print_number(target))
-	);
+	// Excludes the closing parenthesis
+	return blank_until(end - 1);
 }
 
-// TODO: This function is too similar to the one above. Consider creating one function that handles both
-void Certificate::print_respect_bound(Constraint &constraint, vector<Number> &assignments, Direction direction, Number &target) {
-	print_direction_op2(
-		direction,
-		LAMBDA(
-			print_op1<OP_PLUS>(LAMBDA(
-#ifndef FULL_MODEL
-				MIN_SET(2);
-#endif /* !FULL_MODEL */
-
-				for(unsigned long i = 0; i < number_variables; i++) {
-#ifndef FULL_MODEL
-					auto &coefficient = constraint.coefficients_at(i);
-					auto &assignment = assignments[i];
+// Replaces the text of the operator by a constant
+static void set_constant(const TermFrame &frame, Term &result, TermKind kind, int64_t value) {
+	file_helper.rewind_output(frame.start);
 
-					if(coefficient.is_zero() || assignment.is_zero()) {
-						continue;
-					}
+	size_t start = (kind == TermInteger && value < 0 ? frame.start : begin_atom());
 
-					MIN_COUNT;
-#endif /* !FULL_MODEL */
+	if(kind == TermBoolean && value) {
+		write_output("true");
+	}
+	else if(kind == TermBoolean) {
+		write_output("false");
+	}
+	else {
+		write_inline_integer(value);
+	}
 
-					print_op2<OP_TIMES>(
-						LAMBDA(print_number(coefficient)),
-						LAMBDA(print_number(assignment))
-					);
+	result = Term{start, get_output_position(), NO_OPERATOR, kind, value, 0};
+}
 
-					// Space between multiplicative terms on the left-hand side
-					write_output(" ");
-				}
+// Replaces the text of the operator by one of its terms
+static void set_term(const TermFrame &frame, Term &result, const Term &term) {
+	size_t length = term.end - term.start;
 
-#ifndef FULL_MODEL
-				MIN_ENSURE_ZERO;
-#endif /* !FULL_MODEL */
-			));
-		),
-		LAMBDA(print_number(target))
-	);
-}
+	// The term is inside the operator, so moving it one byte right for a separator is safe
+	size_t start = frame.start + (*file_helper.get_buffered(term.start) != '(' && needs_separator(frame.start));
 
-void Certificate::print_one_solution_within_bound(Direction direction, Number &bound) {
-	print_op1<OP_OR>(LAMBDA(
-		MIN_SET(2);
+	memmove(file_helper.get_buffered(start), file_helper.get_buffered(term.start), length);
 
-		for(Solution &solution: solutions) {
-			print_respect_bound(objective_coefficients, solution.assignments, direction, bound);
+	if(start != frame.start) {
+		*file_helper.get_buffered(frame.start) = ' ';
+	}
 
-			// Space between terms
-			write_output(" ");
-			MIN_COUNT;
-		}
+	file_helper.rewind_output(start + length);
 
-		MIN_ENSURE_FALSE;
-	));
+	result = term;
+	result.start = start;
+	result.end = start + length;
 }
 
-void Certificate::print_all_solutions_within_bound(Direction direction, Number &bound) {
-	print_op1<OP_AND>(LAMBDA(
-		MIN_SET(2);
-
-		for(Solution &solution: solutions) {
-			print_respect_bound(objective_coefficients, solution.assignments, direction, bound);
+/**
+	Folds an associative operator: drops neutral operands, inlines the operands of nested
+	terms with the same operator, and collapses to a constant (no operands left, or an
+	absorbing operand) or to its single operand.
+*/
+static void fold_associative(const TermFrame &frame, const Term *terms, size_t number_terms, Term &result, TermKind kind, int64_t neutral, bool absorbs, int64_t absorbing) {
+	auto is_neutral = [&] (const Term &term) {
+		return (term.kind == kind && term.value == neutral);
+	};
 
-			// Space between terms
-			write_output(" ");
-			MIN_COUNT;
-		}
+	auto is_nested = [&] (const Term &term) {
+		return (term.kind == TermOpaque && term.op == frame.op);
+	};
 
-		MIN_ENSURE_TRUE;
-	));
-}
+	unsigned long number_operands = 0;
+	size_t single = number_terms;
 
-void Certificate::print_feas_individual(Solution &solution) {
-	// TODO: Check: Note that I check for solution integrals only once. Can we reflect in the model?
-	print_op1<OP_AND>(LAMBDA(
-		MIN_SET(2);
+	for(size_t i = 0; i < number_terms; i++) {
+		if(absorbs && terms[i].kind == kind && terms[i].value == absorbing) {
+			set_constant(frame, result, kind, absorbing);
+			return;
+		}
 
-		for(unsigned long i: variable_integral_vector) {
-			print_bool(solution.assignments[i].is_integral);
+		if(is_neutral(terms[i])) {
+			continue;
+		}
 
-			// Space between terms
-			write_output(" ");
-			MIN_COUNT;
+		if(is_nested(terms[i])) {
+			number_operands += terms[i].number_operands;
 		}
+		else {
+			number_operands++;
+			single = i;
+		}
+	}
 
-		for(int constraint_index = 0; constraint_index < number_problem_constraints; constraint_index++) {
-			Constraint &constraint = constraints[constraint_index];
+	if(number_operands == 0) {
+		set_constant(frame, result, kind, neutral);
+		return;
+	}
 
-			print_op2<OP_IMPLICATION>(
-				LAMBDA(print_op2<OP_GEQ>(
-					LAMBDA(print_s(constraint.direction)),
-					LITERAL(0)
-				)),
-				LAMBDA(
-					print_respect_bound(constraint, solution.assignments, Direction::GreaterEqual, constraint.target);
-				)
-			);
-			MIN_COUNT;
+	if(number_operands == 1 && single != number_terms) {
+		set_term(frame, result, terms[single]);
+		return;
+	}
 
-			print_op2<OP_IMPLICATION>(
-				LAMBDA(print_op2<OP_LEQ>(
-					LAMBDA(print_s(constraint.direction)),
-					LITERAL(0)
-				)),
-				LAMBDA(
-					print_respect_bound(constraint, solution.assignments, Direction::SmallerEqual, constraint.target);
-				)
-			);
-			MIN_COUNT;
+	// Moves the remaining operands left, in place
+	size_t prefix_length = get_prefix_length(frame.op);
+	size_t cursor = frame.start + prefix_length;
 
-			// Space between terms
-			write_output(" ");
+	bool first = true;
+
+	for(size_t i = 0; i < number_terms; i++) {
+		if(is_neutral(terms[i])) {
+			continue;
 		}
 
-		MIN_ENSURE_TRUE;
-	));
-}
+		size_t start = terms[i].start;
+		size_t end = terms[i].end;
 
-void Certificate::print_feas() {
-	print_op1<OP_AND>(LAMBDA(
-		MIN_SET(2);
-		
-		for(Solution &solution: solutions) {
-			print_feas_individual(solution);
+		if(is_nested(terms[i])) {
+			start += prefix_length;
+			end -= 1;
+		}
 
-			// Space between terms
-			write_output(" ");
-			MIN_COUNT;
+		// Adjacent terms were adjacent in the original text as well
+		if(!first && cursor < start) {
+			*file_helper.get_buffered(cursor++) = ' ';
 		}
 
-		MIN_ENSURE_TRUE;
-	));
-}
+		memmove(file_helper.get_buffered(cursor), file_helper.get_buffered(start), end - start);
 
-void Certificate::print_pubimplication() {
-	print_op2<OP_IMPLICATION>(
-		LAMBDA(print_pub()),
-		LAMBDA(print_one_solution_within_bound(Direction::SmallerEqual, get_U()))
-	);
+		cursor += (end - start);
+		first = false;
+	}
+
+	*file_helper.get_buffered(cursor++) = ')';
+
+	file_helper.rewind_output(cursor);
+
+	result.end = cursor;
+	result.number_operands = number_operands;
 }
 
-void Certificate::print_plbimplication() {
-	print_op2<OP_IMPLICATION>(
-		LAMBDA(print_plb()),
-		LAMBDA(print_one_solution_within_bound(Direction::GreaterEqual, get_L()))
-	);
+static bool compare_integers(int op, int64_t a, int64_t b) {
+	switch(op) {
+		case OP_EQ:
+			return (a == b);
+		case OP_NEQ:
+			return (a != b);
+		case OP_LEQ:
+			return (a <= b);
+		case OP_GEQ:
+			return (a >= b);
+		case OP_L:
+			return (a < b);
+		default:
+			return (a > b);
+	}
 }
 
-void Certificate::print_sol() {
-	auto task_print_sol = [&, this] {
-		write_output("; Begin SOL\n");
+static void fold_operator(const TermFrame &frame, const Term *terms, size_t number_terms, Term &result) {
+	auto is_boolean = [&] (size_t i) {
+		return (terms[i].kind == TermBoolean);
+	};
 
-		print_op1<OP_ASSERT>(LAMBDA(
-			print_ifelse(
-				LAMBDA(print_op1<OP_NOT>(feasible)),
-				LAMBDA(print_op2<OP_EQ>(number_solutions, LITERAL(0))),
-				LAMBDA(print_op2<OP_AND>(
-					LAMBDA(print_feas()),
-					LAMBDA(print_ifelse(
-						minimization,
-						LAMBDA(print_pubimplication()),
-						LAMBDA(print_plbimplication())
-					))
-				))
-			)
-		));
+	auto are_integers = [&] {
+		return (number_terms == 2 && terms[0].kind == TermInteger && terms[1].kind == TermInteger);
 	};
 
-#ifdef PARALLEL
-	threads.emplace_back([&, this] {
-		// Open the file for SOL and print header
-		string section_output_filename = output_filename + ".SOL";
+	switch(frame.op) {
+		case OP_AND:
+			fold_associative(frame, terms, number_terms, result, TermBoolean, true, true, false);
+			break;
+		case OP_OR:
+			fold_associative(frame, terms, number_terms, result, TermBoolean, false, true, true);
+			break;
+		case OP_PLUS:
+			fold_associative(frame, terms, number_terms, result, TermInteger, 0, false, 0);
+			break;
+		case OP_NOT:
+			if(number_terms == 1 && is_boolean(0)) {
+				set_constant(frame, result, TermBoolean, !terms[0].value);
+			}
+			break;
+		case OP_IMPLICATION:
+			if(number_terms != 2) {
+				break;
+			}
 
-		open_output(section_output_filename);
-		print_header();
+			if((is_boolean(0) && !terms[0].value) || (is_boolean(1) && terms[1].value)) {
+				set_constant(frame, result, TermBoolean, true);
+			}
+			else if(is_boolean(0)) {
+				set_term(frame, result, terms[1]);
+			}
+			break;
+		case OP_ITE:
+			if(number_terms == 3 && is_boolean(0)) {
+				set_term(frame, result, terms[terms[0].value ? 1 : 2]);
+			}
+			break;
+		case OP_MINUS:
+			if(number_terms == 1 && terms[0].kind == TermInteger && terms[0].value != INT64_MIN) {
+				set_constant(frame, result, TermInteger, -terms[0].value);
+			}
+			break;
+		case OP_EQ:
+		case OP_NEQ:
+		case OP_LEQ:
+		case OP_GEQ:
+		case OP_L:
+		case OP_G:
+			if(are_integers()) {
+				set_constant(frame, result, TermBoolean, compare_integers(frame.op, terms[0].value, terms[1].value));
+			}
+			break;
+		case OP_LET:
+			// The body is the last term: bindings have no effects, so a constant body is the result
+			if(number_terms != 0 && terms[number_terms - 1].kind != TermOpaque) {
+				set_constant(frame, result, terms[number_terms - 1].kind, terms[number_terms - 1].value);
+			}
+			break;
+	}
+}
 
-		task_print_sol();
+// Folds the operator just closed and adds the result to its parent
+void fold_term() {
+	TermFrame frame = frame_stack.back();
+	frame_stack.pop_back();
 
-		// Print footer and close the file for block number
-		print_footer();
-		close_output();
+	size_t end = get_output_position();
 
-		// Dispatches the work to the execution manager
-		remote_execution_manager.dispatch(section_output_filename, 0);
-	});
-#else
-	task_print_sol();
-#endif /* PARALLEL */
-}
+	const Term *terms = term_stack.data() + frame.first_term;
+	size_t number_terms = term_stack.size() - frame.first_term;
 
-bool Certificate::calculate_Aij(unsigned long i, unsigned long j) {
-	if(dependencies[i] == nullptr) {
-		return false;
+	// Operators with flushed or unknown text (not generated by the print functions) stay as they are
+	Term result{frame.start, end, NO_OPERATOR, TermOpaque, 0, number_terms};
+
+	// The bindings of a let are text between its terms
+	if(file_helper.is_buffered(frame.start) && (frame.op == OP_LET || has_blank_gaps(frame, terms, number_terms, end))) {
+		result.op = frame.op;
+
+		fold_operator(frame, terms, number_terms, result);
 	}
 
-	return (dependencies[i]->contains(j));
+	term_stack.resize(frame.first_term);
+
+	add_term(result);
 }
 
-void Certificate::print_ASM(unsigned long k, Derivation &derivation) {
-#ifndef AIJ_SMT
-	bool result = true;
-#endif /* AIJ_SMT */
+inline void begin_term(int op) {
+	if(term_dag != nullptr) {
+		term_dag->begin(op);
+		return;
+	}
 
-	for(unsigned long j = k + 1; j < number_total_constraints; j++) {
-		if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-#ifndef AIJ_SMT
-			result &= !calculate_Aij(k, j);
-#else
-			print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(k, j))));
-#endif /* AIJ_SMT */
-		}
+	if(folding) {
+		frame_stack.push_back(TermFrame{op, get_output_position(), term_stack.size()});
 	}
 
-#ifndef AIJ_SMT
-	print_bool(result);
-	write_output(" ");
-#endif /* AIJ_SMT */
+	write_output(OP_PREFIXES[op].text, OP_PREFIXES[op].length);
+}
 
-	switch(derivation.reason.type) {
-		case ReasonType::TypeASM:
-			print_op2<OP_AND>(
-				LAMBDA(print_bool(calculate_Aij(k, k))),
-				LAMBDA(print_op1<OP_AND>(
-					LAMBDA(
-						MIN_SET(2);
+inline void end_term() {
+	if(term_dag != nullptr) {
+		term_dag->end();
+		return;
+	}
 
-#ifndef AIJ_SMT
-	  					bool result = true;
-#endif /* AIJ_SMT */
+	write_output(")");
 
-						for(unsigned long j = number_problem_constraints; j < k; j++) {
-							if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-#ifndef AIJ_SMT
-								result &= (!calculate_Aij(k, j));
-#else
-								print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(k, j))));
-								MIN_COUNT;
-#endif /* AIJ_SMT */
-							}
-						}
+	if(folding) {
+		fold_term();
+	}
+}
 
-#ifndef AIJ_SMT
-						print_bool(result);
-						write_output(" ");
-						MIN_COUNT;
-#endif /* AIJ_SMT */
+// Binding (name value) of a let being generated, by positions in the output
+struct LetBinding {
+	size_t start;
+	size_t name_end;
+	size_t value_end;
+};
 
-						MIN_ENSURE_TRUE;
-					)
-				))
-			);
-			break;
-		case ReasonType::TypeLIN:
-		case ReasonType::TypeRND:
-			print_op1<OP_AND>(LAMBDA(
-				MIN_SET(2);
-#ifndef AIJ_SMT
+// Calls f(start, end) for every token of the buffered output between start and end that is not a parenthesis
+template<typename F>
+static void for_each_token(size_t start, size_t end, F &&f) {
+	auto is_delimiter = [] (size_t position) {
+		char character = *file_helper.get_buffered(position);
 
-				bool result = true;
-#endif /* AIJ_SMT */
+		return (character == ' ' || character == '\n' || character == '(' || character == ')');
+	};
 
-				for(unsigned long j = number_problem_constraints; j < k; j++) {
-					if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-#ifndef AIJ_SMT
-						bool inner1 = calculate_Aij(k, j);
-						bool inner2 = false;
+	for(size_t position = start; position < end;) {
+		if(is_delimiter(position)) {
+			position++;
+			continue;
+		}
 
-						for(unsigned long &i: derivation.reason.constraint_indexes) {
-							if(j <= i && i < k) {
-								inner2 |= calculate_Aij(i, j);
-							}
-						}
+		size_t token_start = position;
 
-						result &= (inner1 == inner2);
-						continue;
-#endif /* AIJ_SMT */
+		while(position < end && !is_delimiter(position)) {
+			position++;
+		}
 
-						print_op2<OP_EQ>(
-							LAMBDA(print_bool(calculate_Aij(k, j))),
-							LAMBDA(print_op1<OP_OR>(
-								LAMBDA(
-									MIN_SET(2);
+		f(token_start, position);
+	}
+}
 
-									for(unsigned long &i: derivation.reason.constraint_indexes) {
-										if(j <= i && i < k) {
-											print_bool(calculate_Aij(i, j));
+/**
+	Drops the bindings of the let being generated that do not make the output shorter, given
+	the number of uses left in its body after folding, and replaces their uses by their values.
+	Without bindings left, the let is replaced by its body.
 
-											// Space between terms
-											write_output(" ");
-											MIN_COUNT;
-										}
-									}
+	Expects the text of the let to be buffered, up to the end of its body (its last term).
 
-									MIN_ENSURE_FALSE;
-								)
-							))
-						);
-						MIN_COUNT;
-					}
-				}
+	@param bindings Bindings of the let, in order
+	@param body_start Where the body starts
+	@return Whether the let remains (and still needs end_term)
+*/
+static bool prune_let(const vector<LetBinding> &bindings, size_t body_start) {
+	TermFrame frame = frame_stack.back();
 
-#ifndef AIJ_SMT
-				print_bool(result);
-				write_output(" ");
-				MIN_COUNT;
-#endif /* AIJ_SMT */
+	size_t end = get_output_position();
 
-				MIN_ENSURE_TRUE;
-			));
-			break;
-		case ReasonType::TypeUNS:
-			print_op1<OP_AND>(LAMBDA(
-				MIN_SET(2);
+	auto get_text = [] (size_t start, size_t end) {
+		return std::string_view(file_helper.get_buffered(start), end - start);
+	};
 
-#ifndef AIJ_SMT
-				bool result = true;
-#endif /* AIJ_SMT */
+	std::unordered_map<std::string_view, size_t> binding_indexes;
 
-				for(unsigned long j = number_problem_constraints; j < k; j++) {
-					if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-#ifndef AIJ_SMT
-						bool inner1 = calculate_Aij(k, j);
-						bool inner1a = calculate_Aij(derivation.reason.get_i1(), j) && (j != derivation.reason.get_l1());
-						bool inner1b = calculate_Aij(derivation.reason.get_i2(), j) && (j != derivation.reason.get_l2());
+	for(size_t i = 0; i < bindings.size(); i++) {
+		binding_indexes.emplace(get_text(bindings[i].start + 1, bindings[i].name_end), i);
+	}
 
-						result &= (inner1 == (inner1a || inner1b));
-						continue;
-#endif /* AIJ_SMT */
+	auto find_binding = [&] (size_t start, size_t end) {
+		auto iterator = binding_indexes.find(get_text(start, end));
 
-						print_op2<OP_EQ>(
-							LAMBDA(print_bool(calculate_Aij(k, j))),
-							LAMBDA(print_op2<OP_OR>(
-								LAMBDA(print_op2<OP_AND>(
-									LAMBDA(print_bool(calculate_Aij(derivation.reason.get_i1(), j))),
-									LAMBDA(print_op2<OP_NEQ>(j, derivation.reason.get_l1()))
-								)),
-								LAMBDA(print_op2<OP_AND>(
-									LAMBDA(print_bool(calculate_Aij(derivation.reason.get_i2(), j))),
-									LAMBDA(print_op2<OP_NEQ>(j, derivation.reason.get_l2()))
-								))
-							))
-						);
-						MIN_COUNT;
-					}
-				}
+		return (iterator == binding_indexes.end() ? bindings.size() : iterator->second);
+	};
 
-#ifndef AIJ_SMT
-				print_bool(result);
-				write_output(" ");
-				MIN_COUNT;
-#endif /* AIJ_SMT */
+	vector<unsigned long> uses(bindings.size(), 0);
 
-				MIN_ENSURE_TRUE;
-			));
-			break;
-		case ReasonType::TypeSOL:
-			print_op1<OP_AND>(LAMBDA(
-				MIN_SET(2);
+	for_each_token(body_start, end, [&] (size_t start, size_t end) {
+		size_t i = find_binding(start, end);
 
-#ifndef AIJ_SMT
-				bool result = true;
+		if(i != bindings.size()) {
+			uses[i]++;
+		}
+	});
 
-				for(unsigned long j = number_problem_constraints; j < k; j++) {
-					if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-						result &= !calculate_Aij(k, j);
-					}
-				}
+	// Kept: "(name value) " once and the name at every use, instead of the value at every use
+	vector<bool> kept(bindings.size());
 
-				print_bool(result);
-				write_output(" ");
-				MIN_COUNT;
-				return;
-#endif /* AIJ_SMT */
+	bool kept_any = false;
+	bool dropped_any = false;
 
-				for(unsigned long j = number_problem_constraints; j < k; j++) {
-					if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-						print_op1<OP_NOT>(
-							LAMBDA(print_bool(calculate_Aij(k, j)))
-						);
-						MIN_COUNT;
-					}
-				}
+	for(size_t i = 0; i < bindings.size(); i++) {
+		size_t name_length = bindings[i].name_end - bindings[i].start - 1;
+		size_t value_length = bindings[i].value_end - bindings[i].name_end - 1;
 
-				MIN_ENSURE_TRUE;
-			));
-			break;
+		kept[i] = (uses[i] * value_length > value_length + name_length + 4 + uses[i] * name_length);
+
+		kept_any |= kept[i];
+		dropped_any |= !kept[i];
 	}
-}
 
-void Certificate::print_PRV(unsigned long k, Derivation &derivation) {
-	print_op1<OP_AND>(LAMBDA(
-		MIN_SET(2);
+	if(!dropped_any) {
+		return true;
+	}
 
-		for(unsigned long &j: derivation.reason.constraint_indexes) {
-			print_op2<OP_AND>(
-				LAMBDA(
-					print_op2<OP_L>(j, k)
-				),
-				LAMBDA(
-					print_op2<OP_GEQ>(j, LITERAL(0))
-				)
-			);
-			MIN_COUNT;
+	string text;
+
+	if(kept_any) {
+		text.append(get_text(frame.start, bindings[0].start));
+
+		for(size_t i = 0; i < bindings.size(); i++) {
+			if(kept[i]) {
+				text.append(get_text(bindings[i].start, bindings[i].value_end + 1));
+				text.append(" ");
+			}
 		}
 
-		MIN_ENSURE_TRUE;
-	));
+		text.append(") ");
+	}
+
+	size_t position = body_start;
+
+	for_each_token(body_start, end, [&] (size_t start, size_t end) {
+		size_t i = find_binding(start, end);
+
+		if(i != bindings.size() && !kept[i]) {
+			text.append(get_text(position, start));
+			text.append(get_text(bindings[i].name_end + 1, bindings[i].value_end));
+
+			position = end;
+		}
+	});
+
+	text.append(get_text(position, end));
+
+	Term body = term_stack.back();
+
+	// The terms of the let are not folded any further
+	term_stack.resize(frame.first_term);
+	file_helper.rewind_output(frame.start);
+
+	if(!kept_any) {
+		frame_stack.pop_back();
+	}
+
+	write_output(text.data(), text.size());
+
+	if(!kept_any) {
+		body.start = frame.start;
+		body.end = get_output_position();
+
+		add_term(body);
+	}
+
+	return kept_any;
 }
 
-template<typename PQ, typename PQP, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
-void Certificate::print_DOM(PQ &&a, P0 &&b, P1 &&eq, P2 &&geq, P3 &&leq, PQP &&aP, P4 &&bP, P5 &&eqP, P6 &&geqP, P7 &&leqP) {
-	print_op2<OP_OR>(
-		LAMBDA(
-			print_op2<OP_AND>(
-				LAMBDA(
-					for(unsigned long j = 0; j < number_variables; j++) {
-						print_op2<OP_EQ>(LAMBDA(a(j)), LITERAL(0));
-					}
-				),
-				LAMBDA(
-					print_ifelse(
-						eq,
-						LAMBDA(
-							print_op2<OP_NEQ>(b, LITERAL(0))
-						),
-						LAMBDA(print_ifelse(
-							geq,
-							LAMBDA(print_op2<OP_G>(b, LITERAL(0))),
-							LAMBDA(print_ifelse(
-								leq,
-								LAMBDA(print_op2<OP_L>(b, LITERAL(0))),
-								LAMBDA(print_bool(false))
-							))
-						))
-					)
-				)
-			)
-		),
-		LAMBDA(
-			print_op2<OP_AND>(
-				LAMBDA(
-					for(unsigned long j = 0; j < number_variables; j++) {
-						print_op2<OP_EQ>(LAMBDA(a(j)), LAMBDA(aP(j)));
-					}
-				),
-				LAMBDA(
-					print_ifelse(
-						eqP,
-						LAMBDA(
-							print_op2<OP_AND>(
-								eq,
-								LAMBDA(print_op2<OP_EQ>(b, bP))
-							)
-						),
-						LAMBDA(print_ifelse(
-							geqP,
-							LAMBDA(
-								print_op2<OP_AND>(
-									geq,
-									LAMBDA(print_op2<OP_GEQ>(b, bP))
-								)
-							),
-							LAMBDA(print_ifelse(
-								leqP,
-								LAMBDA(
-									print_op2<OP_AND>(
-										leq,
-										LAMBDA(print_op2<OP_LEQ>(b, bP))
-									)
-								),
-								LAMBDA(print_bool(false))
-							))
-						))
-					)
-				)
-			)
-		)
-	);
+////////////////////////
+// Generate functions //
+////////////////////////
+
+inline void generate(bool variable) {
+	print_bool(variable);
 }
 
-template<typename P0, typename P1, typename P2, typename P3, typename P4, typename P5>
-void Certificate::print_DOM(P0 &&print_coefficientA, P1 &&print_directionA, P2 &&print_targetA, P3 &&print_coefficientB, P4 &&print_directionB, P5 &&print_targetB) {
-	print_DOM(
-		print_coefficientA,
-		print_targetA,
-		LAMBDA(print_op2<OP_EQ>(
-			print_directionA,
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_GEQ>(
-			print_directionA,
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_LEQ>(
-			print_directionA,
-			LITERAL(0)
-		)),
-		print_coefficientB,
-		print_targetB,
-		LAMBDA(print_op2<OP_EQ>(
-			print_directionB,
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_GEQ>(
-			print_directionB,
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_LEQ>(
-			print_directionB,
-			LITERAL(0)
-		))
-	);
+inline void generate(unsigned long variable) {
+	print_unsigned_long(variable);
 }
 
-void Certificate::print_DOM(Constraint &constraint1, Constraint &constraint2) {
-	print_DOM(
-		[&] (unsigned long j) {
-			print_number(constraint1.coefficients_at(j));
-		},
-		LAMBDA(print_number(constraint1.target)),
-		LAMBDA(print_op2<OP_EQ>(
-			LAMBDA(print_s(constraint1.direction)),
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_GEQ>(
-			LAMBDA(print_s(constraint1.direction)),
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_LEQ>(
-			LAMBDA(print_s(constraint1.direction)),
-			LITERAL(0)
-		)),
-		[&] (unsigned long j) {
-			print_number(constraint2.coefficients_at(j));
-		},
-		LAMBDA(print_number(constraint2.target)),
-		LAMBDA(print_op2<OP_EQ>(
-			LAMBDA(print_s(constraint2.direction)),
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_GEQ>(
-			LAMBDA(print_s(constraint2.direction)),
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_LEQ>(
-			LAMBDA(print_s(constraint2.direction)),
-			LITERAL(0)
-		))
-	);
+template<typename F>
+inline void generate(F &&function) {
+	function();
 }
 
-template<typename P0, typename P1>
-void Certificate::print_RND(const function<void(unsigned long)> &a, P0 &&b, P1 &&eq) {
-	print_op1<OP_AND>(
-		LAMBDA(
-			MIN_SET(2);
+template<>
+inline void generate(bool &variable) {
+	print_bool(variable);
+}
 
-			for(unsigned long j: variable_integral_vector) {
-				print_op1<OP_INTEGRAL>(LAMBDA(a(j)));
-				MIN_COUNT;
-			}
+template<>
+inline void generate(unsigned long &variable) {
+	print_unsigned_long(variable);
+}
 
-			for(unsigned long j: variable_non_integral_vector) {
-				print_op2<OP_EQ>(LAMBDA(a(j)), LITERAL(0));
-				MIN_COUNT;
-			}
+template<>
+inline void generate(Number &variable) {
+	print_number(variable);
+}
 
-			print_op1<OP_NOT>(eq);
-			MIN_COUNT;
+template<>
+inline void generate(const char *&literal) {
+	write_string(literal);
+}
 
-			MIN_ENSURE_TRUE;
-		)
-	);
+template<typename T, typename U, typename W>
+inline void ensure_minimum(T count, U minimum, W &&function) {
+	for(auto i = count + 1; i <= minimum; i++) {
+		function();
+		write_output(" ");
+	}
 }
 
-void Certificate::print_DIS(Constraint &c_i, Constraint &c_j) {
-	print_op1<OP_AND>(
-		LAMBDA(
-			// Not counting because the number of operations is always >= 2
+// For handling minimum arguments
+#define MIN_SET(val) unsigned long __count = 0; unsigned long __minimum = val;
+#define MIN_COUNT __count++;
+#define MIN_ENSURE(CODE) ensure_minimum(__count, __minimum, CODE);
 
-			for(unsigned long k = 0; k < number_variables; k++) {
-				print_op2<OP_EQ>(c_i.coefficients_at(k), c_j.coefficients_at(k));
-			}
-			 
-			for(unsigned long k: variable_integral_vector) {
-				print_op1<OP_INTEGRAL>(c_i.coefficients_at(k));
-			}
+#define MIN_ENSURE_ZERO MIN_ENSURE(LAMBDA(print_inline_integer(0)))
 
-			for(unsigned long k: variable_non_integral_vector) {
-				print_op2<OP_EQ>(c_i.coefficients_at(k), LITERAL(0));
-			}
+#define MIN_ENSURE_TRUE MIN_ENSURE(LAMBDA(print_bool(true)));
+#define MIN_ENSURE_FALSE MIN_ENSURE(LAMBDA(print_bool(false)));
+
+//////////////////////////////////////////////////
+// Generating operators and logical constraints //
+//////////////////////////////////////////////////
+
+template<int OP_INDEX, typename T>
+inline void print_op1(T &&variable) {
+	begin_term(OP_INDEX);
+	generate<T>(std::forward<T>(variable));
+	end_term();
+}
+
+template<int OP_INDEX, typename T, typename U>
+inline void print_op2(T &&variable1, U &&variable2) {
+	begin_term(OP_INDEX);
+	generate<T>(std::forward<T>(variable1));
+	write_output(" ");
+	generate<U>(std::forward<U>(variable2));
+	end_term();
+}
+
+template<typename T, typename U>
+inline void print_direction_op2(Direction direction, T &&variable1, U &&variable2) {
+	switch(direction) {
+		case Direction::SmallerEqual:
+			begin_term(OP_LEQ);
+			break;
+		case Direction::Equal:
+			begin_term(OP_EQ);
+			break;
+		case Direction::GreaterEqual:
+			begin_term(OP_GEQ);
+			break;
+	}
+	generate<T>(std::forward<T>(variable1));
+	write_output(" ");
+	generate<U>(std::forward<U>(variable2));
+	end_term();
+}
+
+template<typename T, typename U, typename W>
+inline void print_ifelse(T &&test, U &&if_value, W &&else_value) {
+	print_op1<OP_ITE>(
+		[&test, &if_value, &else_value] {
+			generate<T>(std::forward<T>(test));
+			write_output(" ");
+			generate<U>(std::forward<U>(if_value));
+			write_output(" ");
+			generate<W>(std::forward<W>(else_value));
+		}
+	);
+}
+
+template<typename T>
+inline void print_ceil(T &&parameter) {
+	print_op1<OP_MINUS>(
+		[&parameter] {
+			print_op1<OP_RND_DOWN>(
+				[&parameter] { print_op1<OP_MINUS>(parameter); }
+			);
+		}
+	);
+}
+
+inline void print_s(Direction direction) {
+	switch(direction) {
+		case Direction::SmallerEqual:
+			print_inline_integer(-1);
+			break;
+		case Direction::Equal:
+			print_inline_integer(0);
+			break;
+		case Direction::GreaterEqual:
+			print_inline_integer(1);
+			break;
+	}
+}
+
+///////////////////////////
+// Print header & footer //
+///////////////////////////
+
+void print_header() {
+    write_output("(set-info :smt-lib-version 2.6)\n");
+    write_output("(set-logic QF_LIRA)\n");
+    write_output("(set-info :source \"Transformed from a VIPR certificate\")\n");
+    write_output("; --- END HEADER --- \n\n");
+}
+
+void print_footer() {
+    write_output("(check-sat)\n");
+}
+
+////////////////////
+// Encoding modes //
+////////////////////
+
+/**
+	Resolves the encoding options once for a unit of output (a file, a block or a derivation):
+	everything f emits runs in the instantiation of the current mode, without testing the
+	options again.
+
+	@param f Called with Encoding<full_model, aij_smt, eq_leq_geq_smt>{} (as a type tag)
+*/
+template<typename F>
+void Certificate::with_encoding(F &&f) {
+	// Folding is emission state of the calling thread
+	folding = !mode.full_model;
+
+	switch((mode.full_model ? 4 : 0) | (mode.aij_smt ? 2 : 0) | (mode.eq_leq_geq_smt ? 1 : 0)) {
+		case 0:
+			f(Encoding<false, false, false>{});
+			break;
+		case 1:
+			f(Encoding<false, false, true>{});
+			break;
+		case 2:
+			f(Encoding<false, true, false>{});
+			break;
+		case 3:
+			f(Encoding<false, true, true>{});
+			break;
+		case 4:
+			f(Encoding<true, false, false>{});
+			break;
+		case 5:
+			f(Encoding<true, false, true>{});
+			break;
+		case 6:
+			f(Encoding<true, true, false>{});
+			break;
+		case 7:
+			f(Encoding<true, true, true>{});
+			break;
+	}
+}
+
+/////////////////////////////
+// Print model constraints //
+/////////////////////////////
+
+bool Certificate::get_PUB() {
+	return (feasible && !feasible_upper_bound.is_positive_infinity());
+}
+
+bool Certificate::get_PLB() {
+	return (feasible && !feasible_lower_bound.is_negative_infinity());
+}
+
+Number &Certificate::get_U() {
+	return (get_PUB() ? feasible_upper_bound : zero);
+}
+
+Number &Certificate::get_L() {
+	return (get_PLB() ? feasible_lower_bound : zero);
+}
+
+void Certificate::print_pub() {
+	print_op2<OP_AND>(
+		feasible,
+		LAMBDA(print_bool(!(feasible_upper_bound.is_positive_infinity())))
+	);
+}
+
+void Certificate::print_plb() {
+	print_op2<OP_AND>(
+		feasible,
+		LAMBDA(print_bool(!(feasible_lower_bound.is_negative_infinity())))
+	);
+}
+
+template<typename E>
+void Certificate::print_respect_bound(vector<Number> &coefficients, vector<Number> &assignments, Direction direction, Number &target) {
+	print_direction_op2(
+		direction,
+		LAMBDA(
+			print_op1<OP_PLUS>(LAMBDA(
+				MIN_SET(2);
+
+				for(unsigned long i = 0; i < number_variables; i++) {
+					auto &coefficient = coefficients[i];
+					auto &assignment = assignments[i];
+
+					if constexpr(!E::full_model) {
+						if(coefficient.is_zero() || assignment.is_zero()) {
+							continue;
+						}
+					}
+
+					MIN_COUNT;
+
+					print_op2<OP_TIMES>(
+						LAMBDA(print_number(coefficient)),
+						LAMBDA(print_number(assignment))
+					);
+
+					// Space between multiplicative terms on the left-hand side
+					write_output(" ");
+				}
+
+				MIN_ENSURE_ZERO;
+			));
+		),
+		LAMBDA(print_number(target))
+	);
+}
+
+// TODO: This function is too similar to the one above. Consider creating one function that handles both
+template<typename E>
+void Certificate::print_respect_bound(Constraint &constraint, vector<Number> &assignments, Direction direction, Number &target) {
+	print_direction_op2(
+		direction,
+		LAMBDA(
+			print_op1<OP_PLUS>(LAMBDA(
+				MIN_SET(2);
+
+				unsigned long position = 0;
+
+				for(unsigned long i = 0; i < number_variables; i++) {
+					auto &coefficient = constraint.coefficients_at(i, position);
+					auto &assignment = assignments[i];
+
+					if constexpr(!E::full_model) {
+						if(coefficient.is_zero() || assignment.is_zero()) {
+							continue;
+						}
+					}
+
+					MIN_COUNT;
+
+					print_op2<OP_TIMES>(
+						LAMBDA(print_number(coefficient)),
+						LAMBDA(print_number(assignment))
+					);
+
+					// Space between multiplicative terms on the left-hand side
+					write_output(" ");
+				}
+
+				MIN_ENSURE_ZERO;
+			));
+		),
+		LAMBDA(print_number(target))
+	);
+}
+
+template<typename E>
+void Certificate::print_one_solution_within_bound(Direction direction, Number &bound) {
+	print_op1<OP_OR>(LAMBDA(
+		MIN_SET(2);
+
+		for(Solution &solution: solutions) {
+			print_respect_bound<E>(objective_coefficients, solution.assignments, direction, bound);
+
+			// Space between terms
+			write_output(" ");
+			MIN_COUNT;
+		}
+
+		MIN_ENSURE_FALSE;
+	));
+}
+
+template<typename E>
+void Certificate::print_all_solutions_within_bound(Direction direction, Number &bound) {
+	print_op1<OP_AND>(LAMBDA(
+		MIN_SET(2);
+
+		for(Solution &solution: solutions) {
+			print_respect_bound<E>(objective_coefficients, solution.assignments, direction, bound);
+
+			// Space between terms
+			write_output(" ");
+			MIN_COUNT;
+		}
+
+		MIN_ENSURE_TRUE;
+	));
+}
+
+template<typename E>
+void Certificate::print_feas_individual(Solution &solution) {
+	// TODO: Check: Note that I check for solution integrals only once. Can we reflect in the model?
+	print_op1<OP_AND>(LAMBDA(
+		MIN_SET(2);
+
+		for(unsigned long i: variable_integral_vector) {
+			print_bool(solution.assignments[i].is_integral());
+
+			// Space between terms
+			write_output(" ");
+			MIN_COUNT;
+		}
+
+		for(int constraint_index = 0; constraint_index < number_problem_constraints; constraint_index++) {
+			Constraint &constraint = constraints[constraint_index];
+
+			print_op2<OP_IMPLICATION>(
+				LAMBDA(print_op2<OP_GEQ>(
+					LAMBDA(print_s(constraint.direction)),
+					LITERAL(0)
+				)),
+				LAMBDA(
+					print_respect_bound<E>(constraint, solution.assignments, Direction::GreaterEqual, constraint.target);
+				)
+			);
+			MIN_COUNT;
+
+			print_op2<OP_IMPLICATION>(
+				LAMBDA(print_op2<OP_LEQ>(
+					LAMBDA(print_s(constraint.direction)),
+					LITERAL(0)
+				)),
+				LAMBDA(
+					print_respect_bound<E>(constraint, solution.assignments, Direction::SmallerEqual, constraint.target);
+				)
+			);
+			MIN_COUNT;
+
+			// Space between terms
+			write_output(" ");
+		}
+
+		MIN_ENSURE_TRUE;
+	));
+}
+
+template<typename E>
+void Certificate::print_feas() {
+	print_op1<OP_AND>(LAMBDA(
+		MIN_SET(2);
+		
+		for(Solution &solution: solutions) {
+			print_feas_individual<E>(solution);
+
+			// Space between terms
+			write_output(" ");
+			MIN_COUNT;
+		}
+
+		MIN_ENSURE_TRUE;
+	));
+}
+
+template<typename E>
+void Certificate::print_pubimplication() {
+	print_op2<OP_IMPLICATION>(
+		LAMBDA(print_pub()),
+		LAMBDA(print_one_solution_within_bound<E>(Direction::SmallerEqual, get_U()))
+	);
+}
+
+template<typename E>
+void Certificate::print_plbimplication() {
+	print_op2<OP_IMPLICATION>(
+		LAMBDA(print_plb()),
+		LAMBDA(print_one_solution_within_bound<E>(Direction::GreaterEqual, get_L()))
+	);
+}
+
+void Certificate::print_sol() {
+	auto task_print_sol = [this] {
+		with_encoding([&] (auto encoding) {
+			using E = decltype(encoding);
+
+			write_output("; Begin SOL\n");
+
+			print_op1<OP_ASSERT>(LAMBDA(
+				print_ifelse(
+					LAMBDA(print_op1<OP_NOT>(feasible)),
+					LAMBDA(print_op2<OP_EQ>(number_solutions, LITERAL(0))),
+					LAMBDA(print_op2<OP_AND>(
+						LAMBDA(print_feas<E>()),
+						LAMBDA(print_ifelse(
+							minimization,
+							LAMBDA(print_pubimplication<E>()),
+							LAMBDA(print_plbimplication<E>())
+						))
+					))
+				)
+			));
+		});
+	};
+
+	if(!mode.parallel) {
+		task_print_sol();
+		return;
+	}
+
+	// The thread outlives this function: capture by value
+	threads.emplace_back([=, this] {
+		// Open the file for SOL and print header
+		string section_output_filename = output_filename + ".SOL";
+
+		open_output(section_output_filename);
+		print_header();
+
+		task_print_sol();
+
+		// Print footer and close the file for block number
+		print_footer();
+		output_length += close_output();
+
+		// Dispatches the work to the execution manager
+		remote_execution_manager.dispatch(section_output_filename, 0);
+	});
+}
+
+bool Certificate::calculate_Aij(unsigned long i, unsigned long j) {
+	if(dependencies[i] == nullptr) {
+		return false;
+	}
+
+	uint32_t id = get_assumption_id(j);
+
+	return (id != NO_ASSUMPTION && dependencies[i]->contains(id));
+}
+
+template<typename F>
+void Certificate::for_each_assumption(unsigned long i, F &&f) {
+	if(dependencies[i] == nullptr) {
+		return;
+	}
+
+	dependencies[i]->for_each([&] (unsigned long id) {
+		f(assumption_positions[id]);
+	});
+}
+
+// A(i, j) can only hold for the ASM derivations j in the dependency set of i: the
+// conditions below are checked only over those
+
+bool Certificate::calculate_ASM_later(unsigned long k) {
+	bool result = true;
+
+	for_each_assumption(k, [&] (unsigned long j) {
+		result &= (j <= k);
+	});
+
+	return result;
+}
+
+bool Certificate::calculate_ASM_earlier(unsigned long k, Derivation &derivation) {
+	bool result = true;
+
+	switch(derivation.reason.type) {
+		case ReasonType::TypeASM:
+		case ReasonType::TypeSOL:
+			for_each_assumption(k, [&] (unsigned long j) {
+				result &= (j >= k);
+			});
+			break;
+		case ReasonType::TypeLIN:
+		case ReasonType::TypeRND: {
+			auto check = [&] (unsigned long j) {
+				if(j >= k) {
+					return;
+				}
+
+				bool inner1 = calculate_Aij(k, j);
+				bool inner2 = false;
+
+				for(unsigned long &i: derivation.reason.constraint_indexes) {
+					if(j <= i && i < k) {
+						inner2 |= calculate_Aij(i, j);
+					}
+				}
+
+				result &= (inner1 == inner2);
+			};
+
+			// Checks each distinct dependency set once
+			vector<const AssumptionSet *> visited{dependencies[k].get()};
+
+			for_each_assumption(k, check);
+
+			for(unsigned long &i: derivation.reason.constraint_indexes) {
+				if(i >= k || std::find(visited.begin(), visited.end(), dependencies[i].get()) != visited.end()) {
+					continue;
+				}
+
+				visited.push_back(dependencies[i].get());
+
+				for_each_assumption(i, check);
+			}
+			break;
+		}
+		case ReasonType::TypeUNS: {
+			auto check = [&] (unsigned long j) {
+				if(j >= k) {
+					return;
+				}
+
+				bool inner1 = calculate_Aij(k, j);
+				bool inner1a = calculate_Aij(derivation.reason.get_i1(), j) && (j != derivation.reason.get_l1());
+				bool inner1b = calculate_Aij(derivation.reason.get_i2(), j) && (j != derivation.reason.get_l2());
+
+				result &= (inner1 == (inner1a || inner1b));
+			};
+
+			for_each_assumption(k, check);
+			for_each_assumption(derivation.reason.get_i1(), check);
+			for_each_assumption(derivation.reason.get_i2(), check);
+			break;
+		}
+	}
+
+	return result;
+}
+
+template<typename E>
+void Certificate::print_ASM(unsigned long k, Derivation &derivation) {
+	// Ids of the ASM derivations before k are [0, earlier_end); those after k start at later_start
+	unsigned long earlier_end = count_assumptions_before(k);
+	unsigned long later_start = assumption_counts[k];
+
+	if constexpr(!E::aij_smt) {
+		print_bool(calculate_ASM_later(k));
+		write_output(" ");
+	}
+	else {
+		// While streaming, later derivations may not be parsed yet: they are skipped, as
+		// A(k, j) is false by construction for every j > k
+		unsigned long later_end = (streaming ? later_start : number_assumptions);
+
+		for(unsigned long id = later_start; id < later_end; id++) {
+			print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(k, assumption_positions[id]))));
+		}
+	}
+
+	switch(derivation.reason.type) {
+		case ReasonType::TypeASM:
+			print_op2<OP_AND>(
+				LAMBDA(print_bool(calculate_Aij(k, k))),
+				LAMBDA(print_op1<OP_AND>(
+					LAMBDA(
+						MIN_SET(2);
+
+						if constexpr(!E::aij_smt) {
+							print_bool(calculate_ASM_earlier(k, derivation));
+							write_output(" ");
+							MIN_COUNT;
+						}
+						else {
+							for(unsigned long id = 0; id < earlier_end; id++) {
+								print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(k, assumption_positions[id]))));
+								MIN_COUNT;
+							}
+						}
+
+						MIN_ENSURE_TRUE;
+					)
+				))
+			);
+			break;
+		case ReasonType::TypeLIN:
+		case ReasonType::TypeRND:
+			print_op1<OP_AND>(LAMBDA(
+				MIN_SET(2);
+
+				if constexpr(!E::aij_smt) {
+					print_bool(calculate_ASM_earlier(k, derivation));
+					write_output(" ");
+					MIN_COUNT;
+				}
+				else {
+					for(unsigned long id = 0; id < earlier_end; id++) {
+						unsigned long j = assumption_positions[id];
+
+						print_op2<OP_EQ>(
+							LAMBDA(print_bool(calculate_Aij(k, j))),
+							LAMBDA(print_op1<OP_OR>(
+								LAMBDA(
+									MIN_SET(2);
+
+									for(unsigned long &i: derivation.reason.constraint_indexes) {
+										if(j <= i && i < k) {
+											print_bool(calculate_Aij(i, j));
+
+											// Space between terms
+											write_output(" ");
+											MIN_COUNT;
+										}
+									}
+
+									MIN_ENSURE_FALSE;
+								)
+							))
+						);
+						MIN_COUNT;
+					}
+				}
+
+				MIN_ENSURE_TRUE;
+			));
+			break;
+		case ReasonType::TypeUNS:
+			print_op1<OP_AND>(LAMBDA(
+				MIN_SET(2);
+
+				if constexpr(!E::aij_smt) {
+					print_bool(calculate_ASM_earlier(k, derivation));
+					write_output(" ");
+					MIN_COUNT;
+				}
+				else {
+					for(unsigned long id = 0; id < earlier_end; id++) {
+						unsigned long j = assumption_positions[id];
+
+						print_op2<OP_EQ>(
+							LAMBDA(print_bool(calculate_Aij(k, j))),
+							LAMBDA(print_op2<OP_OR>(
+								LAMBDA(print_op2<OP_AND>(
+									LAMBDA(print_bool(calculate_Aij(derivation.reason.get_i1(), j))),
+									LAMBDA(print_op2<OP_NEQ>(j, derivation.reason.get_l1()))
+								)),
+								LAMBDA(print_op2<OP_AND>(
+									LAMBDA(print_bool(calculate_Aij(derivation.reason.get_i2(), j))),
+									LAMBDA(print_op2<OP_NEQ>(j, derivation.reason.get_l2()))
+								))
+							))
+						);
+						MIN_COUNT;
+					}
+				}
+
+				MIN_ENSURE_TRUE;
+			));
+			break;
+		case ReasonType::TypeSOL:
+			print_op1<OP_AND>(LAMBDA(
+				MIN_SET(2);
+
+				if constexpr(!E::aij_smt) {
+					print_bool(calculate_ASM_earlier(k, derivation));
+					write_output(" ");
+					MIN_COUNT;
+					return;
+				}
+				else {
+					for(unsigned long id = 0; id < earlier_end; id++) {
+						print_op1<OP_NOT>(
+							LAMBDA(print_bool(calculate_Aij(k, assumption_positions[id])))
+						);
+						MIN_COUNT;
+					}
+				}
+
+				MIN_ENSURE_TRUE;
+			));
+			break;
+	}
+}
+
+void Certificate::print_PRV(unsigned long k, Derivation &derivation) {
+	print_op1<OP_AND>(LAMBDA(
+		MIN_SET(2);
+
+		for(unsigned long &j: derivation.reason.constraint_indexes) {
+			print_op2<OP_AND>(
+				LAMBDA(
+					print_op2<OP_L>(j, k)
+				),
+				LAMBDA(
+					print_op2<OP_GEQ>(j, LITERAL(0))
+				)
+			);
+			MIN_COUNT;
+		}
+
+		MIN_ENSURE_TRUE;
+	));
+}
+
+//////////////
+// Supports //
+//////////////
+
+void Certificate::add_support(vector<unsigned long> &support, Constraint &constraint) {
+	for(unsigned long position = 0; position < constraint.number_coefficients; position++) {
+		if(!constraint.coefficient_numbers[position].is_zero()) {
+			support.push_back(constraint.coefficient_indexes[position]);
+		}
+	}
+}
+
+// Support of the aggregated row of a LIN or RND derivation (rows with non-zero multipliers)
+void Certificate::add_support(vector<unsigned long> &support, Derivation &derivation) {
+	for(unsigned long data_position = 0; data_position < derivation.reason.constraint_indexes.size(); data_position++) {
+		if(derivation.reason.constraint_multipliers[data_position].is_zero()) {
+			continue;
+		}
+
+		add_support(support, constraints[derivation.reason.constraint_indexes[data_position]]);
+	}
+}
+
+void Certificate::sort_support(vector<unsigned long> &support) {
+	std::sort(support.begin(), support.end());
+	support.erase(std::unique(support.begin(), support.end()), support.end());
+}
+
+/**
+	Prints one term per column. In the full model every variable gets a term; otherwise only the
+	columns in the support do, since the terms of all other columns reduce to (= 0 0).
+
+	@param support Sorted columns where a coefficient may be non-zero
+	@param print_column Prints the term of a column
+*/
+template<typename E, typename F>
+void Certificate::print_columns(vector<unsigned long> &support, F &&print_column) {
+	if constexpr(E::full_model) {
+		for(unsigned long j = 0; j < number_variables; j++) {
+			print_column(j);
+		}
+	}
+	else {
+		// Keeps the enclosing conjunction with at least two arguments
+		if(support.empty()) {
+			print_bool(true);
+		}
+
+		for(unsigned long j: support) {
+			print_column(j);
+		}
+	}
+}
+
+template<typename E, typename PQ, typename PQP, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
+void Certificate::print_DOM(vector<unsigned long> &support, PQ &&a, P0 &&b, P1 &&eq, P2 &&geq, P3 &&leq, PQP &&aP, P4 &&bP, P5 &&eqP, P6 &&geqP, P7 &&leqP) {
+	print_op2<OP_OR>(
+		LAMBDA(
+			print_op2<OP_AND>(
+				LAMBDA(
+					print_columns<E>(support, [&] (unsigned long j) {
+						print_op2<OP_EQ>(LAMBDA(a(j)), LITERAL(0));
+					});
+				),
+				LAMBDA(
+					print_ifelse(
+						eq,
+						LAMBDA(
+							print_op2<OP_NEQ>(b, LITERAL(0))
+						),
+						LAMBDA(print_ifelse(
+							geq,
+							LAMBDA(print_op2<OP_G>(b, LITERAL(0))),
+							LAMBDA(print_ifelse(
+								leq,
+								LAMBDA(print_op2<OP_L>(b, LITERAL(0))),
+								LAMBDA(print_bool(false))
+							))
+						))
+					)
+				)
+			)
+		),
+		LAMBDA(
+			print_op2<OP_AND>(
+				LAMBDA(
+					print_columns<E>(support, [&] (unsigned long j) {
+						print_op2<OP_EQ>(LAMBDA(a(j)), LAMBDA(aP(j)));
+					});
+				),
+				LAMBDA(
+					print_ifelse(
+						eqP,
+						LAMBDA(
+							print_op2<OP_AND>(
+								eq,
+								LAMBDA(print_op2<OP_EQ>(b, bP))
+							)
+						),
+						LAMBDA(print_ifelse(
+							geqP,
+							LAMBDA(
+								print_op2<OP_AND>(
+									geq,
+									LAMBDA(print_op2<OP_GEQ>(b, bP))
+								)
+							),
+							LAMBDA(print_ifelse(
+								leqP,
+								LAMBDA(
+									print_op2<OP_AND>(
+										leq,
+										LAMBDA(print_op2<OP_LEQ>(b, bP))
+									)
+								),
+								LAMBDA(print_bool(false))
+							))
+						))
+					)
+				)
+			)
+		)
+	);
+}
+
+template<typename E, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5>
+void Certificate::print_DOM(vector<unsigned long> &support, P0 &&print_coefficientA, P1 &&print_directionA, P2 &&print_targetA, P3 &&print_coefficientB, P4 &&print_directionB, P5 &&print_targetB) {
+	print_DOM<E>(
+		support,
+		print_coefficientA,
+		print_targetA,
+		LAMBDA(print_op2<OP_EQ>(
+			print_directionA,
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_GEQ>(
+			print_directionA,
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_LEQ>(
+			print_directionA,
+			LITERAL(0)
+		)),
+		print_coefficientB,
+		print_targetB,
+		LAMBDA(print_op2<OP_EQ>(
+			print_directionB,
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_GEQ>(
+			print_directionB,
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_LEQ>(
+			print_directionB,
+			LITERAL(0)
+		))
+	);
+}
+
+template<typename E>
+void Certificate::print_DOM(Constraint &constraint1, Constraint &constraint2) {
+	vector<unsigned long> support;
+
+	add_support(support, constraint1);
+	add_support(support, constraint2);
+	sort_support(support);
+
+	print_DOM<E>(
+		support,
+		[&] (unsigned long j) {
+			print_number(constraint1.coefficients_at(j));
+		},
+		LAMBDA(print_number(constraint1.target)),
+		LAMBDA(print_op2<OP_EQ>(
+			LAMBDA(print_s(constraint1.direction)),
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_GEQ>(
+			LAMBDA(print_s(constraint1.direction)),
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_LEQ>(
+			LAMBDA(print_s(constraint1.direction)),
+			LITERAL(0)
+		)),
+		[&] (unsigned long j) {
+			print_number(constraint2.coefficients_at(j));
+		},
+		LAMBDA(print_number(constraint2.target)),
+		LAMBDA(print_op2<OP_EQ>(
+			LAMBDA(print_s(constraint2.direction)),
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_GEQ>(
+			LAMBDA(print_s(constraint2.direction)),
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_LEQ>(
+			LAMBDA(print_s(constraint2.direction)),
+			LITERAL(0)
+		))
+	);
+}
+
+template<typename E, typename P0, typename P1>
+void Certificate::print_RND(vector<unsigned long> &support, const function<void(unsigned long)> &a, P0 &&b, P1 &&eq) {
+	print_op1<OP_AND>(
+		LAMBDA(
+			MIN_SET(2);
+
+			if constexpr(E::full_model) {
+				for(unsigned long j: variable_integral_vector) {
+					print_op1<OP_INTEGRAL>(LAMBDA(a(j)));
+					MIN_COUNT;
+				}
+
+				for(unsigned long j: variable_non_integral_vector) {
+					print_op2<OP_EQ>(LAMBDA(a(j)), LITERAL(0));
+					MIN_COUNT;
+				}
+			}
+			else {
+				// Outside the support, a(j) is 0: (is_int 0) and (= 0 0) always hold
+				for(unsigned long j: support) {
+					if(variable_integral_flags[j]) {
+						print_op1<OP_INTEGRAL>(LAMBDA(a(j)));
+						MIN_COUNT;
+					}
+				}
+
+				for(unsigned long j: support) {
+					if(!variable_integral_flags[j]) {
+						print_op2<OP_EQ>(LAMBDA(a(j)), LITERAL(0));
+						MIN_COUNT;
+					}
+				}
+			}
+
+			print_op1<OP_NOT>(eq);
+			MIN_COUNT;
+
+			MIN_ENSURE_TRUE;
+		)
+	);
+}
+
+template<typename E>
+void Certificate::print_DIS(Constraint &c_i, Constraint &c_j) {
+	print_op1<OP_AND>(
+		LAMBDA(
+			// Not counting because the number of operations is always >= 2
+
+			// Column indexes increase in every loop: lookups gallop forward
+			unsigned long position_i = 0;
+			unsigned long position_j = 0;
+
+			if constexpr(E::full_model) {
+				for(unsigned long k = 0; k < number_variables; k++) {
+					print_op2<OP_EQ>(c_i.coefficients_at(k, position_i), c_j.coefficients_at(k, position_j));
+				}
+
+				position_i = 0;
+
+				for(unsigned long k: variable_integral_vector) {
+					print_op1<OP_INTEGRAL>(c_i.coefficients_at(k, position_i));
+				}
+
+				position_i = 0;
+
+				for(unsigned long k: variable_non_integral_vector) {
+					print_op2<OP_EQ>(c_i.coefficients_at(k, position_i), LITERAL(0));
+				}
+			}
+			else {
+				// Only columns where c_i or c_j is non-zero: every other term is trivially true
+				vector<unsigned long> support;
+
+				add_support(support, c_i);
+				add_support(support, c_j);
+				sort_support(support);
+
+				for(unsigned long k: support) {
+					print_op2<OP_EQ>(c_i.coefficients_at(k, position_i), c_j.coefficients_at(k, position_j));
+				}
+
+				for(unsigned long position = 0; position < c_i.number_coefficients; position++) {
+					if(variable_integral_flags[c_i.coefficient_indexes[position]] && !c_i.coefficient_numbers[position].is_zero()) {
+						print_op1<OP_INTEGRAL>(c_i.coefficient_numbers[position]);
+					}
+				}
+
+				for(unsigned long position = 0; position < c_i.number_coefficients; position++) {
+					if(!variable_integral_flags[c_i.coefficient_indexes[position]] && !c_i.coefficient_numbers[position].is_zero()) {
+						print_op2<OP_EQ>(c_i.coefficient_numbers[position], LITERAL(0));
+					}
+				}
+			}
 			
 			print_op1<OP_INTEGRAL>(c_i.target);
 			print_op1<OP_INTEGRAL>(c_j.target);
 
-			print_op2<OP_AND>(
-				LAMBDA(print_op2<OP_NEQ>(
-					LAMBDA(print_s(c_i.direction)),
-					LITERAL(0)
-				)),
-				LAMBDA(print_op2<OP_EQ>(
-					LAMBDA(print_op2<OP_PLUS>(
-						LAMBDA(print_s(c_i.direction)),
-						LAMBDA(print_s(c_j.direction))
-					)),
-					LITERAL(0)
-				))
-			);
+			print_op2<OP_AND>(
+				LAMBDA(print_op2<OP_NEQ>(
+					LAMBDA(print_s(c_i.direction)),
+					LITERAL(0)
+				)),
+				LAMBDA(print_op2<OP_EQ>(
+					LAMBDA(print_op2<OP_PLUS>(
+						LAMBDA(print_s(c_i.direction)),
+						LAMBDA(print_s(c_j.direction))
+					)),
+					LITERAL(0)
+				))
+			);
+
+			print_ifelse(
+				LAMBDA(print_op2<OP_EQ>(
+					LAMBDA(print_s(c_i.direction)),
+					LITERAL(1)
+				)),
+				LAMBDA(print_op2<OP_EQ>(
+					LAMBDA(print_number(c_i.target)),
+					LAMBDA(print_op2<OP_PLUS>(
+						LAMBDA(print_number(c_j.target)),
+						LITERAL(1)
+					))
+				)),
+				LAMBDA(print_op2<OP_EQ>(
+					LAMBDA(print_number(c_i.target)),
+					LAMBDA(print_op2<OP_MINUS>(
+						LAMBDA(print_number(c_j.target)),
+						LITERAL(1)
+					))
+				))
+			);
+		)
+	);
+}
+
+template<typename E>
+void Certificate::print_asm_individual(unsigned long derivation_index, Derivation &derivation) {
+	print_ASM<E>(derivation_index, derivation);
+}
+
+template<typename E>
+void Certificate::print_LIN_RND_aj(unsigned long derivation_index, Derivation &derivation, unsigned long j) {
+	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+
+	print_op1<OP_PLUS>(LAMBDA(
+		MIN_SET(2);
+
+		for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
+			// Using the same indexes as the definitions
+			unsigned long i = derivation.reason.constraint_indexes[data_position];
+			Number &data_i = derivation.reason.constraint_multipliers[data_position];
+
+			if constexpr(!E::full_model) {
+				if(data_i.is_zero() || constraints[i].coefficients_at(j).is_zero()) {
+					continue;
+				}
+			}
+
+			print_op2<OP_TIMES>(
+				data_i,
+				LAMBDA(print_number(constraints[i].coefficients_at(j)))
+			);
+			MIN_COUNT;
+		}
+
+		MIN_ENSURE_ZERO;
+	));
+}
+
+void Certificate::print_LIN_RND_aPj(unsigned long derivation_index, Derivation &derivation, unsigned long j) {
+	print_number(constraints[derivation_index].coefficients_at(j));
+}
+
+template<typename E>
+void Certificate::print_LIN_RND_b(unsigned long derivation_index, Derivation &derivation) {
+	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+
+	print_op1<OP_PLUS>(LAMBDA(
+		MIN_SET(2);
+
+		for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
+			// Using the same indexes as the definitions
+			unsigned long i = derivation.reason.constraint_indexes[data_position];
+			Number &data_i = derivation.reason.constraint_multipliers[data_position];
+
+			if constexpr(!E::full_model) {
+				if(data_i.is_zero() || constraints[i].target.is_zero()) {
+					continue;
+				}
+			}
+
+			print_op2<OP_TIMES>(
+				data_i,
+				LAMBDA(print_number(constraints[i].target))
+			);
+			MIN_COUNT;
+		}
+
+		MIN_ENSURE_ZERO;
+	));
+}
+
+void Certificate::print_LIN_RND_bP(unsigned long derivation_index, Derivation &derivation) {
+	print_number(constraints[derivation_index].target);
+}
+
+// Whether some premise with a non-zero multiplier has a non-zero target
+bool Certificate::has_LIN_RND_b(Derivation &derivation) {
+	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+
+	for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
+		// Using the same indexes as the definitions
+		unsigned long i = derivation.reason.constraint_indexes[data_position];
+		Number &data_i = derivation.reason.constraint_multipliers[data_position];
+
+		if(!data_i.is_zero() && !constraints[i].target.is_zero()) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+	Prints (let ((a<j> a(j)) ... (b b)) body), so that the aggregated row of a LIN or RND
+	derivation is printed once however many times the body uses it. Bindings that do not make
+	the output shorter once the body is folded (short values, or values used once) are
+	replaced back by their values. Columns outside the support, and b without contributing
+	premises, are the constant 0 and are not bound. In the full model nothing is bound.
+
+	@param support Sorted support of the aggregated row (add_support of the derivation)
+	@param body Called with the functions that print a(j) and b
+*/
+template<typename E, typename F>
+void Certificate::print_LIN_RND_let(unsigned long derivation_index, Derivation &derivation, vector<unsigned long> &support, F &&body) {
+	auto print_aj = [&] (unsigned long j) {
+		print_LIN_RND_aj<E>(derivation_index, derivation, j);
+	};
+
+	auto print_b = LAMBDA(print_LIN_RND_b<E>(derivation_index, derivation));
+
+	if constexpr(E::full_model) {
+		body(print_aj, print_b);
+		return;
+	}
+
+	// The term DAG shares the repeated a(j) and b by itself
+	if(term_dag != nullptr) {
+		body(print_aj, print_b);
+		return;
+	}
+
+	bool bind_b = has_LIN_RND_b(derivation);
+
+	auto a = [&] (unsigned long j) {
+		if(std::binary_search(support.begin(), support.end(), j)) {
+			print_symbol("a", j);
+		}
+		else {
+			print_inline_integer(0);
+		}
+	};
+
+	auto b = [&] {
+		if(bind_b) {
+			print_symbol("b");
+		}
+		else {
+			print_inline_integer(0);
+		}
+	};
+
+	// A let needs at least one binding
+	if(support.empty() && !bind_b) {
+		body(a, b);
+		return;
+	}
+
+	vector<LetBinding> bindings;
+
+	auto bind = [&] (auto &&print_name, auto &&print_value) {
+		size_t start = get_output_position();
+
+		write_output("(");
+		print_name();
+		size_t name_end = get_output_position();
+
+		write_output(" ");
+		print_value();
+		size_t value_end = get_output_position();
+
+		write_output(") ");
+
+		bindings.push_back(LetBinding{start, name_end, value_end});
+	};
+
+	begin_term(OP_LET);
+	write_output("(");
+
+	for(unsigned long j: support) {
+		bind(
+			LAMBDA(write_output("a"); write_inline_integer(j)),
+			LAMBDA(print_aj(j))
+		);
+	}
+
+	if(bind_b) {
+		bind(
+			LAMBDA(write_output("b")),
+			print_b
+		);
+	}
+
+	write_output(") ");
+
+	size_t body_start = get_output_position();
+	body(a, b);
+
+	// A constant body is folded by end_term instead
+	if(file_helper.is_buffered(frame_stack.back().start) && term_stack.back().kind == TermOpaque && !prune_let(bindings, body_start)) {
+		return;
+	}
+
+	end_term();
+}
+
+template<typename E>
+void Certificate::print_conjunction_eq_leq_geq(unsigned long derivation_index, Derivation &derivation, Direction direction) {
+	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+
+	print_op1<OP_AND>(LAMBDA(
+		MIN_SET(2);
+
+		for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
+			// Using the same indexes as the definitions
+			unsigned long i = derivation.reason.constraint_indexes[data_position];
+			Number &data_i = derivation.reason.constraint_multipliers[data_position];
+
+			if constexpr(!E::full_model) {
+				if(data_i.is_zero() || constraints[i].direction == Direction::Equal) {
+					continue;
+				}
+			}
+
+			print_direction_op2(
+				direction,
+				LAMBDA(
+					print_op2<OP_TIMES>(
+						data_i,
+						LAMBDA(print_s(constraints[i].direction))
+					)
+				),
+				LITERAL(0)
+			);
+			MIN_COUNT;
+		}
+
+		MIN_ENSURE_TRUE;
+	));
+}
+
+// Whether every (non-zero) multiplied premise is an equality
+bool Certificate::calculate_eq(Derivation &derivation) {
+	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+
+	for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
+		// Using the same indexes as the definitions
+		unsigned long i = derivation.reason.constraint_indexes[data_position];
+		Number &data_i = derivation.reason.constraint_multipliers[data_position];
+
+		if(!data_i.is_zero() && constraints[i].direction != Direction::Equal) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Whether the aggregation of the premises is a >= constraint
+bool Certificate::calculate_geq(Derivation &derivation) {
+	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+
+	for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
+		// Using the same indexes as the definitions
+		unsigned long i = derivation.reason.constraint_indexes[data_position];
+		Number &data_i = derivation.reason.constraint_multipliers[data_position];
+
+		if(!data_i.is_zero() && constraints[i].direction != Direction::Equal) {
+			if(data_i.is_negative() && constraints[i].direction == Direction::GreaterEqual) {
+				return false;
+			}
+			if(!data_i.is_negative() && constraints[i].direction == Direction::SmallerEqual) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Whether the aggregation of the premises is a <= constraint
+bool Certificate::calculate_leq(Derivation &derivation) {
+	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+
+	for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
+		// Using the same indexes as the definitions
+		unsigned long i = derivation.reason.constraint_indexes[data_position];
+		Number &data_i = derivation.reason.constraint_multipliers[data_position];
+
+		if(!data_i.is_zero() && constraints[i].direction != Direction::Equal) {
+			if(data_i.is_negative() && constraints[i].direction == Direction::SmallerEqual) {
+				return false;
+			}
+			if(!data_i.is_negative() && constraints[i].direction == Direction::GreaterEqual) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+template<typename E>
+void Certificate::print_eq(unsigned long derivation_index, Derivation &derivation) {
+	if constexpr(!E::eq_leq_geq_smt) {
+		print_bool(calculate_eq(derivation));
+		write_output(" ");
+		return;
+	}
+
+	print_conjunction_eq_leq_geq<E>(derivation_index, derivation, Direction::Equal);
+}
+
+template<typename E>
+void Certificate::print_geq(unsigned long derivation_index, Derivation &derivation) {
+	if constexpr(!E::eq_leq_geq_smt) {
+		print_bool(calculate_geq(derivation));
+		write_output(" ");
+		return;
+	}
+
+	print_conjunction_eq_leq_geq<E>(derivation_index, derivation, Direction::GreaterEqual);
+}
+
+template<typename E>
+void Certificate::print_leq(unsigned long derivation_index, Derivation &derivation) {
+	if constexpr(!E::eq_leq_geq_smt) {
+		print_bool(calculate_leq(derivation));
+		write_output(" ");
+		return;
+	}
+
+	print_conjunction_eq_leq_geq<E>(derivation_index, derivation, Direction::SmallerEqual);
+}
+
+template<typename E>
+void Certificate::print_lin_individual(unsigned long derivation_index, Derivation &derivation) {
+	print_op1<OP_AND>(LAMBDA(
+		// Not counting because the number of operations is always >= 2
+
+		print_ASM<E>(derivation_index, derivation);
+		print_PRV(derivation_index, derivation);
+
+		vector<unsigned long> aggregation_support;
+
+		add_support(aggregation_support, derivation);
+		sort_support(aggregation_support);
+
+		vector<unsigned long> support(aggregation_support);
+
+		add_support(support, constraints[derivation_index]);
+		sort_support(support);
+
+		print_LIN_RND_let<E>(derivation_index, derivation, aggregation_support, [&] (auto &&a, auto &&b) {
+			print_DOM<E>(
+				support,
+				a,
+				b,
+				LAMBDA(print_eq<E>(derivation_index, derivation)),
+				LAMBDA(print_geq<E>(derivation_index, derivation)),
+				LAMBDA(print_leq<E>(derivation_index, derivation)),
+				[&] (unsigned long j) {
+					print_LIN_RND_aPj(derivation_index, derivation, j);
+				},
+				LAMBDA(print_LIN_RND_bP(derivation_index, derivation)),
+				LAMBDA(print_op2<OP_EQ>(
+					LAMBDA(print_s(constraints[derivation_index].direction)),
+					LITERAL(0)
+				)),
+				LAMBDA(print_op2<OP_GEQ>(
+					LAMBDA(print_s(constraints[derivation_index].direction)),
+					LITERAL(0)
+				)),
+				LAMBDA(print_op2<OP_LEQ>(
+					LAMBDA(print_s(constraints[derivation_index].direction)),
+					LITERAL(0)
+				))
+			);
+		});
+	));
+}
+
+template<typename E, typename PQ, typename PQP, typename P0, typename P1, typename P2, typename P3, typename P4>
+void Certificate::print_rnd_individual_part2(vector<unsigned long> &support, PQ &&a, P0 &&b, P1 &&eq, P2 &&geq, P3 &&leq, PQP &&aP, P4 &&bP, unsigned long derivation_index) {
+	print_op2<OP_OR>(
+		LAMBDA(
+			print_op2<OP_AND>(
+				LAMBDA(
+					print_columns<E>(support, [&] (unsigned long j) {
+						print_op2<OP_EQ>(LAMBDA(a(j)), LITERAL(0));
+					});
+				),
+				LAMBDA(
+					print_ifelse(
+						geq,
+						LAMBDA(print_op2<OP_G>(b, LITERAL(0))),
+						LAMBDA(print_ifelse(
+							leq,
+							LAMBDA(print_op2<OP_L>(b, LITERAL(0))),
+							LAMBDA(print_bool(false))
+						))
+					)
+				)
+			)
+		),
+		LAMBDA(
+			print_op2<OP_AND>(
+				LAMBDA(
+					print_columns<E>(support, [&] (unsigned long j) {
+						print_op2<OP_EQ>(LAMBDA(a(j)), LAMBDA(aP(j)));
+					});
+				),
+				LAMBDA(
+					print_ifelse(
+						LAMBDA(
+							print_op2<OP_EQ>(
+								LAMBDA(print_s(constraints[derivation_index].direction)),
+								LITERAL(1)
+							)
+						),
+						LAMBDA(
+							print_op2<OP_AND>(
+								geq,
+								LAMBDA(print_op2<OP_GEQ>(
+									LAMBDA(print_ceil(b)),
+									bP
+								))
+							)
+						),
+						LAMBDA(
+							print_op2<OP_AND>(
+								leq,
+								LAMBDA(print_op2<OP_LEQ>(
+									LAMBDA(print_op1<OP_RND_DOWN>(b)),
+									bP
+								))
+							)
+						)
+					)
+				)
+			)
+		)
+	);
+}
+
+template<typename E>
+void Certificate::print_rnd_individual(unsigned long derivation_index, Derivation &derivation) {
+	print_op1<OP_AND>(LAMBDA(
+		// Not counting because the number of operations is always >= 2
+
+		print_ASM<E>(derivation_index, derivation);
+		print_PRV(derivation_index, derivation);
+
+		// Support of the aggregated row, then extended with the derived row
+		vector<unsigned long> aggregation_support;
+
+		add_support(aggregation_support, derivation);
+		sort_support(aggregation_support);
+
+		vector<unsigned long> support(aggregation_support);
+
+		add_support(support, constraints[derivation_index]);
+		sort_support(support);
+
+		print_LIN_RND_let<E>(derivation_index, derivation, aggregation_support, [&] (auto &&a, auto &&b) {
+			print_op1<OP_AND>(LAMBDA(
+				// Not counting because the number of operations is always >= 2
+
+				print_RND<E>(
+					aggregation_support,
+					a,
+					b,
+					LAMBDA(print_eq<E>(derivation_index, derivation))
+				);
+
+				print_op2<OP_NEQ>(
+					LAMBDA(print_s(constraints[derivation_index].direction)),
+					LITERAL(0)
+				);
+
+				print_rnd_individual_part2<E>(
+					support,
+					a,
+					b,
+					LAMBDA(print_eq<E>(derivation_index, derivation)),
+					LAMBDA(print_geq<E>(derivation_index, derivation)),
+					LAMBDA(print_leq<E>(derivation_index, derivation)),
+					[&] (unsigned long j) {
+						print_LIN_RND_aPj(derivation_index, derivation, j);
+					},
+					LAMBDA(print_LIN_RND_bP(derivation_index, derivation)),
+					derivation_index
+				);
+			));
+		});
+	));
+}
+
+template<typename E>
+void Certificate::print_uns_individual(unsigned long derivation_index, Derivation &derivation) {
+	print_op1<OP_AND>(LAMBDA(
+		// Not counting because the number of operations is always >= 2
+
+		print_ASM<E>(derivation_index, derivation);
+		write_output(" ");
+		print_op2<OP_G>(derivation_index, derivation.reason.get_i1());
+		write_output(" ");
+		print_op2<OP_G>(derivation_index, derivation.reason.get_i2());
+		write_output(" ");
+		print_DOM<E>(constraints[derivation.reason.get_i1()], derivation.get_constraint(constraints));
+		write_output(" ");
+		print_DOM<E>(constraints[derivation.reason.get_i2()], derivation.get_constraint(constraints));
+		write_output(" ");
+		print_op2<OP_G>(derivation_index, derivation.reason.get_l1());
+		write_output(" ");
+		print_op2<OP_G>(derivation_index, derivation.reason.get_l2());
+		write_output(" ");
+		print_DIS<E>(constraints[derivation.reason.get_l1()], constraints[derivation.reason.get_l2()]);
+	));
+}
+
+template<typename E>
+void Certificate::print_sol_individual_dom(Solution &solution, Direction direction, Constraint &constraint2, vector<unsigned long> &support) {
+	print_DOM<E>(
+		support,
+		[&] (unsigned long j) {
+			print_number(objective_coefficients[j]);
+		},
+		LAMBDA(
+			print_op1<OP_PLUS>(LAMBDA(
+				MIN_SET(2);
+
+				for(unsigned long i = 0; i < number_variables; i++) {
+					if constexpr(!E::full_model) {
+						if(objective_coefficients[i].is_zero() || solution.assignments[i].is_zero()) {
+							continue;
+						}
+					}
+
+					MIN_COUNT;
+
+					print_op2<OP_TIMES>(
+						objective_coefficients[i],
+						solution.assignments[i]
+					);
+				}
+
+				MIN_ENSURE_ZERO;
+			))
+		),
+		LAMBDA(print_op2<OP_EQ>(
+			LAMBDA(print_s(direction)),
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_GEQ>(
+			LAMBDA(print_s(direction)),
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_LEQ>(
+			LAMBDA(print_s(direction)),
+			LITERAL(0)
+		)),
+		[&] (unsigned long j) {
+			print_number(constraint2.coefficients_at(j));
+		},
+		LAMBDA(print_number(constraint2.target)),
+		LAMBDA(print_op2<OP_EQ>(
+			LAMBDA(print_s(constraint2.direction)),
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_GEQ>(
+			LAMBDA(print_s(constraint2.direction)),
+			LITERAL(0)
+		)),
+		LAMBDA(print_op2<OP_LEQ>(
+			LAMBDA(print_s(constraint2.direction)),
+			LITERAL(0)
+		))
+	);
+}
+
+template<typename E>
+void Certificate::print_sol_individual(unsigned long derivation_index, Derivation &derivation) {
+	vector<unsigned long> support(objective_support);
+
+	add_support(support, derivation.get_constraint(constraints));
+	sort_support(support);
+
+	print_op2<OP_AND>(
+		LAMBDA(
+			print_ASM<E>(derivation_index, derivation);
+		),
+		LAMBDA(
+			print_ifelse(
+				minimization,
+				LAMBDA(
+					print_op1<OP_OR>(LAMBDA(
+						MIN_SET(2);
+
+						for(Solution &solution: solutions) {
+							print_sol_individual_dom<E>(
+								solution,
+								Direction::SmallerEqual,
+								derivation.get_constraint(constraints),
+								support
+							);
+							MIN_COUNT;
+						}
+
+						MIN_ENSURE_FALSE;
+					));
+				),
+				LAMBDA(
+					print_op1<OP_OR>(LAMBDA(
+						MIN_SET(2);
+
+						for(Solution &solution: solutions) {
+							print_sol_individual_dom<E>(
+								solution,
+								Direction::GreaterEqual,
+								derivation.get_constraint(constraints),
+								support
+							);
+							MIN_COUNT;
+						}
+
+						MIN_ENSURE_FALSE;
+					));
+				)
+			);
+		)
+	);
+}
+
+template<typename E>
+void Certificate::print_der_individual(unsigned long derivation_index, Derivation &derivation) {
+	switch(derivation.reason.type) {
+		case ReasonType::TypeASM:
+			print_asm_individual<E>(derivation_index, derivation);
+			break;
+		case ReasonType::TypeLIN:
+			print_lin_individual<E>(derivation_index, derivation);
+			break;
+		case ReasonType::TypeRND:
+			print_rnd_individual<E>(derivation_index, derivation);
+			break;
+		case ReasonType::TypeUNS:
+			print_uns_individual<E>(derivation_index, derivation);
+			break;
+		case ReasonType::TypeSOL:
+			print_sol_individual<E>(derivation_index, derivation);
+			break;
+	}
+}
+
+template<typename E>
+void Certificate::print_der_derivation(unsigned long j) {
+	Derivation &derivation = get_derivation_from_offset(j);
+
+	write_output("; DER for constraint ");
+	write_string(constraints.get_name(derivation.constraint_index));
+	write_output("\n");
+
+	if(dag) {
+		thread_local string text;
+
+		DagTerm *formula = build_der_derivation<E>(der_dag, j);
+
+		text.assign("(assert ");
+		der_dag.write_smt(formula, text);
+		text.append(")");
+
+		write_output(text.data(), text.size());
 
-			print_ifelse(
-				LAMBDA(print_op2<OP_EQ>(
-					LAMBDA(print_s(c_i.direction)),
-					LITERAL(1)
+		add_dag_cost(der_dag, formula, text.size() - strlen("(assert )"));
+	}
+	else {
+		print_op1<OP_ASSERT>(LAMBDA(
+			print_op1<OP_AND>(LAMBDA(
+				print_der_individual<E>(j, derivation);
+			));
+		));
+	}
+
+	// Lines between assertions
+	write_output("\n");
+}
+
+template<typename E>
+void Certificate::print_der_solcheck() {
+	write_output("; Begin DER (solution check)\n");
+
+	print_op1<OP_ASSERT>(LAMBDA(
+		unsigned long last_constraint_index = number_total_constraints - 1;
+		Constraint &last_constraint = constraints[last_constraint_index];
+
+		// Compared with 0 >= 1 (infeasible) or with the objective (feasible)
+		vector<unsigned long> last_support;
+		vector<unsigned long> objective_last_support(objective_support);
+
+		add_support(last_support, last_constraint);
+
+		add_support(objective_last_support, last_constraint);
+		sort_support(objective_last_support);
+
+		print_ifelse(
+			LAMBDA(print_op1<OP_NOT>(feasible)),
+			LAMBDA(print_op2<OP_AND>(
+				LAMBDA(print_DOM<E>(
+					last_support,
+					[&] (unsigned long j) {
+						print_number(last_constraint.coefficients_at(j));
+					},
+					LAMBDA(print_s(last_constraint.direction)),
+					LAMBDA(print_number(last_constraint.target)),
+					[&] (unsigned long j) {
+						print_inline_integer(0);
+					},
+					LAMBDA(print_s(Direction::GreaterEqual)),
+					LAMBDA(print_inline_integer(1))
 				)),
-				LAMBDA(print_op2<OP_EQ>(
-					LAMBDA(print_number(c_i.target)),
-					LAMBDA(print_op2<OP_PLUS>(
-						LAMBDA(print_number(c_j.target)),
-						LITERAL(1)
+				LAMBDA(
+					for(unsigned long id = 0; id < number_assumptions; id++) {
+						print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(last_constraint_index, assumption_positions[id]))));
+					}
+				)
+			)),
+			LAMBDA(print_op2<OP_AND>(
+				LAMBDA(print_op2<OP_IMPLICATION>(
+					LAMBDA(print_op2<OP_AND>(
+						minimization,
+						LAMBDA(print_plb())
+					)),
+					LAMBDA(print_op2<OP_AND>(
+						LAMBDA(print_DOM<E>(
+							objective_last_support,
+							[&] (unsigned long j) {
+								print_number(last_constraint.coefficients_at(j));
+							},
+							LAMBDA(print_s(last_constraint.direction)),
+							LAMBDA(print_number(last_constraint.target)),
+							[&] (unsigned long j) {
+								print_number(objective_coefficients[j]);
+							},
+							LAMBDA(print_s(Direction::GreaterEqual)),
+							LAMBDA(print_number(get_L()))
+						)),
+						LAMBDA(
+							for(unsigned long id = 0; id < number_assumptions; id++) {
+								print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(last_constraint_index, assumption_positions[id]))));
+							}
+						)
 					))
 				)),
-				LAMBDA(print_op2<OP_EQ>(
-					LAMBDA(print_number(c_i.target)),
-					LAMBDA(print_op2<OP_MINUS>(
-						LAMBDA(print_number(c_j.target)),
-						LITERAL(1)
+				LAMBDA(print_op2<OP_IMPLICATION>(
+					LAMBDA(print_op2<OP_AND>(
+						LAMBDA(print_op1<OP_NOT>(
+							minimization
+						)),
+						LAMBDA(print_pub())
+					)),
+					LAMBDA(print_op2<OP_AND>(
+						LAMBDA(print_DOM<E>(
+							objective_last_support,
+							[&] (unsigned long j) {
+								print_number(last_constraint.coefficients_at(j));
+							},
+							LAMBDA(print_s(last_constraint.direction)),
+							LAMBDA(print_number(last_constraint.target)),
+							[&] (unsigned long j) {
+								print_number(objective_coefficients[j]);
+							},
+							LAMBDA(print_s(Direction::SmallerEqual)),
+							LAMBDA(print_number(get_U()))
+						)),
+						LAMBDA(
+							for(unsigned long id = 0; id < number_assumptions; id++) {
+								print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(last_constraint_index, assumption_positions[id]))));
+							}
+						)
 					))
 				))
-			);
+			))
 		)
-	);
+	));
+}
+
+void Certificate::print_der_block(unsigned long global_index_start, unsigned long global_index_finish) {
+	// In hybrid mode, derivations settled natively are left out of the block
+	vector<unsigned long> smt_derivations;
+
+	for(unsigned long j = global_index_start; j <= global_index_finish; j++) {
+		if(!hybrid || !settle_natively(j)) {
+			smt_derivations.push_back(j);
+		}
+	}
+
+	if(smt_derivations.empty()) {
+		return;
+	}
+
+	// Open the file for block number and print header
+	string section_output_filename = output_filename + ".DER-" + std::to_string(global_index_start - number_problem_constraints + 1) + "-" + std::to_string(global_index_finish - number_problem_constraints + 1);
+
+	open_output(section_output_filename);
+	print_header();
+
+	with_encoding([&] (auto encoding) {
+		for(unsigned long j: smt_derivations) {
+			print_der_derivation<decltype(encoding)>(j);
+		}
+	});
+
+	// Print footer and close the file for block number
+	print_footer();
+	output_length += close_output();
+
+	// Dispatches the work to the execution manager
+	remote_execution_manager.dispatch(section_output_filename, 0);
+}
+
+void Certificate::print_der_solcheck_block() {
+	// Open the file for the solution check and print header
+	string section_output_filename = output_filename + ".DER-solcheck";
+
+	open_output(section_output_filename);
+	print_header();
+
+	with_encoding([&] (auto encoding) {
+		print_der_solcheck<decltype(encoding)>();
+	});
+
+	// Print footer and close the file for the solution check
+	print_footer();
+	output_length += close_output();
+
+	// Dispatches the work to the execution manager
+	remote_execution_manager.dispatch(section_output_filename, 0);
+}
+
+void Certificate::print_der() {
+	if(!mode.parallel) {
+		with_encoding([&] (auto encoding) {
+			using E = decltype(encoding);
+
+			for(unsigned long i = number_problem_constraints; i < number_total_constraints; i++) {
+				if(hybrid && settle_natively(i)) {
+					continue;
+				}
+
+				print_der_derivation<E>(i);
+			}
+
+			print_der_solcheck<E>();
+		});
+
+		return;
+	}
+
+	unsigned long number_blocks = std::ceil(static_cast<float>(number_derived_constraints) / block_size);
+
+	unsigned long total_cores = std::min(2 * static_cast<unsigned long>(std::thread::hardware_concurrency()), number_blocks);
+
+	// Hybrid runs may settle every derivation natively: then no block is written or dispatched
+	bool dispatching = (total_cores > 0);
+
+	if(hybrid) {
+		dispatching = false;
+
+		for(unsigned long i = number_problem_constraints; i < number_total_constraints && !dispatching; i++) {
+			dispatching = is_selected_for_smt(i);
+		}
+	}
+
+	if(dispatching) {
+		fprintf(stderr, "Running DER generation with %lu parallel cores and block size %lu\n", total_cores, block_size);
+	}
+
+	// Threads outlive this function: capture by value
+	for(unsigned long core = 0; core < total_cores; core++) {
+		threads.emplace_back([=, this] {
+			for(unsigned long derived_index = (core * block_size); derived_index < number_derived_constraints; derived_index += (total_cores * block_size)) {
+				// Calculate global indexes
+				unsigned long global_index_start = derived_index + number_problem_constraints;
+				unsigned long global_index_finish = std::min(global_index_start + block_size, number_total_constraints) - 1;
+
+				print_der_block(global_index_start, global_index_finish);
+			}
+		});
+	}
+
+	threads.emplace_back([this] {
+		print_der_solcheck_block();
+	});
+}
+
+/////////////////////
+// Native checking //
+/////////////////////
+
+// Value of print_s
+static inline int get_s(Direction direction) {
+	switch(direction) {
+		case Direction::SmallerEqual:
+			return -1;
+		case Direction::Equal:
+			return 0;
+		case Direction::GreaterEqual:
+			return 1;
+	}
+
+	return 0;
+}
+
+// Non-zero coefficients of a constraint (sorted by column)
+void Certificate::get_native_row(Constraint &constraint, NativeRow &row) {
+	row.clear();
+
+	for(unsigned long position = 0; position < constraint.number_coefficients; position++) {
+		if(!constraint.coefficient_numbers[position].is_zero()) {
+			row.emplace_back(constraint.coefficient_indexes[position], Rational(constraint.coefficient_numbers[position]));
+		}
+	}
+}
+
+/**
+	Aggregates the premises of a LIN or RND derivation: the non-zero coefficients of the sum
+	of the rows weighted by their multipliers (sorted by column), and the weighted sum of
+	their right-hand sides.
+
+	@param derivation LIN or RND derivation
+	@param row Aggregated coefficients (output)
+	@param target Aggregated right-hand side (output)
+*/
+void Certificate::get_native_aggregation(Derivation &derivation, NativeRow &row, Rational &target) {
+	NativeRow terms;
+
+	target = Rational();
+
+	for(unsigned long data_position = 0; data_position < derivation.reason.constraint_indexes.size(); data_position++) {
+		Number &data_i = derivation.reason.constraint_multipliers[data_position];
+
+		if(data_i.is_zero()) {
+			continue;
+		}
+
+		Constraint &constraint = constraints[derivation.reason.constraint_indexes[data_position]];
+		Rational multiplier(data_i);
+
+		for(unsigned long position = 0; position < constraint.number_coefficients; position++) {
+			if(!constraint.coefficient_numbers[position].is_zero()) {
+				terms.emplace_back(constraint.coefficient_indexes[position], multiplier * Rational(constraint.coefficient_numbers[position]));
+			}
+		}
+
+		if(!constraint.target.is_zero()) {
+			target += multiplier * Rational(constraint.target);
+		}
+	}
+
+	std::stable_sort(terms.begin(), terms.end(), [] (const auto &a, const auto &b) {
+		return a.first < b.first;
+	});
+
+	row.clear();
+
+	for(unsigned long position = 0; position < terms.size(); ) {
+		unsigned long column = terms[position].first;
+		Rational sum = std::move(terms[position].second);
+
+		for(position++; position < terms.size() && terms[position].first == column; position++) {
+			sum += terms[position].second;
+		}
+
+		if(!sum.is_zero()) {
+			row.emplace_back(column, std::move(sum));
+		}
+	}
+}
+
+/**
+	Value of print_DOM: whether a <= / = / >= b (as given by eq, geq and leq) dominates
+	aP <= / = / >= bP, either by being infeasible or by implying it.
+
+	@param a Non-zero coefficients of the dominating row
+	@param b Right-hand side of the dominating row
+	@param eq Whether the dominating row is an equality
+	@param geq Whether the dominating row is a >= constraint
+	@param leq Whether the dominating row is a <= constraint
+	@param aP Non-zero coefficients of the dominated row
+	@param bP Right-hand side of the dominated row
+	@param directionP Direction of the dominated row
+*/
+bool Certificate::check_DOM(NativeRow &a, Rational &b, bool eq, bool geq, bool leq, NativeRow &aP, Rational &bP, Direction directionP) {
+	if(a.empty()) {
+		if(eq ? !b.is_zero() : (geq ? b.sign() > 0 : (leq && b.sign() < 0))) {
+			return true;
+		}
+	}
+
+	if(a != aP) {
+		return false;
+	}
+
+	switch(directionP) {
+		case Direction::Equal:
+			return (eq && b == bP);
+		case Direction::GreaterEqual:
+			return (geq && b >= bP);
+		case Direction::SmallerEqual:
+			return (leq && b <= bP);
+	}
+
+	return false;
+}
+
+bool Certificate::check_DOM(Constraint &constraint1, Constraint &constraint2) {
+	NativeRow a;
+	NativeRow aP;
+
+	get_native_row(constraint1, a);
+	get_native_row(constraint2, aP);
+
+	Rational b(constraint1.target);
+	Rational bP(constraint2.target);
+
+	int s = get_s(constraint1.direction);
+
+	return check_DOM(a, b, s == 0, s >= 0, s <= 0, aP, bP, constraint2.direction);
+}
+
+bool Certificate::check_ASM(unsigned long k, Derivation &derivation) {
+	if(derivation.reason.type == ReasonType::TypeASM && !calculate_Aij(k, k)) {
+		return false;
+	}
+
+	return (calculate_ASM_later(k) && calculate_ASM_earlier(k, derivation));
+}
+
+bool Certificate::check_PRV(unsigned long k, Derivation &derivation) {
+	for(unsigned long &j: derivation.reason.constraint_indexes) {
+		if(j >= k) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Certificate::check_DIS(Constraint &c_i, Constraint &c_j) {
+	NativeRow row_i;
+	NativeRow row_j;
+
+	get_native_row(c_i, row_i);
+	get_native_row(c_j, row_j);
+
+	if(row_i != row_j) {
+		return false;
+	}
+
+	for(auto &[column, coefficient]: row_i) {
+		if(!variable_integral_flags[column] || !coefficient.is_integral()) {
+			return false;
+		}
+	}
+
+	Rational target_i(c_i.target);
+	Rational target_j(c_j.target);
+
+	if(!target_i.is_integral() || !target_j.is_integral()) {
+		return false;
+	}
+
+	int s_i = get_s(c_i.direction);
+	int s_j = get_s(c_j.direction);
+
+	if(s_i == 0 || s_i + s_j != 0) {
+		return false;
+	}
+
+	return (target_i == target_j + Rational(s_i == 1 ? 1 : -1));
+}
+
+bool Certificate::check_lin_individual(unsigned long derivation_index, Derivation &derivation) {
+	if(!check_ASM(derivation_index, derivation) || !check_PRV(derivation_index, derivation)) {
+		return false;
+	}
+
+	NativeRow a;
+	NativeRow aP;
+	Rational b;
+
+	get_native_aggregation(derivation, a, b);
+	get_native_row(constraints[derivation_index], aP);
+
+	Rational bP(constraints[derivation_index].target);
+
+	return check_DOM(a, b, calculate_eq(derivation), calculate_geq(derivation), calculate_leq(derivation), aP, bP, constraints[derivation_index].direction);
+}
+
+bool Certificate::check_rnd_individual(unsigned long derivation_index, Derivation &derivation) {
+	if(!check_ASM(derivation_index, derivation) || !check_PRV(derivation_index, derivation)) {
+		return false;
+	}
+
+	NativeRow a;
+	Rational b;
+
+	get_native_aggregation(derivation, a, b);
+
+	// RND: integral coefficients on integral variables only, and not an equality
+	for(auto &[column, coefficient]: a) {
+		if(!variable_integral_flags[column] || !coefficient.is_integral()) {
+			return false;
+		}
+	}
+
+	if(calculate_eq(derivation)) {
+		return false;
+	}
+
+	Constraint &derived = constraints[derivation_index];
+
+	int s = get_s(derived.direction);
+
+	if(s == 0) {
+		return false;
+	}
+
+	bool geq = calculate_geq(derivation);
+	bool leq = calculate_leq(derivation);
+
+	if(a.empty() && (geq ? b.sign() > 0 : (leq && b.sign() < 0))) {
+		return true;
+	}
+
+	NativeRow aP;
+
+	get_native_row(derived, aP);
+
+	if(a != aP) {
+		return false;
+	}
+
+	Rational bP(derived.target);
+
+	if(s == 1) {
+		return (geq && Rational(b.ceil()) >= bP);
+	}
+	else {
+		return (leq && Rational(b.floor()) <= bP);
+	}
+}
+
+bool Certificate::check_uns_individual(unsigned long derivation_index, Derivation &derivation) {
+	Reason &reason = derivation.reason;
+
+	if(!check_ASM(derivation_index, derivation)) {
+		return false;
+	}
+
+	if(derivation_index <= reason.get_i1() || derivation_index <= reason.get_i2() || derivation_index <= reason.get_l1() || derivation_index <= reason.get_l2()) {
+		return false;
+	}
+
+	return (check_DOM(constraints[reason.get_i1()], derivation.get_constraint(constraints)) && check_DOM(constraints[reason.get_i2()], derivation.get_constraint(constraints)) && check_DIS(constraints[reason.get_l1()], constraints[reason.get_l2()]));
 }
 
-void Certificate::print_asm_individual(unsigned long derivation_index, Derivation &derivation) {
-	print_ASM(derivation_index, derivation);
+bool Certificate::check_sol_individual(unsigned long derivation_index, Derivation &derivation) {
+	if(!check_ASM(derivation_index, derivation)) {
+		return false;
+	}
+
+	NativeRow aP;
+
+	get_native_row(derivation.get_constraint(constraints), aP);
+
+	Rational bP(derivation.get_constraint(constraints).target);
+
+	// The objective value of one of the solutions bounds the derived constraint
+	int s = get_s(minimization ? Direction::SmallerEqual : Direction::GreaterEqual);
+
+	for(Rational &objective_value: native_objective_values) {
+		if(check_DOM(native_objective_row, objective_value, s == 0, s >= 0, s <= 0, aP, bP, derivation.get_constraint(constraints).direction)) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
-void Certificate::print_LIN_RND_aj(unsigned long derivation_index, Derivation &derivation, unsigned long j) {
-	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+bool Certificate::check_der_individual(unsigned long derivation_index, Derivation &derivation) {
+	switch(derivation.reason.type) {
+		case ReasonType::TypeASM:
+			return check_ASM(derivation_index, derivation);
+		case ReasonType::TypeLIN:
+			return check_lin_individual(derivation_index, derivation);
+		case ReasonType::TypeRND:
+			return check_rnd_individual(derivation_index, derivation);
+		case ReasonType::TypeUNS:
+			return check_uns_individual(derivation_index, derivation);
+		case ReasonType::TypeSOL:
+			return check_sol_individual(derivation_index, derivation);
+	}
 
-	print_op1<OP_PLUS>(LAMBDA(
-		MIN_SET(2);
+	return false;
+}
 
-		for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
-			// Using the same indexes as the definitions
-			unsigned long i = derivation.reason.constraint_indexes[data_position];
-			Number &data_i = derivation.reason.constraint_multipliers[data_position];
+bool Certificate::check_der_derivation(unsigned long j) {
+	try {
+		if(dag) {
+			// Evaluates the formula that would be written for the derivation
+			DagTerm *formula = nullptr;
 
-#ifndef FULL_MODEL
-			if(data_i.is_zero() || constraints[i].coefficients_at(j).is_zero()) {
-				continue;
-			}
-#endif /* FULL_MODEL */
+			with_encoding([&] (auto encoding) {
+				formula = build_der_derivation<decltype(encoding)>(der_dag, j);
+			});
 
-			print_op2<OP_TIMES>(
-				data_i,
-				LAMBDA(print_number(constraints[i].coefficients_at(j)))
-			);
-			MIN_COUNT;
+			add_dag_cost(der_dag, formula, 0);
+
+			return !der_dag.evaluate(formula).is_zero();
 		}
 
-		MIN_ENSURE_ZERO;
-	));
-}
+		return check_der_individual(j, get_derivation_from_offset(j));
+	}
+	catch(runtime_error &error) {
+		// Values the SMT formula could not express either (such as infinities)
+		fprintf(stderr, "%s", error.what());
 
-void Certificate::print_LIN_RND_aPj(unsigned long derivation_index, Derivation &derivation, unsigned long j) {
-	print_number(constraints[derivation_index].coefficients_at(j));
+		return false;
+	}
 }
 
-void Certificate::print_LIN_RND_b(unsigned long derivation_index, Derivation &derivation) {
-	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+bool Certificate::check_der_solcheck() {
+	unsigned long last_constraint_index = number_total_constraints - 1;
+	Constraint &last_constraint = constraints[last_constraint_index];
 
-	print_op1<OP_PLUS>(LAMBDA(
-		MIN_SET(2);
+	// Wherever the last constraint is compared, it may not depend on any assumption
+	bool assumption_free = (dependencies[last_constraint_index] == nullptr || dependencies[last_constraint_index]->empty());
 
-		for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
-			// Using the same indexes as the definitions
-			unsigned long i = derivation.reason.constraint_indexes[data_position];
-			Number &data_i = derivation.reason.constraint_multipliers[data_position];
+	NativeRow a;
 
-#ifndef FULL_MODEL
-			if(data_i.is_zero() || constraints[i].target.is_zero()) {
-				continue;
-			}
-#endif /* FULL_MODEL */
+	get_native_row(last_constraint, a);
 
-			print_op2<OP_TIMES>(
-				data_i,
-				LAMBDA(print_number(constraints[i].target))
-			);
-			MIN_COUNT;
-		}
+	Rational b(last_constraint.target);
 
-		MIN_ENSURE_ZERO;
-	));
-}
+	int s = get_s(last_constraint.direction);
 
-void Certificate::print_LIN_RND_bP(unsigned long derivation_index, Derivation &derivation) {
-	print_number(constraints[derivation_index].target);
-}
+	if(!feasible) {
+		// Dominates 0 >= 1
+		NativeRow aP;
+		Rational bP(1);
 
-void Certificate::print_conjunction_eq_leq_geq(unsigned long derivation_index, Derivation &derivation, Direction direction) {
-	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+		return (check_DOM(a, b, s == 0, s >= 0, s <= 0, aP, bP, Direction::GreaterEqual) && assumption_free);
+	}
 
-	print_op1<OP_AND>(LAMBDA(
-		MIN_SET(2);
+	if(minimization && get_PLB()) {
+		Rational bP(get_L());
 
-		for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
-			// Using the same indexes as the definitions
-			unsigned long i = derivation.reason.constraint_indexes[data_position];
-			Number &data_i = derivation.reason.constraint_multipliers[data_position];
+		return (check_DOM(a, b, s == 0, s >= 0, s <= 0, native_objective_row, bP, Direction::GreaterEqual) && assumption_free);
+	}
 
-#ifndef FULL_MODEL
-			if(data_i.is_zero() || constraints[i].direction == Direction::Equal) {
-				continue;
-			}
-#endif /* FULL_MODEL */
+	if(!minimization && get_PUB()) {
+		Rational bP(get_U());
 
-			print_direction_op2(
-				direction,
-				LAMBDA(
-					print_op2<OP_TIMES>(
-						data_i,
-						LAMBDA(print_s(constraints[i].direction))
-					)
-				),
-				LITERAL(0)
-			);
-			MIN_COUNT;
-		}
+		return (check_DOM(a, b, s == 0, s >= 0, s <= 0, native_objective_row, bP, Direction::SmallerEqual) && assumption_free);
+	}
 
-		MIN_ENSURE_TRUE;
-	));
+	return true;
 }
 
-void Certificate::print_eq(unsigned long derivation_index, Derivation &derivation) {
-#ifndef EQ_LEQ_GEG_SMT
-	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+// Value of the two implications of print_feas_individual for one problem constraint
+bool Certificate::check_feas_constraint(Constraint &constraint, vector<Number> &assignments) {
+	Rational activity = sparse_dot(constraint.coefficient_indexes, constraint.coefficient_numbers, constraint.number_coefficients, assignments.data());
 
-	bool result = true;
+	Rational target(constraint.target);
 
-	for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
-		// Using the same indexes as the definitions
-		unsigned long i = derivation.reason.constraint_indexes[data_position];
-		Number &data_i = derivation.reason.constraint_multipliers[data_position];
+	int s = get_s(constraint.direction);
 
-		if(!data_i.is_zero() && constraints[i].direction != Direction::Equal) {
-			result = false;
-			break;
+	return ((s < 0 || activity >= target) && (s > 0 || activity <= target));
+}
+
+/**
+	Value of print_feas: every solution is integral where required and satisfies every problem
+	constraint. Rows are checked in chunks of FEASIBILITY_CHUNK_SIZE constraints of one
+	solution, in parallel across chunks and solutions; the first violation (in solution order,
+	then constraint order) is reported.
+*/
+bool Certificate::check_feas() {
+	for(Solution &solution: solutions) {
+		for(unsigned long i: variable_integral_vector) {
+			if(!solution.assignments[i].is_integral()) {
+				fprintf(stderr, "Native check failed: solution %s is not integral on %s\n", solution.name, variable_names[i]);
+
+				return false;
+			}
 		}
 	}
 
-	print_bool(result);
-	write_output(" ");
-	return;
-#endif /* !EQ_LEQ_GEG_SMT */
+	unsigned long number_chunks = (number_problem_constraints + FEASIBILITY_CHUNK_SIZE - 1) / FEASIBILITY_CHUNK_SIZE;
+	unsigned long number_items = solutions.size() * number_chunks;
 
-	print_conjunction_eq_leq_geq(derivation_index, derivation, Direction::Equal);
-}
+	// Next work item (a chunk of one solution), and the first violation as solution * rows + row
+	std::atomic<unsigned long> next_item{0};
+	std::atomic<unsigned long> failure{ULONG_MAX};
 
-void Certificate::print_geq(unsigned long derivation_index, Derivation &derivation) {
-#ifndef EQ_LEQ_GEG_SMT
-	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+	auto check_items = [&] {
+		unsigned long item;
 
-	bool result = true;
+		while((item = next_item++) < number_items) {
+			unsigned long solution_index = item / number_chunks;
+			unsigned long start = (item % number_chunks) * FEASIBILITY_CHUNK_SIZE;
+			unsigned long finish = std::min(start + FEASIBILITY_CHUNK_SIZE, number_problem_constraints);
 
-	for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
-		// Using the same indexes as the definitions
-		unsigned long i = derivation.reason.constraint_indexes[data_position];
-		Number &data_i = derivation.reason.constraint_multipliers[data_position];
+			for(unsigned long constraint_index = start; constraint_index < finish; constraint_index++) {
+				unsigned long position = solution_index * number_problem_constraints + constraint_index;
+				unsigned long current = failure.load(std::memory_order_relaxed);
 
-		if(!data_i.is_zero() && constraints[i].direction != Direction::Equal) {
-			if(data_i.numerator[0] == '-' && constraints[i].direction == Direction::GreaterEqual) {
-				result = false;
-				break;
-			}
-			if(data_i.numerator[0] != '-' && constraints[i].direction == Direction::SmallerEqual) {
-				result = false;
-				break;
+				// Only the first violation is reported
+				if(position >= current) {
+					break;
+				}
+
+				if(!check_feas_constraint(constraints[constraint_index], solutions[solution_index].assignments)) {
+					while(position < current && !failure.compare_exchange_weak(current, position));
+
+					break;
+				}
 			}
 		}
+	};
+
+#ifdef PARALLEL
+	unsigned long total_cores = std::min(static_cast<unsigned long>(std::thread::hardware_concurrency()), number_items);
+
+	vector<thread> checkers;
+
+	for(unsigned long core = 0; core < total_cores; core++) {
+		checkers.emplace_back(check_items);
 	}
 
-	print_bool(result);
-	write_output(" ");
-	return;
-#endif /* !EQ_LEQ_GEG_SMT */
+	for(auto &checker: checkers) {
+		checker.join();
+	}
+#else
+	check_items();
+#endif /* PARALLEL */
+
+	if(failure != ULONG_MAX) {
+		fprintf(stderr, "Native check failed: solution %s violates constraint %s\n", solutions[failure / number_problem_constraints].name, constraints.get_name(failure % number_problem_constraints));
+
+		return false;
+	}
 
-	print_conjunction_eq_leq_geq(derivation_index, derivation, Direction::GreaterEqual);
+	return true;
 }
 
-void Certificate::print_leq(unsigned long derivation_index, Derivation &derivation) {
-#ifndef EQ_LEQ_GEG_SMT
-	vector<unsigned long> &data = derivation.reason.constraint_indexes;
+// Value of the SOL section (uses the cached objective value of each solution)
+bool Certificate::check_sol() {
+	if(!feasible) {
+		if(number_solutions != 0) {
+			fprintf(stderr, "Native check failed: an infeasible certificate has solutions\n");
+
+			return false;
+		}
+
+		return true;
+	}
+
+	if(!check_feas()) {
+		return false;
+	}
 
 	bool result = true;
 
-	for(unsigned long data_position = 0; data_position < data.size(); data_position++) {
-		// Using the same indexes as the definitions
-		unsigned long i = derivation.reason.constraint_indexes[data_position];
-		Number &data_i = derivation.reason.constraint_multipliers[data_position];
+	if(minimization && get_PUB()) {
+		Rational bound(get_U());
 
-		if(!data_i.is_zero() && constraints[i].direction != Direction::Equal) {
-			if(data_i.numerator[0] == '-' && constraints[i].direction == Direction::SmallerEqual) {
-				result = false;
-				break;
-			}
-			if(data_i.numerator[0] != '-' && constraints[i].direction == Direction::GreaterEqual) {
-				result = false;
-				break;
-			}
-		}
+		result = std::any_of(native_objective_values.begin(), native_objective_values.end(), [&] (Rational &value) {
+			return value <= bound;
+		});
 	}
 
-	print_bool(result);
-	write_output(" ");
-	return;
-#endif /* !EQ_LEQ_GEG_SMT */
+	if(!minimization && get_PLB()) {
+		Rational bound(get_L());
+
+		result = std::any_of(native_objective_values.begin(), native_objective_values.end(), [&] (Rational &value) {
+			return value >= bound;
+		});
+	}
+
+	if(!result) {
+		fprintf(stderr, "Native check failed: no solution attains the objective bound\n");
+	}
 
-	print_conjunction_eq_leq_geq(derivation_index, derivation, Direction::SmallerEqual);
+	return result;
 }
 
-void Certificate::print_lin_individual(unsigned long derivation_index, Derivation &derivation) {
-	print_op1<OP_AND>(LAMBDA(
-		// Not counting because the number of operations is always >= 2
+void Certificate::precompute_native() {
+	native_objective_row.clear();
 
-		print_ASM(derivation_index, derivation);
-		print_PRV(derivation_index, derivation);
+	for(unsigned long i: objective_support) {
+		native_objective_row.emplace_back(i, Rational(objective_coefficients[i]));
+	}
 
-		print_DOM(
-			[&] (unsigned long j) {
-				print_LIN_RND_aj(derivation_index, derivation, j);
-			},
-			LAMBDA(print_LIN_RND_b(derivation_index, derivation)),
-			LAMBDA(print_eq(derivation_index, derivation)),
-			LAMBDA(print_geq(derivation_index, derivation)),
-			LAMBDA(print_leq(derivation_index, derivation)),
-			[&] (unsigned long j) {
-				print_LIN_RND_aPj(derivation_index, derivation, j);
-			},
-			LAMBDA(print_LIN_RND_bP(derivation_index, derivation)),
-			LAMBDA(print_op2<OP_EQ>(
-				LAMBDA(print_s(constraints[derivation_index].direction)),
-				LITERAL(0)
-			)),
-			LAMBDA(print_op2<OP_GEQ>(
-				LAMBDA(print_s(constraints[derivation_index].direction)),
-				LITERAL(0)
-			)),
-			LAMBDA(print_op2<OP_LEQ>(
-				LAMBDA(print_s(constraints[derivation_index].direction)),
-				LITERAL(0)
-			))
-		);
-	));
+	// Objective value of each solution
+	vector<Number> objective_numbers;
+
+	for(unsigned long i: objective_support) {
+		objective_numbers.emplace_back(objective_coefficients[i]);
+	}
+
+	native_objective_values.clear();
+
+	for(Solution &solution: solutions) {
+		native_objective_values.emplace_back(sparse_dot(objective_support.data(), objective_numbers.data(), objective_support.size(), solution.assignments.data()));
+	}
 }
 
-template<typename PQ, typename PQP, typename P0, typename P1, typename P2, typename P3, typename P4>
-void Certificate::print_rnd_individual_part2(PQ &&a, P0 &&b, P1 &&eq, P2 &&geq, P3 &&leq, PQP &&aP, P4 &&bP, unsigned long derivation_index) {
-	print_op2<OP_OR>(
-		LAMBDA(
-			print_op2<OP_AND>(
-				LAMBDA(
-					for(unsigned long j = 0; j < number_variables; j++) {
-						print_op2<OP_EQ>(LAMBDA(a(j)), LITERAL(0));
+void Certificate::check_der() {
+	unsigned long first_failure = number_total_constraints;
+
+#ifdef PARALLEL
+	std::atomic<unsigned long> failure{number_total_constraints};
+
+	unsigned long number_blocks = std::ceil(static_cast<float>(number_derived_constraints) / block_size);
+
+	unsigned long total_cores = std::min(static_cast<unsigned long>(std::thread::hardware_concurrency()), number_blocks);
+
+	fprintf(stderr, "Running native DER checks with %lu parallel cores and block size %lu\n", total_cores, block_size);
+
+	vector<thread> checkers;
+
+	for(unsigned long core = 0; core < total_cores; core++) {
+		checkers.emplace_back([&, core] {
+			for(unsigned long derived_index = (core * block_size); derived_index < number_derived_constraints; derived_index += (total_cores * block_size)) {
+				// Calculate global indexes
+				unsigned long global_index_start = derived_index + number_problem_constraints;
+				unsigned long global_index_finish = std::min(global_index_start + block_size, number_total_constraints);
+
+				for(unsigned long j = global_index_start; j < global_index_finish; j++) {
+					// Only the first failure is reported: later derivations need no checking
+					unsigned long current = failure.load(std::memory_order_relaxed);
+
+					if(j >= current) {
+						return;
 					}
-				),
-				LAMBDA(
-					print_ifelse(
-						geq,
-						LAMBDA(print_op2<OP_G>(b, LITERAL(0))),
-						LAMBDA(print_ifelse(
-							leq,
-							LAMBDA(print_op2<OP_L>(b, LITERAL(0))),
-							LAMBDA(print_bool(false))
-						))
-					)
-				)
-			)
-		),
-		LAMBDA(
-			print_op2<OP_AND>(
-				LAMBDA(
-					for(unsigned long j = 0; j < number_variables; j++) {
-						print_op2<OP_EQ>(LAMBDA(a(j)), LAMBDA(aP(j)));
+
+					if(!check_der_derivation(j)) {
+						while(j < current && !failure.compare_exchange_weak(current, j));
+
+						return;
 					}
-				),
-				LAMBDA(
-					print_ifelse(
-						LAMBDA(
-							print_op2<OP_EQ>(
-								LAMBDA(print_s(constraints[derivation_index].direction)),
-								LITERAL(1)
-							)
-						),
-						LAMBDA(
-							print_op2<OP_AND>(
-								geq,
-								LAMBDA(print_op2<OP_GEQ>(
-									LAMBDA(print_ceil(b)),
-									bP
-								))
-							)
-						),
-						LAMBDA(
-							print_op2<OP_AND>(
-								leq,
-								LAMBDA(print_op2<OP_LEQ>(
-									LAMBDA(print_op1<OP_RND_DOWN>(b)),
-									bP
-								))
-							)
-						)
-					)
-				)
-			)
-		)
-	);
+				}
+			}
+		});
+	}
+
+	for(auto &checker: checkers) {
+		checker.join();
+	}
+
+	first_failure = failure.load();
+#else
+	for(unsigned long j = number_problem_constraints; j < number_total_constraints; j++) {
+		if(!check_der_derivation(j)) {
+			first_failure = j;
+			break;
+		}
+	}
+#endif /* PARALLEL */
+
+	if(first_failure < number_total_constraints) {
+		fprintf(stderr, "Native check failed for derivation %s\n", constraints.get_name(first_failure));
+
+		native_result = false;
+		return;
+	}
+
+	if(!check_der_solcheck()) {
+		fprintf(stderr, "Native check failed for the DER solution check\n");
+
+		native_result = false;
+		return;
+	}
+
+	fprintf(stderr, "Native check passed for %lu derivations\n", number_derived_constraints);
 }
 
-void Certificate::print_rnd_individual(unsigned long derivation_index, Derivation &derivation) {
-	print_op1<OP_AND>(LAMBDA(
-		// Not counting because the number of operations is always >= 2
+void Certificate::check_native() {
+#ifdef PARALLEL
+	std::atomic_thread_fence(std::memory_order_release);
+#endif /* PARALLEL */
 
-		print_ASM(derivation_index, derivation);
-		print_PRV(derivation_index, derivation);
+	resolve_block_size();
+	precompute_native();
 
-		print_RND(
-			[&] (unsigned long j) {
-				print_LIN_RND_aj(derivation_index, derivation, j);
-			},
-			LAMBDA(print_LIN_RND_b(derivation_index, derivation)),
-			LAMBDA(print_eq(derivation_index, derivation))
-		);
+	if(!check_sol()) {
+		native_result = false;
+		return;
+	}
 
-		print_op2<OP_NEQ>(
-			LAMBDA(print_s(constraints[derivation_index].direction)),
-			LITERAL(0)
-		);
+	check_der();
 
-		print_rnd_individual_part2(
-			[&] (unsigned long j) {
-				print_LIN_RND_aj(derivation_index, derivation, j);
-			},
-			LAMBDA(print_LIN_RND_b(derivation_index, derivation)),
-			LAMBDA(print_eq(derivation_index, derivation)),
-			LAMBDA(print_geq(derivation_index, derivation)),
-			LAMBDA(print_leq(derivation_index, derivation)),
-			[&] (unsigned long j) {
-				print_LIN_RND_aPj(derivation_index, derivation, j);
-			},
-			LAMBDA(print_LIN_RND_bP(derivation_index, derivation)),
-			derivation_index
-		);
-	));
+	if(dag) {
+		report_dag();
+	}
 }
 
-void Certificate::print_uns_individual(unsigned long derivation_index, Derivation &derivation) {
-	print_op1<OP_AND>(LAMBDA(
-		// Not counting because the number of operations is always >= 2
+/////////////////////
+// Hybrid checking //
+/////////////////////
 
-		print_ASM(derivation_index, derivation);
-		write_output(" ");
-		print_op2<OP_G>(derivation_index, derivation.reason.get_i1());
-		write_output(" ");
-		print_op2<OP_G>(derivation_index, derivation.reason.get_i2());
-		write_output(" ");
-		print_DOM(constraints[derivation.reason.get_i1()], derivation.get_constraint(constraints));
-		write_output(" ");
-		print_DOM(constraints[derivation.reason.get_i2()], derivation.get_constraint(constraints));
-		write_output(" ");
-		print_op2<OP_G>(derivation_index, derivation.reason.get_l1());
-		write_output(" ");
-		print_op2<OP_G>(derivation_index, derivation.reason.get_l2());
-		write_output(" ");
-		print_DIS(constraints[derivation.reason.get_l1()], constraints[derivation.reason.get_l2()]);
-	));
-}
+// Deterministic per-derivation sample in [0, 1): the splitmix64 hash of the index
+static inline double get_sample(unsigned long j) {
+	uint64_t hash = j + 0x9E3779B97F4A7C15ULL;
 
-void Certificate::print_sol_individual_dom(Solution &solution, Direction direction, Constraint &constraint2) {
-	print_DOM(
-		[&] (unsigned long j) {
-			print_number(objective_coefficients[j]);
-		},
-		LAMBDA(
-			print_op1<OP_PLUS>(LAMBDA(
-#ifndef FULL_MODEL
-				MIN_SET(2);
-#endif /* !FULL_MODEL */
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+	hash = hash ^ (hash >> 31);
 
-				for(unsigned long i = 0; i < number_variables; i++) {
-#ifndef FULL_MODEL
-					if(objective_coefficients[i].is_zero() || solution.assignments[i].is_zero()) {
-						continue;
-					}
+	return static_cast<double>(hash >> 11) / static_cast<double>(1ULL << 53);
+}
 
-					MIN_COUNT;
-#endif /* !FULL_MODEL */
-					print_op2<OP_TIMES>(
-						objective_coefficients[i],
-						solution.assignments[i]
-					);
-				}
+bool Certificate::is_selected_for_smt(unsigned long j) {
+	Derivation &derivation = get_derivation_from_offset(j);
 
-#ifndef FULL_MODEL
-				MIN_ENSURE_ZERO;
-#endif /* !FULL_MODEL */
-			))
-		),
-		LAMBDA(print_op2<OP_EQ>(
-			LAMBDA(print_s(direction)),
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_GEQ>(
-			LAMBDA(print_s(direction)),
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_LEQ>(
-			LAMBDA(print_s(direction)),
-			LITERAL(0)
-		)),
-		[&] (unsigned long j) {
-			print_number(constraint2.coefficients_at(j));
-		},
-		LAMBDA(print_number(constraint2.target)),
-		LAMBDA(print_op2<OP_EQ>(
-			LAMBDA(print_s(constraint2.direction)),
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_GEQ>(
-			LAMBDA(print_s(constraint2.direction)),
-			LITERAL(0)
-		)),
-		LAMBDA(print_op2<OP_LEQ>(
-			LAMBDA(print_s(constraint2.direction)),
-			LITERAL(0)
-		))
-	);
+	return (hybrid_policy.smt_types[derivation.reason.type] || get_sample(j) < hybrid_policy.smt_fraction);
 }
 
-void Certificate::print_sol_individual(unsigned long derivation_index, Derivation &derivation) {
-	print_op2<OP_AND>(
-		LAMBDA(
-			print_ASM(derivation_index, derivation);
-		),
-		LAMBDA(
-			print_ifelse(
-				minimization,
-				LAMBDA(
-					print_op1<OP_OR>(LAMBDA(
-						MIN_SET(2);
+/**
+	Checks a derivation natively unless the hybrid policy sends it to the SMT solver. Failures
+	are recorded (the first one is reported by report_hybrid).
 
-						for(Solution &solution: solutions) {
-							print_sol_individual_dom(
-								solution,
-								Direction::SmallerEqual,
-								derivation.get_constraint(constraints)
-							);
-							MIN_COUNT;
-						}
+	@param j Derivation (global index)
+	@return Whether the derivation was settled natively (no SMT needed)
+*/
+bool Certificate::settle_natively(unsigned long j) {
+	if(is_selected_for_smt(j)) {
+		hybrid_smt_count++;
+		return false;
+	}
 
-						MIN_ENSURE_FALSE;
-					));
-				),
-				LAMBDA(
-					print_op1<OP_OR>(LAMBDA(
-						MIN_SET(2);
+	if(!check_der_derivation(j)) {
+		unsigned long current = hybrid_first_failure.load();
 
-						for(Solution &solution: solutions) {
-							print_sol_individual_dom(
-								solution,
-								Direction::GreaterEqual,
-								derivation.get_constraint(constraints)
-							);
-							MIN_COUNT;
-						}
+		while(j < current && !hybrid_first_failure.compare_exchange_weak(current, j));
 
-						MIN_ENSURE_FALSE;
-					));
-				)
-			);
-		)
-	);
+		hybrid_failure_count++;
+	}
+
+	hybrid_native_count++;
+	return true;
 }
 
-void Certificate::print_der_individual(unsigned long derivation_index, Derivation &derivation) {
-	switch(derivation.reason.type) {
-		case ReasonType::TypeASM:
-			print_asm_individual(derivation_index, derivation);
-			break;
-		case ReasonType::TypeLIN:
-			print_lin_individual(derivation_index, derivation);
-			break;
-		case ReasonType::TypeRND:
-			print_rnd_individual(derivation_index, derivation);
-			break;
-		case ReasonType::TypeUNS:
-			print_uns_individual(derivation_index, derivation);
-			break;
-		case ReasonType::TypeSOL:
-			print_sol_individual(derivation_index, derivation);
-			break;
+void Certificate::report_hybrid() {
+	fprintf(stderr, "Hybrid check: %lu derivations checked natively (%lu failed), %lu sent to the SMT solver\n", hybrid_native_count.load(), hybrid_failure_count.load(), hybrid_smt_count.load());
+
+	if(hybrid_failure_count > 0) {
+		fprintf(stderr, "Native check failed for derivation %s\n", constraints.get_name(hybrid_first_failure));
+
+		native_result = false;
 	}
 }
 
-void Certificate::print_der() {
-	auto task_der_part1 = [&, this] (unsigned long j) {
-		Derivation &derivation = get_derivation_from_offset(j);
+//////////////
+// Term DAG //
+//////////////
 
-		write_output("; DER for constraint ");
-		write_output(derivation.get_constraint(constraints).name);
-		write_output("\n");
+// Builds the formula of derivation j (as print_der_derivation, without the assert) in an emptied DAG
+template<typename E>
+DagTerm *Certificate::build_der_derivation(TermDag &dag, unsigned long j) {
+	Derivation &derivation = get_derivation_from_offset(j);
 
-		print_op1<OP_ASSERT>(LAMBDA(
-			print_op1<OP_AND>(LAMBDA(
-				print_der_individual(j, derivation);
-			));
-		));
+	dag.clear();
 
-		// Lines between assertions
-		write_output("\n");
-	};
+	term_dag = &dag;
+
+	print_op1<OP_AND>(LAMBDA(
+		print_der_individual<E>(j, derivation);
+	));
+
+	term_dag = nullptr;
+
+	return dag.get_result();
+}
+
+void Certificate::add_dag_cost(TermDag &dag, DagTerm *formula, unsigned long written_length) {
+	DagCost cost = dag.get_cost(formula);
+
+	dag_derivations++;
+	dag_tree_nodes += cost.tree_nodes;
+	dag_nodes += cost.dag_nodes;
+	dag_tree_length += cost.tree_length;
+	dag_written_length += written_length;
+}
+
+void Certificate::report_dag() {
+	fprintf(stderr, "Term DAG: %lu derivations, %lu nodes (%lu as trees)", dag_derivations.load(), dag_nodes.load(), dag_tree_nodes.load());
+
+	if(dag_written_length != 0) {
+		fprintf(stderr, ", %lu bytes of SMT written (%lu without sharing)", dag_written_length.load(), dag_tree_length.load());
+	}
+
+	fprintf(stderr, "\n");
+}
 
 #ifdef PARALLEL
-	unsigned long number_blocks = std::ceil(static_cast<float>(number_derived_constraints) / block_size);
+//////////////////////////////////////
+// Pipelined parsing and generation //
+//////////////////////////////////////
 
-	unsigned long total_cores = std::min(2 * static_cast<unsigned long>(std::thread::hardware_concurrency()), number_blocks);
+void Certificate::start_streaming() {
+	precompute_variables();
 
-	fprintf(stderr, "Running DER generation with %lu parallel cores and block size %lu\n", total_cores, block_size);
+	// Parsed elements must never move while generator threads read them
+	constraints.reserve(number_total_constraints);
+	derivations.reserve(number_derived_constraints);
+	dependencies.resize(number_total_constraints);
+	assumption_counts.resize(number_total_constraints, 0);
+	assumption_positions.reserve(number_derived_constraints);
 
-	for(unsigned long core = 0; core < total_cores; core++) {
-		threads.emplace_back([&, this] (unsigned long core) {
-			for(unsigned long derived_index = (core * block_size); derived_index < number_derived_constraints; derived_index += (total_cores * block_size)) {
-				// Calculate global indexes
-				unsigned long global_index_start = derived_index + number_problem_constraints;
-				unsigned long global_index_finish = std::min(global_index_start + block_size, number_total_constraints) - 1;
+	resolve_block_size();
 
-				// Open the file for block number and print header
-				string section_output_filename = output_filename + ".DER-" + std::to_string(global_index_start - number_problem_constraints + 1) + "-" + std::to_string(global_index_finish - number_problem_constraints + 1);
-				
-				open_output(section_output_filename);
-				print_header();
+	if(hybrid) {
+		precompute_native();
+	}
 
-				for(unsigned long j = global_index_start; j <= global_index_finish; j++) {
-					task_der_part1(j);
-				}
+	streaming = true;
+	streamed_block_start = number_problem_constraints;
+
+	print_sol();
+
+	unsigned long number_blocks = std::ceil(static_cast<float>(number_derived_constraints) / block_size);
+
+	unsigned long total_cores = std::min(2 * static_cast<unsigned long>(std::thread::hardware_concurrency()), number_blocks);
 
-				// Print footer and close the file for block number
-				print_footer();
-				close_output();
+	fprintf(stderr, "Running pipelined DER generation with %lu parallel cores and block size %lu\n", total_cores, block_size);
 
-				// Dispatches the work to the execution manager
-				remote_execution_manager.dispatch(section_output_filename, 0);
+	for(unsigned long core = 0; core < total_cores; core++) {
+		threads.emplace_back([this] {
+			std::pair<unsigned long, unsigned long> block;
+
+			while(ready_blocks.pop(block)) {
+				print_der_block(block.first, block.second);
 			}
-		},
-		core);
-	}
-#else
-	for(unsigned long i = number_problem_constraints; i < number_total_constraints; i++) {
-		task_der_part1(i);
+		});
 	}
-#endif /* PARALLEL */
-
-	auto task_der_part2 = [&, this] {
-		write_output("; Begin DER (solution check)\n");
+}
 
-		print_op1<OP_ASSERT>(LAMBDA(
-			unsigned long last_constraint_index = number_total_constraints - 1;
-			Constraint &last_constraint = constraints[last_constraint_index];
+void Certificate::add_streamed_derivation() {
+	unsigned long i = number_problem_constraints + derivations.size() - 1;
 
-			print_ifelse(
-				LAMBDA(print_op1<OP_NOT>(feasible)),
-				LAMBDA(print_op2<OP_AND>(
-					LAMBDA(print_DOM(
-						[&] (unsigned long j) {
-							print_number(last_constraint.coefficients_at(j));
-						},
-						LAMBDA(print_s(last_constraint.direction)),
-						LAMBDA(print_number(last_constraint.target)),
-						[&] (unsigned long j) {
-							print_integral_string("0");
-						},
-						LAMBDA(print_s(Direction::GreaterEqual)),
-						LAMBDA(print_integral_string("1"))
-					)),
-					LAMBDA(
-						for(unsigned long j = number_problem_constraints; j < number_total_constraints; j++) {
-							if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-								print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(last_constraint_index, j))));
-							}
-						}
-					)
-				)),
-				LAMBDA(print_op2<OP_AND>(
-					LAMBDA(print_op2<OP_IMPLICATION>(
-						LAMBDA(print_op2<OP_AND>(
-							minimization,
-							LAMBDA(print_plb())
-						)),
-						LAMBDA(print_op2<OP_AND>(
-							LAMBDA(print_DOM(
-								[&] (unsigned long j) {
-									print_number(last_constraint.coefficients_at(j));
-								},
-								LAMBDA(print_s(last_constraint.direction)),
-								LAMBDA(print_number(last_constraint.target)),
-								[&] (unsigned long j) {
-									print_number(objective_coefficients[j]);
-								},
-								LAMBDA(print_s(Direction::GreaterEqual)),
-								LAMBDA(print_number(get_L()))
-							)),
-							LAMBDA(
-								for(unsigned long j = number_problem_constraints; j < number_total_constraints; j++) {
-									if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-										print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(last_constraint_index, j))));
-									}
-								}
-							)
-						))
-					)),
-					LAMBDA(print_op2<OP_IMPLICATION>(
-						LAMBDA(print_op2<OP_AND>(
-							LAMBDA(print_op1<OP_NOT>(
-								minimization
-							)),
-							LAMBDA(print_pub())
-						)),
-						LAMBDA(print_op2<OP_AND>(
-							LAMBDA(print_DOM(
-								[&] (unsigned long j) {
-									print_number(last_constraint.coefficients_at(j));
-								},
-								LAMBDA(print_s(last_constraint.direction)),
-								LAMBDA(print_number(last_constraint.target)),
-								[&] (unsigned long j) {
-									print_number(objective_coefficients[j]);
-								},
-								LAMBDA(print_s(Direction::SmallerEqual)),
-								LAMBDA(print_number(get_U()))
-							)),
-							LAMBDA(
-								for(unsigned long j = number_problem_constraints; j < number_total_constraints; j++) {
-									if(get_derivation_from_offset(j).reason.type == ReasonType::TypeASM) {
-										print_op1<OP_NOT>(LAMBDA(print_bool(calculate_Aij(last_constraint_index, j))));
-									}
-								}
-							)
-						))
-					))
-				))
-			)
-		));
-	};
+	calculate_dependency(i);
 
-#ifdef PARALLEL
-	threads.emplace_back([&, this] {
-		// Open the file for SOL and print header
-		string section_output_filename = output_filename + ".DER-solcheck";
-		
-		open_output(section_output_filename);
-		print_header();
+	// Publishes the block once all of its derivations (and everything before them) are parsed
+	if(i + 1 - streamed_block_start == block_size || i + 1 == number_total_constraints) {
+		ready_blocks.push({streamed_block_start, i});
 
-		task_der_part2();
+		streamed_block_start = i + 1;
+	}
+}
 
-		// Print footer and close the file for block number
-		print_footer();
-		close_output();
+void Certificate::finish_streaming() {
+	ready_blocks.close();
 
-		// Dispatches the work to the execution manager
-		remote_execution_manager.dispatch(section_output_filename, 0);
+	// The solution check needs the last derived constraint
+	threads.emplace_back([this] {
+		print_der_solcheck_block();
 	});
-#else
-	task_der_part2();
-#endif /* PARALLEL */
+
+	for(auto &thread : threads) {
+		thread.join();
+	}
+
+	if(hybrid) {
+		report_hybrid();
+	}
+
+	if(dag) {
+		report_dag();
+	}
 }
+#endif /* PARALLEL */
 
 void Certificate::setup_output(string output_filename, bool expected_sat, unsigned long block_size) {
 	this->output_filename = output_filename;
@@ -1712,33 +3597,78 @@ void Certificate::setup_output(string output_filename, bool expected_sat, unsign
 	this->block_size = block_size;
 }
 
+void Certificate::setup_hybrid(HybridPolicy &policy) {
+	this->hybrid = true;
+	this->hybrid_policy = policy;
+}
+
+void Certificate::setup_dag() {
+	this->dag = true;
+}
+
+void Certificate::setup_mode(EncodingMode &mode) {
+	this->mode = mode;
+}
+
+void Certificate::resolve_block_size() {
+	if(block_size == 0) {
+		block_size = std::max(1UL, number_derived_constraints / (2 * 192));
+	}
+}
+
 void Certificate::print_formula() {
-#ifdef PARALLEL
 	std::atomic_thread_fence(std::memory_order_release);
-#endif /* PARALLEL */
 
-#ifndef PARALLEL
-	// Open the single output file and print header
-	open_output(output_filename);
-	print_header();	
-#endif /* !PARALLEL */
+	resolve_block_size();
+
+	// Results and reports cover one generation (there is one per mode with --benchmark-modes)
+	native_result = true;
+
+	hybrid_native_count = 0;
+	hybrid_failure_count = 0;
+	hybrid_smt_count = 0;
+	hybrid_first_failure = ULONG_MAX;
+
+	dag_derivations = 0;
+	dag_tree_nodes = 0;
+	dag_nodes = 0;
+	dag_tree_length = 0;
+	dag_written_length = 0;
+
+	if(hybrid) {
+		precompute_native();
+	}
+
+	if(!mode.parallel) {
+		// Open the single output file and print header
+		open_output(output_filename);
+		print_header();
+	}
 
 	print_sol();
 	print_der();
 
-#ifndef PARALLEL
-	// Print footer and close the single output file
-	print_footer();	
-	close_output();
-#endif /* !PARALLEL */
+	if(!mode.parallel) {
+		// Print footer and close the single output file
+		print_footer();
+		output_length += close_output();
+
+		remote_execution_manager.dispatch(output_filename, 0);
+	}
 
-#ifdef PARALLEL
 	for(auto &thread : threads) {
 		thread.join();
 	}
-#else
-	remote_execution_manager.dispatch(output_filename, 0);
-#endif /* PARALLEL */
+
+	threads.clear();
+
+	if(hybrid) {
+		report_hybrid();
+	}
+
+	if(dag) {
+		report_dag();
+	}
 }
 
 ////////////////////////////////////
@@ -1750,7 +3680,7 @@ string get_string_numbers(vector<Number> &coefficients) {
 	bool first = true;
 
 	for(int i = 0; i < coefficients.size(); i++) {
-		if(strcmp(coefficients[i].numerator, "0") == 0) {
+		if(coefficients[i].is_zero()) {
 			continue;
 		}
 
@@ -1780,8 +3710,8 @@ void Certificate::print() {
 	get_string_numbers(objective_coefficients);
 
 	fprintf(stdout, "Constraints: \n");
-	for(auto &constraint: constraints) {
-		fprintf(stdout, "%s\n", constraint.get_string().c_str());
+	for(unsigned long i = 0; i < constraints.size(); i++) {
+		fprintf(stdout, "%s\n", constraints.get_string(i).c_str());
 	}
 
 	fprintf(stdout, "Solutions: \n");
@@ -1795,13 +3725,19 @@ void Certificate::print() {
 	}
 }
 
-Certificate::Certificate() {
+Certificate::Certificate(): number_assumptions{0}, streaming{false}, streamed_block_start{0}, ready_blocks{STREAMING_QUEUE_CAPACITY}, native_result{true}, hybrid{false}, hybrid_native_count{0}, hybrid_failure_count{0}, hybrid_smt_count{0}, hybrid_first_failure{ULONG_MAX}, dag{false}, dag_derivations{0}, dag_tree_nodes{0}, dag_nodes{0}, dag_tree_length{0}, dag_written_length{0}, output_length{0}, block_size{0} {
 }
 
 Certificate::~Certificate() {
 }
 
 bool Certificate::get_evaluation_result() {
+	// A failed native check is an unsat formula: the dispatches cannot change the outcome
+	if(!native_result) {
+		remote_execution_manager.kill_dispatches();
+		return (expected_sat == false);
+	}
+
 	// Clears all pending dispatches and leaves the program if one of them fails
 	RemoteExecutionManager::ClearingResult result;
 
@@ -4,107 +4,37 @@
 #include <cstdint>
 #include <set>
 #include <vector>
-#include <unordered_set>
-#include <unordered_map>
 
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <thread>
 
 #include <stdexcept>
 #include <format>
 
 #include "basic_types.h"
+#include "constraint_store.h"
+#include "assumption_set.h"
+#include "rational.h"
+#include "term_dag.h"
 
 #include "remote_execution_manager.h"
+#include "BoundedQueue.hpp"
 
 using std::set;
 using std::vector;
-using std::unordered_set;
-using std::unordered_map;
 
 using std::function;
+using std::shared_ptr;
 using std::thread;
 
 using std::runtime_error;
 using std::format;
 
-// Global numeric zero
-extern Number zero;
-
 // Used in Certificate::print()
 string get_string_numbers(vector<Number> &coefficients);
 
-enum Direction {
-	SmallerEqual,
-	Equal,
-	GreaterEqual
-};
-
-struct Constraint {
-	char *name;
-	vector<unsigned long> coefficient_indexes;
-	vector<Number> coefficient_numbers;
-	Direction direction;
-	Number target;
-
-	unordered_map<unsigned long, unsigned long> coefficient_positions;
-
-	Constraint(char *name, vector<unsigned long> coefficient_indexes, vector<Number> &coefficient_numbers, Direction direction, Number target):
-		name{name}, coefficient_indexes{coefficient_indexes}, coefficient_numbers{coefficient_numbers}, direction{direction}, target{target} {
-
-		for(int i = 0; i < coefficient_indexes.size(); i++) {
-			coefficient_positions[coefficient_indexes[i]] = i;
-		}
-	}
-	
-	inline Number &coefficients_at(unsigned long i) {
-		auto iterator = coefficient_positions.find(i);
-
-		if(iterator != coefficient_positions.end()) {
-			return coefficient_numbers[iterator->second];
-		}
-
-		return zero;
-	}
-
-	string get_string() {
-		string result = string(name) + ": ";
-
-		bool first = true;
-
-		for(int i = 0; i < coefficient_indexes.size(); i++) {
-			if(first) {
-				first = false;
-			}
-			else {
-				result += " + ";
-			}
-
-			result += "(";
-			result += coefficient_numbers[i].get_string();
-			result += " x_";
-			result += std::to_string(coefficient_indexes[i]);
-			result += ")";
-		}
-
-		switch(direction) {
-			case Direction::SmallerEqual:
-				result += " <= ";
-				break;
-			case Direction::Equal:
-				result += " = ";
-				break;
-			case Direction::GreaterEqual:
-				result += " >= ";
-				break;
-		}
-
-		result += target.get_string();
-
-		return result;
-	}
-};
-
 struct Solution {
 	char *name;
 	vector<Number> assignments;
@@ -202,10 +132,10 @@ struct Derivation {
 	Derivation(unsigned long constraint_index, Reason &reason, long largest_index):
 		constraint_index{constraint_index}, reason{reason}, largest_index{largest_index} {}
 	
-	string get_string(vector<Constraint> &constraints) {
+	string get_string(ConstraintStore &constraints) {
 		string result = "Derivation ";
 
-		result += get_constraint(constraints).get_string();
+		result += constraints.get_string(constraint_index);
 		result += " ";
 		result += reason.get_string();
 		result += " last_index ";
@@ -214,11 +144,69 @@ struct Derivation {
 		return result;
 	}
 
-	inline Constraint &get_constraint(vector<Constraint> &constraints) {
+	inline Constraint &get_constraint(ConstraintStore &constraints) {
 		return constraints[constraint_index];
 	}
 };
 
+// The build flags that used to fix the encoding now only select the default of --mode
+#ifdef FULL_MODEL
+constexpr bool DEFAULT_FULL_MODEL = true;
+#else
+constexpr bool DEFAULT_FULL_MODEL = false;
+#endif /* FULL_MODEL */
+
+#ifdef AIJ_SMT
+constexpr bool DEFAULT_AIJ_SMT = true;
+#else
+constexpr bool DEFAULT_AIJ_SMT = false;
+#endif /* AIJ_SMT */
+
+#ifdef EQ_LEQ_GEG_SMT
+constexpr bool DEFAULT_EQ_LEQ_GEQ_SMT = true;
+#else
+constexpr bool DEFAULT_EQ_LEQ_GEQ_SMT = false;
+#endif /* EQ_LEQ_GEG_SMT */
+
+#ifdef PARALLEL
+constexpr bool DEFAULT_PARALLEL = true;
+#else
+constexpr bool DEFAULT_PARALLEL = false;
+#endif /* PARALLEL */
+
+// Options of the SMT generation, chosen at run time
+struct EncodingMode {
+	// A term for every variable: no supports, folding or let bindings
+	bool full_model = DEFAULT_FULL_MODEL;
+
+	// The assumption conditions A(i, j) are left to the SMT solver instead of precomputed
+	bool aij_smt = DEFAULT_AIJ_SMT;
+
+	// The eq, geq and leq conditions of LIN and RND are left to the SMT solver instead of precomputed
+	bool eq_leq_geq_smt = DEFAULT_EQ_LEQ_GEQ_SMT;
+
+	// SOL, DER blocks and the solution check in separate files, generated and dispatched in
+	// parallel (otherwise a single file)
+	bool parallel = DEFAULT_PARALLEL;
+};
+
+// Encoding options as template arguments: the emitters are instantiated for each combination
+template<bool FULL_MODEL_ENCODING, bool AIJ_SMT_ENCODING, bool EQ_LEQ_GEQ_SMT_ENCODING>
+struct Encoding {
+	constexpr static bool full_model = FULL_MODEL_ENCODING;
+	constexpr static bool aij_smt = AIJ_SMT_ENCODING;
+	constexpr static bool eq_leq_geq_smt = EQ_LEQ_GEQ_SMT_ENCODING;
+};
+
+// Hybrid checking: derivations are checked natively unless selected for the SMT solver
+struct HybridPolicy {
+	// Types (by ReasonType) always sent to the SMT solver
+	bool smt_types[ReasonType::TypeSOL + 1] = {false, false, false, false, false};
+
+	// Fraction of all derivations sent to the SMT solver regardless of their type
+	double smt_fraction = 0.0;
+};
+
 struct Certificate {
 	bool feasible;
 	Number feasible_lower_bound;
@@ -242,13 +230,25 @@ struct Certificate {
 	vector<unsigned long> variable_non_integral_vector; // Precomputed based on parser's input
 
 	vector<Number> objective_coefficients;
+	vector<unsigned long> objective_support; // Precomputed based on parser's input
 
-	vector<Constraint> constraints;
+	ConstraintStore constraints;
 	vector<Solution> solutions;
 
 	vector<Derivation> derivations;
 
-	vector<unordered_set<unsigned long> *> dependencies;
+	// Assumptions each constraint depends on (nullptr if none), by dense assumption id
+	vector<shared_ptr<const AssumptionSet>> dependencies;
+
+	// ASM derivations are numbered densely in certificate order (see get_assumption_id)
+	constexpr static uint32_t NO_ASSUMPTION = UINT32_MAX;
+
+	// Number of ASM derivations up to each constraint (inclusive)
+	vector<uint32_t> assumption_counts;
+
+	// Constraint index of each ASM derivation, by id (sorted)
+	vector<unsigned long> assumption_positions;
+	unsigned long number_assumptions;
 
 	//////////////////////////////////
 	// Constructors and destructors //
@@ -262,10 +262,26 @@ struct Certificate {
 	/////////////////////////////////////////
 
 	void setup_output(string output_filename, bool expected_sat, unsigned long block_size);
+	void setup_hybrid(HybridPolicy &policy);
+
+	// Derivations go through the term DAG: written with shared subterms, or evaluated by check_native
+	void setup_dag();
+
+	void setup_mode(EncodingMode &mode);
 
 	void precompute();
 	void print_formula();
 
+	// Checks the certificate in-process (exact rationals) instead of generating SMT for it
+	void check_native();
+
+#ifdef PARALLEL
+	// Pipelined mode: DER blocks are generated while the parser is still reading derivations
+	void start_streaming();
+	void add_streamed_derivation();
+	void finish_streaming();
+#endif /* PARALLEL */
+
 	void print();
 
 	////////////////////////////////////
@@ -274,6 +290,19 @@ struct Certificate {
 
 	bool get_evaluation_result();
 
+	unsigned long get_block_size() {
+		return block_size;
+	}
+
+	bool is_streaming() {
+		return streaming;
+	}
+
+	// Length of the SMT files written so far
+	unsigned long get_output_length() {
+		return output_length;
+	}
+
 private:
 	bool get_PUB();
 	bool get_PLB();
@@ -281,22 +310,56 @@ private:
 	Number &get_L();
 	Number &get_U();
 
+	void precompute_variables();
+
+	// A block size of 0 selects a default based on the number of derivations
+	void resolve_block_size();
+
 	void calculate_dependencies();
+	void calculate_dependency(unsigned long i);
 
-	void print_pub();
-	void print_plb();
+	// Removes an ASM derivation (given by constraint index) from a set
+	void erase_assumption(AssumptionSet &set, unsigned long constraint_index);
+
+	// Number of ASM derivations before a constraint (the ids below it)
+	inline uint32_t count_assumptions_before(unsigned long constraint_index) {
+		return (constraint_index == 0 ? 0 : assumption_counts[constraint_index - 1]);
+	}
 
-	// Begin SOL predicate
-	void print_respect_bound(vector<Number> &coefficients, vector<Number> &assignments, Direction direction, Number &target);
-	void print_respect_bound(Constraint &constraint, vector<Number> &assignments, Direction direction, Number &target);
-	void print_one_solution_within_bound(Direction direction, Number &bound);
-	void print_all_solutions_within_bound(Direction direction, Number &bound);
+	// Dense id of an ASM derivation (NO_ASSUMPTION for other constraints, including those
+	// whose dependencies were not calculated yet, as their count is still 0)
+	inline uint32_t get_assumption_id(unsigned long constraint_index) {
+		uint32_t before = count_assumptions_before(constraint_index);
 
-	void print_feas_individual(Solution &solution);
-	void print_feas();
+		return (assumption_counts[constraint_index] > before ? before : NO_ASSUMPTION);
+	}
 
-	void print_pubimplication();
-	void print_plbimplication();
+	// Calls f(Encoding<...>{}) with the instantiation of the current mode
+	template<typename F>
+		void with_encoding(F &&f);
+
+	void print_pub();
+	void print_plb();
+
+	// Begin SOL predicate (E: Encoding)
+	template<typename E>
+		void print_respect_bound(vector<Number> &coefficients, vector<Number> &assignments, Direction direction, Number &target);
+	template<typename E>
+		void print_respect_bound(Constraint &constraint, vector<Number> &assignments, Direction direction, Number &target);
+	template<typename E>
+		void print_one_solution_within_bound(Direction direction, Number &bound);
+	template<typename E>
+		void print_all_solutions_within_bound(Direction direction, Number &bound);
+
+	template<typename E>
+		void print_feas_individual(Solution &solution);
+	template<typename E>
+		void print_feas();
+
+	template<typename E>
+		void print_pubimplication();
+	template<typename E>
+		void print_plbimplication();
 
 	void print_sol();
 	// End SOL predicate
@@ -304,54 +367,152 @@ private:
 	// Begin DER predicate
 	bool calculate_Aij(unsigned long i, unsigned long j);
 
-	void print_ASM(unsigned long k, Derivation &derivation);
+	// Calls f(j) for every ASM derivation j that constraint i depends on
+	template<typename F>
+		void for_each_assumption(unsigned long i, F &&f);
+
+	// Values of the ASM conditions on the ASM derivations after k and before k
+	bool calculate_ASM_later(unsigned long k);
+	bool calculate_ASM_earlier(unsigned long k, Derivation &derivation);
+
+	template<typename E>
+		void print_ASM(unsigned long k, Derivation &derivation);
 	void print_PRV(unsigned long k, Derivation &derivation);
 
-	template<typename PQ, typename PQP, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
-		void print_DOM(PQ &&a, P0 &&b, P1 &&eq, P2 &&geq, P3 &&leq, PQP &&aP, P4 &&bP, P5 &&eqP, P6 &&geqP, P7 &&leqP);
+	template<typename E, typename PQ, typename PQP, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
+		void print_DOM(vector<unsigned long> &support, PQ &&a, P0 &&b, P1 &&eq, P2 &&geq, P3 &&leq, PQP &&aP, P4 &&bP, P5 &&eqP, P6 &&geqP, P7 &&leqP);
+
+	template<typename E, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5>
+		void print_DOM(vector<unsigned long> &support, P0 &&print_coefficientA, P1 &&print_directionA, P2 &&print_targetA, P3 &&print_coefficientB, P4 &&print_directionB, P5 &&print_targetB);
+
+	template<typename E>
+		void print_DOM(Constraint &constraint1, Constraint &constraint2);
 
-	template<typename P0, typename P1, typename P2, typename P3, typename P4, typename P5>
-		void print_DOM(P0 &&print_coefficientA, P1 &&print_directionA, P2 &&print_targetA, P3 &&print_coefficientB, P4 &&print_directionB, P5 &&print_targetB);
+	template<typename E, typename P0, typename P1>
+		void print_RND(vector<unsigned long> &support, const function<void(unsigned long)> &a, P0 &&b, P1 &&eq);
 
-	void print_DOM(Constraint &constraint1, Constraint &constraint2);
+	template<typename E>
+		void print_DIS(Constraint &c_i, Constraint &c_j);
 
-	template<typename P0, typename P1>
-		void print_RND(const function<void(unsigned long)> &a, P0 &&b, P1 &&eq);
+	// Supports: sorted columns where a coefficient may be non-zero (terms elsewhere are trivial)
+	void add_support(vector<unsigned long> &support, Constraint &constraint);
+	void add_support(vector<unsigned long> &support, Derivation &derivation);
+	void sort_support(vector<unsigned long> &support);
 
-	void print_DIS(Constraint &c_i, Constraint &c_j);
+	template<typename E, typename F>
+		void print_columns(vector<unsigned long> &support, F &&print_column);
 
 	// ASM
-	void print_asm_individual(unsigned long derivation_index, Derivation &derivation);
+	template<typename E>
+		void print_asm_individual(unsigned long derivation_index, Derivation &derivation);
 
 	// Used in LIN & RND
-	void print_LIN_RND_aj(unsigned long derivation_index, Derivation &derivation, unsigned long j);
-	void print_LIN_RND_b(unsigned long derivation_index, Derivation &derivation);
+	template<typename E>
+		void print_LIN_RND_aj(unsigned long derivation_index, Derivation &derivation, unsigned long j);
+	template<typename E>
+		void print_LIN_RND_b(unsigned long derivation_index, Derivation &derivation);
 	void print_LIN_RND_aPj(unsigned long derivation_index, Derivation &derivation, unsigned long j);
 	void print_LIN_RND_bP(unsigned long derivation_index, Derivation &derivation);
 
+	// Binds a(j) and b once per derivation (let), and prints a body that references the bindings
+	bool has_LIN_RND_b(Derivation &derivation);
+	template<typename E, typename F>
+		void print_LIN_RND_let(unsigned long derivation_index, Derivation &derivation, vector<unsigned long> &support, F &&body);
+
 	// LIN
-	void print_conjunction_eq_leq_geq(unsigned long derivation_index, Derivation &derivation, Direction direction);
-	void print_eq(unsigned long derivation_index, Derivation &derivation);
-	void print_leq(unsigned long derivation_index, Derivation &derivation);
-	void print_geq(unsigned long derivation_index, Derivation &derivation);
-	void print_lin_individual(unsigned long derivation_index, Derivation &derivation);
+	bool calculate_eq(Derivation &derivation);
+	bool calculate_geq(Derivation &derivation);
+	bool calculate_leq(Derivation &derivation);
+
+	template<typename E>
+		void print_conjunction_eq_leq_geq(unsigned long derivation_index, Derivation &derivation, Direction direction);
+	template<typename E>
+		void print_eq(unsigned long derivation_index, Derivation &derivation);
+	template<typename E>
+		void print_leq(unsigned long derivation_index, Derivation &derivation);
+	template<typename E>
+		void print_geq(unsigned long derivation_index, Derivation &derivation);
+	template<typename E>
+		void print_lin_individual(unsigned long derivation_index, Derivation &derivation);
 
 	// RND
-	template<typename PQ, typename PQP, typename P0, typename P1, typename P2, typename P3, typename P4>
-		void print_rnd_individual_part2(PQ &&a, P0 &&b, P1 &&eq, P2 &&geq, P3 &&leq, PQP &&aP, P4 &&bP, unsigned long derivation_index);
-	void print_rnd_individual(unsigned long derivation_index, Derivation &derivation);
+	template<typename E, typename PQ, typename PQP, typename P0, typename P1, typename P2, typename P3, typename P4>
+		void print_rnd_individual_part2(vector<unsigned long> &support, PQ &&a, P0 &&b, P1 &&eq, P2 &&geq, P3 &&leq, PQP &&aP, P4 &&bP, unsigned long derivation_index);
+	template<typename E>
+		void print_rnd_individual(unsigned long derivation_index, Derivation &derivation);
 
 	// UNS
-	void print_uns_individual(unsigned long derivation_index, Derivation &derivation);
+	template<typename E>
+		void print_uns_individual(unsigned long derivation_index, Derivation &derivation);
 
 	// SOL
-	void print_sol_individual_dom(Solution &solution, Direction direction, Constraint &constraint2);
-	void print_sol_individual(unsigned long derivation_index, Derivation &derivation);
-
-	void print_der_individual(unsigned long derivation_index, Derivation &derivation);
+	template<typename E>
+		void print_sol_individual_dom(Solution &solution, Direction direction, Constraint &constraint2, vector<unsigned long> &support);
+	template<typename E>
+		void print_sol_individual(unsigned long derivation_index, Derivation &derivation);
+
+	template<typename E>
+		void print_der_individual(unsigned long derivation_index, Derivation &derivation);
+	template<typename E>
+		void print_der_derivation(unsigned long j);
+	template<typename E>
+		void print_der_solcheck();
+	void print_der_block(unsigned long global_index_start, unsigned long global_index_finish);
+	void print_der_solcheck_block();
 	void print_der();
 	// End DER predicate
 
+	// Begin native checks (each returns the value of the corresponding SMT formula)
+	using NativeRow = vector<std::pair<unsigned long, Rational>>;
+
+	void get_native_row(Constraint &constraint, NativeRow &row);
+	void get_native_aggregation(Derivation &derivation, NativeRow &row, Rational &target);
+
+	bool check_DOM(NativeRow &a, Rational &b, bool eq, bool geq, bool leq, NativeRow &aP, Rational &bP, Direction directionP);
+	bool check_DOM(Constraint &constraint1, Constraint &constraint2);
+	bool check_ASM(unsigned long k, Derivation &derivation);
+	bool check_PRV(unsigned long k, Derivation &derivation);
+	bool check_DIS(Constraint &c_i, Constraint &c_j);
+
+	bool check_lin_individual(unsigned long derivation_index, Derivation &derivation);
+	bool check_rnd_individual(unsigned long derivation_index, Derivation &derivation);
+	bool check_uns_individual(unsigned long derivation_index, Derivation &derivation);
+	bool check_sol_individual(unsigned long derivation_index, Derivation &derivation);
+
+	bool check_der_individual(unsigned long derivation_index, Derivation &derivation);
+	bool check_der_derivation(unsigned long j);
+	bool check_der_solcheck();
+
+	// Problem constraints of one solution checked at once in check_feas
+	constexpr static unsigned long FEASIBILITY_CHUNK_SIZE = 1024;
+
+	bool check_feas_constraint(Constraint &constraint, vector<Number> &assignments);
+	bool check_feas();
+	bool check_sol();
+
+	void precompute_native();
+	void check_der();
+
+	// Non-zero objective coefficients and the objective value of each solution
+	NativeRow native_objective_row;
+	vector<Rational> native_objective_values;
+	// End native checks
+
+	// Begin hybrid checks
+	bool is_selected_for_smt(unsigned long j);
+	bool settle_natively(unsigned long j);
+
+	void report_hybrid();
+	// End hybrid checks
+
+	// Begin term DAG
+	template<typename E>
+		DagTerm *build_der_derivation(TermDag &dag, unsigned long j);
+	void add_dag_cost(TermDag &dag, DagTerm *formula, unsigned long written_length);
+
+	void report_dag();
+	// End term DAG
+
 	inline Derivation &get_derivation_from_offset(unsigned long offset) {
 		if(offset >= number_total_constraints) {
 			throw runtime_error(format("Requesting non-existent derivation {}\n", offset));
@@ -364,9 +525,42 @@ private:
 	// Output variables and functions //
 	////////////////////////////////////
 
-#ifdef PARALLEL
 	vector<thread> threads;
-#endif /* PARALLEL */
+
+	// Blocks of derivations waiting for generation in pipelined mode
+	constexpr static size_t STREAMING_QUEUE_CAPACITY = 1024;
+
+	bool streaming;
+	unsigned long streamed_block_start;
+
+	BoundedQueue<std::pair<unsigned long, unsigned long>> ready_blocks;
+
+	// False once a native check fails
+	bool native_result;
+
+	bool hybrid;
+	HybridPolicy hybrid_policy;
+
+	// Derivations settled natively (and how many of them failed), and sent to the SMT solver
+	std::atomic<unsigned long> hybrid_native_count;
+	std::atomic<unsigned long> hybrid_failure_count;
+	std::atomic<unsigned long> hybrid_smt_count;
+
+	std::atomic<unsigned long> hybrid_first_failure;
+
+	bool dag;
+
+	// Totals over the derivations that went through the term DAG
+	std::atomic<unsigned long> dag_derivations;
+	std::atomic<unsigned long> dag_tree_nodes;
+	std::atomic<unsigned long> dag_nodes;
+	std::atomic<unsigned long> dag_tree_length;
+	std::atomic<unsigned long> dag_written_length;
+
+	EncodingMode mode;
+
+	// Total length of the SMT files closed (over every thread)
+	std::atomic<unsigned long> output_length;
 
 	RemoteExecutionManager remote_execution_manager;
 
@@ -0,0 +1,135 @@
+#include "constraint_store.h"
+
+#include <functional>
+#include <numeric>
+
+string Constraint::get_string(const char *name) {
+	string result = string(name) + ": ";
+
+	bool first = true;
+
+	for(unsigned long i = 0; i < number_coefficients; i++) {
+		if(first) {
+			first = false;
+		}
+		else {
+			result += " + ";
+		}
+
+		result += "(";
+		result += coefficient_numbers[i].get_string();
+		result += " x_";
+		result += std::to_string(coefficient_indexes[i]);
+		result += ")";
+	}
+
+	switch(direction) {
+		case Direction::SmallerEqual:
+			result += " <= ";
+			break;
+		case Direction::Equal:
+			result += " = ";
+			break;
+		case Direction::GreaterEqual:
+			result += " >= ";
+			break;
+	}
+
+	result += target.get_string();
+
+	return result;
+}
+
+ConstraintStore::ConstraintStore(): objective_row{nullptr, nullptr, 0, Direction::Equal, Number()} {
+}
+
+void ConstraintStore::reserve(size_t number_rows) {
+	rows.reserve(number_rows);
+	names.reserve(number_rows);
+}
+
+void ConstraintStore::set_objective(vector<Number> &objective_coefficients) {
+	vector<unsigned long> indexes;
+	vector<Number> numbers;
+
+	for(unsigned long i = 0; i < objective_coefficients.size(); i++) {
+		if(objective_coefficients[i].is_zero()) {
+			continue;
+		}
+
+		indexes.emplace_back(i);
+		numbers.emplace_back(objective_coefficients[i]);
+	}
+
+	objective_row.coefficient_indexes = index_arena.allocate<unsigned long>(indexes.size());
+	objective_row.coefficient_numbers = number_arena.allocate<Number>(numbers.size());
+	objective_row.number_coefficients = indexes.size();
+
+	std::copy(indexes.begin(), indexes.end(), objective_row.coefficient_indexes);
+	std::copy(numbers.begin(), numbers.end(), objective_row.coefficient_numbers);
+}
+
+void ConstraintStore::add(ConstraintRecord &record) {
+	if(record.objective) {
+		add_shared(record.name, objective_row, record.direction, record.target);
+	}
+	else {
+		add(record.name, record.coefficient_indexes, record.coefficient_numbers, record.direction, record.target);
+	}
+}
+
+/**
+	Appends a row, copying its coefficients into the store.
+	Unsorted rows are sorted by column index; for repeated indexes, the last coefficient wins.
+
+	@param name Constraint name (not copied)
+	@param indexes Column indexes
+	@param numbers Coefficients (same length as indexes)
+	@param direction Constraint direction
+	@param target Right-hand side
+*/
+void ConstraintStore::add(char *name, vector<unsigned long> &indexes, vector<Number> &numbers, Direction direction, Number target) {
+	unsigned long number_coefficients = indexes.size();
+
+	// Strictly increasing indexes are already in order and free of repetitions
+	bool sorted = (std::adjacent_find(indexes.begin(), indexes.end(), std::greater_equal<>()) == indexes.end());
+
+	if(!sorted) {
+		order.resize(number_coefficients);
+		std::iota(order.begin(), order.end(), 0);
+
+		std::stable_sort(order.begin(), order.end(), [&indexes] (unsigned long a, unsigned long b) {
+			return indexes[a] < indexes[b];
+		});
+
+		// Keeps the last position of each run of equal indexes
+		unsigned long kept = 0;
+
+		for(unsigned long k = 0; k < number_coefficients; k++) {
+			if(k + 1 < number_coefficients && indexes[order[k + 1]] == indexes[order[k]]) {
+				continue;
+			}
+
+			order[kept++] = order[k];
+		}
+
+		number_coefficients = kept;
+	}
+
+	Constraint row{index_arena.allocate<unsigned long>(number_coefficients), number_arena.allocate<Number>(number_coefficients), number_coefficients, direction, target};
+
+	for(unsigned long k = 0; k < number_coefficients; k++) {
+		unsigned long position = (sorted ? k : order[k]);
+
+		row.coefficient_indexes[k] = indexes[position];
+		row.coefficient_numbers[k] = numbers[position];
+	}
+
+	rows.emplace_back(row);
+	names.emplace_back(name);
+}
+
+void ConstraintStore::add_shared(char *name, const Constraint &source, Direction direction, Number target) {
+	rows.emplace_back(Constraint{source.coefficient_indexes, source.coefficient_numbers, source.number_coefficients, direction, target});
+	names.emplace_back(name);
+}
@@ -0,0 +1,144 @@
+#ifndef CONSTRAINT_STORE_H
+#define CONSTRAINT_STORE_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "basic_types.h"
+#include "Arena.hpp"
+
+using std::string;
+using std::vector;
+
+// Global numeric zero
+extern Number zero;
+
+enum Direction {
+	SmallerEqual,
+	Equal,
+	GreaterEqual
+};
+
+/**
+	Row of the ConstraintStore (the data read while generating formulas). The coefficients are
+	sorted by column index, without repetitions, and are owned by the store; rows that reference
+	the objective share a single copy of it. Names are kept apart (see ConstraintStore).
+*/
+struct Constraint {
+	unsigned long *coefficient_indexes;
+	Number *coefficient_numbers;
+	unsigned long number_coefficients;
+
+	Direction direction;
+	Number target;
+
+	inline Number &coefficients_at(unsigned long i) {
+		unsigned long *end = coefficient_indexes + number_coefficients;
+		unsigned long *position = std::lower_bound(coefficient_indexes, end, i);
+
+		if(position != end && *position == i) {
+			return coefficient_numbers[position - coefficient_indexes];
+		}
+
+		return zero;
+	}
+
+	/**
+		Coefficient lookup for increasing column indexes: gallops forward from a position
+		that only moves forward (start it at 0 and reuse it for the same scan).
+
+		@param i Column index (not smaller than in the previous call with the same position)
+		@param position Scan position, updated
+		@return Coefficient of column i (or zero)
+	*/
+	inline Number &coefficients_at(unsigned long i, unsigned long &position) {
+		unsigned long low = position;
+		unsigned long step = 1;
+
+		while(low + step < number_coefficients && coefficient_indexes[low + step] < i) {
+			low += step;
+			step <<= 1;
+		}
+
+		unsigned long high = std::min(low + step + 1, number_coefficients);
+
+		position = std::lower_bound(coefficient_indexes + low, coefficient_indexes + high, i) - coefficient_indexes;
+
+		if(position < number_coefficients && coefficient_indexes[position] == i) {
+			return coefficient_numbers[position];
+		}
+
+		return zero;
+	}
+
+	string get_string(const char *name);
+};
+
+// Constraint as read from a certificate, before it is added to a ConstraintStore
+struct ConstraintRecord {
+	char *name;
+
+	vector<unsigned long> coefficient_indexes;
+	vector<Number> coefficient_numbers;
+
+	Direction direction;
+	Number target;
+
+	// References the objective ("OBJ"): no coefficients of its own
+	bool objective;
+};
+
+/**
+	Compressed sparse rows of all problem and derived constraints.
+
+	Column indexes and coefficients of every row are stored contiguously in two arenas, so
+	rows never move once added: generator threads can read earlier rows while the parser keeps
+	appending (as long as reserve() was called with the final number of rows). Names are cold
+	metadata and live in a separate array.
+*/
+class ConstraintStore {
+	Arena index_arena;
+	Arena number_arena;
+
+	vector<Constraint> rows;
+	vector<char *> names;
+
+	// Non-zero objective coefficients, shared by every row that references OBJ
+	Constraint objective_row;
+
+	// Scratch space to sort unsorted rows
+	vector<unsigned long> order;
+
+public:
+	ConstraintStore();
+
+	void reserve(size_t number_rows);
+
+	// Must be called before adding rows that reference the objective
+	void set_objective(vector<Number> &objective_coefficients);
+
+	void add(ConstraintRecord &record);
+	void add(char *name, vector<unsigned long> &indexes, vector<Number> &numbers, Direction direction, Number target);
+
+	// Adds a row with the same coefficients as source (without copying them)
+	void add_shared(char *name, const Constraint &source, Direction direction, Number target);
+
+	inline Constraint &operator[](size_t i) {
+		return rows[i];
+	}
+
+	inline size_t size() const {
+		return rows.size();
+	}
+
+	inline char *get_name(size_t i) {
+		return names[i];
+	}
+
+	inline string get_string(size_t i) {
+		return rows[i].get_string(names[i]);
+	}
+};
+
+#endif /* CONSTRAINT_STORE_H */
@@ -1,10 +1,188 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 
+#include <cerrno>
+#include <csignal>
+
+#include <algorithm>
+#include <vector>
+
+#include <mutex>
+#include <condition_variable>
+
+#if defined(LINUX) && __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+// Raw system calls: no liburing needed
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define IO_URING
+#endif
+#endif /* LINUX */
+
+#ifdef ZLIB
+#include <zlib.h>
+#endif /* ZLIB */
+
+#ifdef LZMA
+#include <lzma.h>
+#endif /* LZMA */
+
 #include "file_helper.h"
 
+using std::vector;
+
+/////////////////////////////
+// Streaming decompression //
+/////////////////////////////
+
+#if defined(ZLIB) || defined(LZMA)
+// Writes a whole buffer to the pipe; false if the reader is gone (input closed early)
+static bool write_decompressed(int fd, const unsigned char *buffer, size_t length) {
+    while(length > 0) {
+        ssize_t result = write(fd, buffer, length);
+
+        if(result == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        buffer += result;
+        length -= result;
+    }
+
+    return true;
+}
+#endif /* ZLIB || LZMA */
+
+#ifdef ZLIB
+static string decompress_gzip(int input_fd, int output_fd) {
+    vector<unsigned char> input(FileHelper::DECOMPRESSION_CHUNK_LENGTH);
+    vector<unsigned char> output(FileHelper::DECOMPRESSION_CHUNK_LENGTH);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(z_stream));
+
+    // 15 + 32: maximum window, automatic gzip/zlib header detection
+    if(inflateInit2(&stream, 15 + 32) != Z_OK) {
+        return "Error initializing gzip decompression\n";
+    }
+
+    string error;
+    int status = Z_OK;
+
+    while(error.empty()) {
+        ssize_t bytes_read = read(input_fd, input.data(), input.size());
+
+        if(bytes_read == -1) {
+            error = "Error reading compressed input\n";
+            break;
+        }
+
+        if(bytes_read == 0) {
+            if(status != Z_STREAM_END) {
+                error = "Error in compressed input: unexpected end of gzip data\n";
+            }
+
+            break;
+        }
+
+        stream.next_in = input.data();
+        stream.avail_in = bytes_read;
+
+        while(stream.avail_in > 0) {
+            // Concatenated gzip members (as written by pigz or cat) form a single input
+            if(status == Z_STREAM_END) {
+                inflateReset(&stream);
+            }
+
+            stream.next_out = output.data();
+            stream.avail_out = output.size();
+
+            status = inflate(&stream, Z_NO_FLUSH);
+
+            if(status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+                error = format("Error in compressed input: {}\n", (stream.msg != nullptr ? stream.msg : "corrupt gzip data"));
+                break;
+            }
+
+            if(!write_decompressed(output_fd, output.data(), output.size() - stream.avail_out)) {
+                inflateEnd(&stream);
+
+                return "";
+            }
+        }
+    }
+
+    inflateEnd(&stream);
+
+    return error;
+}
+#endif /* ZLIB */
+
+#ifdef LZMA
+static string decompress_xz(int input_fd, int output_fd) {
+    vector<unsigned char> input(FileHelper::DECOMPRESSION_CHUNK_LENGTH);
+    vector<unsigned char> output(FileHelper::DECOMPRESSION_CHUNK_LENGTH);
+
+    lzma_stream stream = LZMA_STREAM_INIT;
+
+    if(lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+        return "Error initializing xz decompression\n";
+    }
+
+    string error;
+    lzma_action action = LZMA_RUN;
+
+    while(error.empty()) {
+        if(stream.avail_in == 0 && action == LZMA_RUN) {
+            ssize_t bytes_read = read(input_fd, input.data(), input.size());
+
+            if(bytes_read == -1) {
+                error = "Error reading compressed input\n";
+                break;
+            }
+
+            stream.next_in = input.data();
+            stream.avail_in = bytes_read;
+
+            // LZMA_CONCATENATED only reports the end of the input after LZMA_FINISH
+            if(bytes_read == 0) {
+                action = LZMA_FINISH;
+            }
+        }
+
+        stream.next_out = output.data();
+        stream.avail_out = output.size();
+
+        lzma_ret status = lzma_code(&stream, action);
+
+        if(!write_decompressed(output_fd, output.data(), output.size() - stream.avail_out)) {
+            break;
+        }
+
+        if(status == LZMA_STREAM_END) {
+            break;
+        }
+
+        if(status != LZMA_OK) {
+            error = format("Error in compressed input: corrupt or truncated xz data (code {})\n", static_cast<int>(status));
+        }
+    }
+
+    lzma_end(&stream);
+
+    return error;
+}
+#endif /* LZMA */
+
 int FileHelper::open_input(const char *filename) {
     input_fd = open(filename, O_RDONLY);
 
@@ -18,11 +196,548 @@ int FileHelper::open_input(const char *filename) {
     }
 #endif /* LINUX */
 
+    // Compressed inputs are recognized by their magic bytes (pipes are never compressed)
+    unsigned char magic[6];
+    ssize_t magic_length = pread(input_fd, magic, sizeof(magic), 0);
+
+    bool gzip = (magic_length >= 2 && magic[0] == 0x1F && magic[1] == 0x8B);
+    bool xz = (magic_length >= 6 && memcmp(magic, "\xFD" "7zXZ\0", 6) == 0);
+
+    if(!gzip && !xz) {
+        return input_fd;
+    }
+
+    string (*decompress)(int, int) = nullptr;
+
+#ifdef ZLIB
+    if(gzip) {
+        decompress = decompress_gzip;
+    }
+#endif /* ZLIB */
+
+#ifdef LZMA
+    if(xz) {
+        decompress = decompress_xz;
+    }
+#endif /* LZMA */
+
+    if(decompress == nullptr) {
+        throw runtime_error(format("Error opening {}: {} input requires a build with {}\n", filename, (gzip ? "gzip" : "xz"), (gzip ? "-DZLIB" : "-DLZMA")));
+    }
+
+    int pipe_fds[2];
+
+    if(pipe(pipe_fds) == -1) {
+        throw runtime_error(format("Error creating decompression pipe for {}\n", filename));
+    }
+
+#ifdef LINUX
+    // Larger pipe: fewer context switches between the decompression thread and the parser
+    fcntl(pipe_fds[1], F_SETPIPE_SZ, DECOMPRESSION_CHUNK_LENGTH);
+#endif /* LINUX */
+
+    compressed_fd = input_fd;
+    input_fd = pipe_fds[0];
+
+    int pipe_write_fd = pipe_fds[1];
+
+    decompression_thread = std::thread([this, decompress, pipe_write_fd] {
+        // Writing after close_input() must fail with EPIPE instead of killing the process
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        decompression_error = decompress(compressed_fd, pipe_write_fd);
+
+        close(pipe_write_fd);
+    });
+
 	return input_fd;
 }
 
+/**
+	Called once the input reaches its end: reports errors of the decompression thread
+	(corrupt or truncated compressed inputs), which otherwise look like a shorter input.
+*/
+void FileHelper::check_input() {
+    if(decompression_thread.joinable()) {
+        decompression_thread.join();
+    }
+
+    if(!decompression_error.empty()) {
+        throw runtime_error(decompression_error);
+    }
+}
+
 void FileHelper::close_input() {
+    unmap_input();
+
+    // Closing the read end first unblocks a decompression thread that is still writing
     close(input_fd);
+
+    if(decompression_thread.joinable()) {
+        decompression_thread.join();
+    }
+
+    if(compressed_fd != -1) {
+        close(compressed_fd);
+    }
+
+    input_fd = -1;
+    compressed_fd = -1;
+}
+
+const char *FileHelper::map_input(size_t *input_length) {
+    struct stat input_stat;
+
+    // Pipes, sockets and empty files are left to the regular read() path
+    if(fstat(input_fd, &input_stat) == -1 || !S_ISREG(input_stat.st_mode) || input_stat.st_size == 0) {
+        return nullptr;
+    }
+
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t file_length = input_stat.st_size;
+
+    // Reserve zeroed anonymous memory past the end of the file, then place the file over it:
+    // the mapped input is always followed by INPUT_MAPPING_PADDING zeroes, even when the file
+    // length is a multiple of the page size
+    size_t mapping_length = ((file_length + INPUT_MAPPING_PADDING + page_size - 1) / page_size) * page_size;
+
+    void *reserved = mmap(nullptr, mapping_length, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(reserved == MAP_FAILED) {
+        return nullptr;
+    }
+
+    // Read-only mapping: the tokenizer only takes views of the input, so the pages are never
+    // copied and stay shared with the page cache
+    if(mmap(reserved, file_length, PROT_READ, MAP_PRIVATE | MAP_FIXED, input_fd, 0) == MAP_FAILED) {
+        munmap(reserved, mapping_length);
+
+        return nullptr;
+    }
+
+    if(madvise(reserved, file_length, MADV_SEQUENTIAL) != 0) {
+        perror("Error advising for sequential mapped access (proceeding anyway)");
+    }
+
+#ifdef LINUX
+    // Only a hint: kernels without transparent huge pages for this mapping return EINVAL
+    madvise(reserved, mapping_length, MADV_HUGEPAGE);
+#endif /* LINUX */
+
+    input_mapping = static_cast<char *>(reserved);
+    input_mapping_length = mapping_length;
+
+    *input_length = file_length;
+
+    return input_mapping;
+}
+
+void FileHelper::unmap_input() {
+    if(input_mapping != nullptr) {
+        munmap(input_mapping, input_mapping_length);
+    }
+
+    input_mapping = nullptr;
+    input_mapping_length = 0;
+}
+
+/////////////////////////
+// Asynchronous output //
+/////////////////////////
+
+// Writes a whole buffer at the end of the output; false on errors
+static bool write_all(int fd, const char *buffer, size_t length) {
+	while(length > 0) {
+		ssize_t result = write(fd, buffer, length);
+
+		if(result == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+
+			return false;
+		}
+
+		buffer += result;
+		length -= result;
+	}
+
+	return true;
+}
+
+/**
+	Writes full output buffers in the background, so that generation goes on in the other
+	buffer instead of stalling on storage (NFS in particular). Writes go through io_uring where
+	the kernel allows it (not always in containers), and through a writer thread otherwise.
+
+	At most one write is in flight: the next one is submitted after wait(), which keeps the
+	writes in order (outputs are opened with O_APPEND).
+*/
+struct OutputWriter {
+	// Write in flight (the buffer stays untouched until wait())
+	int fd;
+	const char *buffer;
+	size_t length;
+	bool busy;
+
+	// Whether the last write failed
+	bool failed;
+
+#ifdef IO_URING
+	int ring_fd;
+
+	// Submission and completion rings (one mapping), and submission entries
+	char *ring_mapping;
+	size_t ring_mapping_length;
+
+	io_uring_sqe *submissions;
+	size_t submissions_length;
+
+	unsigned *submission_tail;
+	unsigned *submission_mask;
+	unsigned *submission_array;
+
+	unsigned *completion_head;
+	unsigned *completion_tail;
+	unsigned *completion_mask;
+	io_uring_cqe *completions;
+
+	// Submitted to the ring but not taken by the kernel yet (io_uring_enter interrupted)
+	unsigned unsubmitted;
+
+	struct iovec vector;
+
+	bool setup_ring();
+	bool wait_ring();
+#endif /* IO_URING */
+
+	// Writer thread (without io_uring)
+	std::thread writer_thread;
+	std::mutex serializer;
+	std::condition_variable signal;
+
+	// Submitted but not taken by the writer thread yet
+	bool pending;
+	bool stopping;
+
+	void run_writer_thread();
+
+	OutputWriter();
+	~OutputWriter();
+
+	void submit(int fd, const char *buffer, size_t length, size_t offset);
+
+	// Waits for the write in flight; false if it failed
+	bool wait();
+};
+
+#ifdef IO_URING
+bool OutputWriter::setup_ring() {
+	io_uring_params parameters;
+	memset(&parameters, 0, sizeof(io_uring_params));
+
+	// ENOSYS on old kernels, EPERM where seccomp or sysctl forbid io_uring
+	int fd = syscall(__NR_io_uring_setup, 2, &parameters);
+
+	if(fd == -1) {
+		return false;
+	}
+
+	// Both rings in one mapping (kernels since 5.4)
+	if((parameters.features & IORING_FEAT_SINGLE_MMAP) == 0) {
+		close(fd);
+
+		return false;
+	}
+
+	ring_mapping_length = std::max(parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned), parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe));
+
+	void *mapping = mmap(nullptr, ring_mapping_length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+	if(mapping == MAP_FAILED) {
+		close(fd);
+
+		return false;
+	}
+
+	submissions_length = parameters.sq_entries * sizeof(io_uring_sqe);
+
+	void *submission_mapping = mmap(nullptr, submissions_length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+	if(submission_mapping == MAP_FAILED) {
+		munmap(mapping, ring_mapping_length);
+		close(fd);
+
+		return false;
+	}
+
+	ring_fd = fd;
+
+	ring_mapping = static_cast<char *>(mapping);
+	submissions = static_cast<io_uring_sqe *>(submission_mapping);
+
+	submission_tail = reinterpret_cast<unsigned *>(ring_mapping + parameters.sq_off.tail);
+	submission_mask = reinterpret_cast<unsigned *>(ring_mapping + parameters.sq_off.ring_mask);
+	submission_array = reinterpret_cast<unsigned *>(ring_mapping + parameters.sq_off.array);
+
+	completion_head = reinterpret_cast<unsigned *>(ring_mapping + parameters.cq_off.head);
+	completion_tail = reinterpret_cast<unsigned *>(ring_mapping + parameters.cq_off.tail);
+	completion_mask = reinterpret_cast<unsigned *>(ring_mapping + parameters.cq_off.ring_mask);
+	completions = reinterpret_cast<io_uring_cqe *>(ring_mapping + parameters.cq_off.cqes);
+
+	return true;
+}
+
+bool OutputWriter::wait_ring() {
+	unsigned head = *completion_head;
+
+	while(head == __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE)) {
+		int result = syscall(__NR_io_uring_enter, ring_fd, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+		if(result == -1) {
+			if(errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+				continue;
+			}
+
+			return false;
+		}
+
+		unsubmitted -= std::min<unsigned>(result, unsubmitted);
+	}
+
+	int result = completions[head & *completion_mask].res;
+
+	__atomic_store_n(completion_head, head + 1, __ATOMIC_RELEASE);
+
+	if(result == -EINTR || result == -EAGAIN) {
+		result = 0;
+	}
+
+	if(result < 0) {
+		return false;
+	}
+
+	// Short writes: the rest is written directly (appended after the written part)
+	return write_all(fd, buffer + result, length - result);
+}
+#endif /* IO_URING */
+
+void OutputWriter::run_writer_thread() {
+	std::unique_lock<std::mutex> lock(serializer);
+
+	while(true) {
+		signal.wait(lock, [this] { return pending || stopping; });
+
+		if(!pending) {
+			return;
+		}
+
+		pending = false;
+
+		lock.unlock();
+		bool written = write_all(fd, buffer, length);
+		lock.lock();
+
+		failed = !written;
+		busy = false;
+
+		signal.notify_all();
+	}
+}
+
+OutputWriter::OutputWriter(): fd{-1}, buffer{nullptr}, length{0UL}, busy{false}, failed{false}, pending{false}, stopping{false} {
+#ifdef IO_URING
+	ring_fd = -1;
+	unsubmitted = 0;
+
+	if(setup_ring()) {
+		return;
+	}
+#endif /* IO_URING */
+
+	writer_thread = std::thread(&OutputWriter::run_writer_thread, this);
+}
+
+OutputWriter::~OutputWriter() {
+	wait();
+
+#ifdef IO_URING
+	if(ring_fd != -1) {
+		munmap(submissions, submissions_length);
+		munmap(ring_mapping, ring_mapping_length);
+		close(ring_fd);
+	}
+#endif /* IO_URING */
+
+	if(writer_thread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(serializer);
+			stopping = true;
+		}
+
+		signal.notify_all();
+		writer_thread.join();
+	}
+}
+
+void OutputWriter::submit(int fd, const char *buffer, size_t length, size_t offset) {
+	this->fd = fd;
+	this->buffer = buffer;
+	this->length = length;
+
+	busy = true;
+
+#ifdef IO_URING
+	if(ring_fd != -1) {
+		unsigned tail = *submission_tail;
+		unsigned index = tail & *submission_mask;
+
+		vector.iov_base = const_cast<char *>(buffer);
+		vector.iov_len = length;
+
+		io_uring_sqe *submission = &submissions[index];
+		memset(submission, 0, sizeof(io_uring_sqe));
+
+		// A vectored write is supported by every io_uring kernel
+		submission->opcode = IORING_OP_WRITEV;
+		submission->fd = fd;
+		submission->addr = reinterpret_cast<uint64_t>(&vector);
+		submission->len = 1;
+		submission->off = offset;
+
+		submission_array[index] = index;
+
+		__atomic_store_n(submission_tail, tail + 1, __ATOMIC_RELEASE);
+
+		// Submitted later by wait_ring() if interrupted
+		unsubmitted = 1;
+
+		if(syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, nullptr, 0) == 1) {
+			unsubmitted = 0;
+		}
+
+		return;
+	}
+#endif /* IO_URING */
+
+	{
+		std::lock_guard<std::mutex> lock(serializer);
+		pending = true;
+	}
+
+	signal.notify_all();
+}
+
+bool OutputWriter::wait() {
+#ifdef IO_URING
+	if(ring_fd != -1) {
+		if(busy) {
+			failed = !wait_ring();
+			busy = false;
+		}
+
+		return !failed;
+	}
+#endif /* IO_URING */
+
+	std::unique_lock<std::mutex> lock(serializer);
+
+	signal.wait(lock, [this] { return !busy; });
+
+	return !failed;
+}
+
+/**
+	Hands the full current buffer to the writer and continues in the other buffer, once the
+	previous write (of the other buffer) is over.
+*/
+void FileHelper::flush_output_buffer() {
+	if(output_writer == nullptr) {
+		output_writer = new OutputWriter();
+	}
+
+	if(output_buffers[1] == nullptr) {
+		output_buffers[1] = new char[FileHelper::OUTPUT_BUFFER_LENGTH];
+	}
+
+	wait_output_writer();
+
+	output_writer->submit(output_fd, output_buffer, output_buffer_watermark, output_flushed);
+
+	output_flushed += output_buffer_watermark;
+
+	output_buffer = (output_buffer == output_buffers[0] ? output_buffers[1] : output_buffers[0]);
+	output_buffer_watermark = 0;
+}
+
+void FileHelper::wait_output_writer() {
+	if(output_writer != nullptr && !output_writer->wait()) {
+		fprintf(stderr, "Cannot write to client socket no. %d\n", output_fd);
+
+		exit(EXIT_FAILURE);
+	}
+}
+
+// Writes several buffers with one system call (joins the buffered output with a message too large to buffer)
+void FileHelper::flush_gathered(struct iovec *vectors, int count) {
+	while(count > 0) {
+		ssize_t result = writev(output_fd, vectors, count);
+
+		if(result == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+
+			fprintf(stderr, "Cannot write to client socket no. %d\n", output_fd);
+
+			exit(EXIT_FAILURE);
+		}
+
+		// Skips what was written: whole buffers, then part of the next one
+		while(count > 0 && static_cast<size_t>(result) >= vectors->iov_len) {
+			result -= vectors->iov_len;
+
+			vectors++;
+			count--;
+		}
+
+		if(count > 0) {
+			vectors->iov_base = static_cast<char *>(vectors->iov_base) + result;
+			vectors->iov_len -= result;
+		}
+	}
+}
+
+void FileHelper::write_overflowing_output(const char *message, size_t message_size) {
+	if(message_size >= OUTPUT_BUFFER_LENGTH) {
+		// Too large for a buffer: the buffered output and the message are written together
+		wait_output_writer();
+
+		struct iovec vectors[2] = {
+			{output_buffer, output_buffer_watermark},
+			{const_cast<char *>(message), message_size}
+		};
+
+		flush_gathered(vectors, 2);
+
+		output_flushed += output_buffer_watermark + message_size;
+		output_buffer_watermark = 0;
+
+		return;
+	}
+
+	size_t remaining = OUTPUT_BUFFER_LENGTH - output_buffer_watermark;
+
+	memcpy(output_buffer + output_buffer_watermark, message, remaining);
+	output_buffer_watermark = OUTPUT_BUFFER_LENGTH;
+
+	flush_output_buffer();
+
+	memcpy(output_buffer, message + remaining, message_size - remaining);
+	output_buffer_watermark = message_size - remaining;
 }
 
 int FileHelper::open_output(const char *filename) {
@@ -34,27 +749,46 @@ int FileHelper::open_output(const char *filename) {
 		exit(EXIT_FAILURE);
 	}
 
-	if(output_buffer == nullptr) {
-		output_buffer = new char[FileHelper::OUTPUT_BUFFER_LENGTH];
+	if(output_buffers[0] == nullptr) {
+		output_buffers[0] = new char[FileHelper::OUTPUT_BUFFER_LENGTH];
 	}
 
+	output_buffer = output_buffers[0];
+
 	return output_fd;
 }
 
 void FileHelper::close_output() {
+	// The last buffer is written directly, after the one in flight
+	wait_output_writer();
+
 	if(output_buffer != nullptr) {
 		flush_data(output_buffer, output_buffer_watermark);
 	}
 
 	output_buffer_watermark = 0;
+	output_flushed = 0;
+
+	if(output_fd != -1) {
+		close(output_fd);
+	}
+
+	output_fd = -1;
 }
 	
-FileHelper::FileHelper(): input_fd{-1}, output_fd{-1}, output_buffer{nullptr}, output_buffer_watermark{0UL} {
+FileHelper::FileHelper(): input_fd{-1}, output_fd{-1}, compressed_fd{-1}, input_mapping{nullptr}, input_mapping_length{0UL}, output_buffers{nullptr, nullptr}, output_buffer{nullptr}, output_buffer_watermark{0UL}, output_flushed{0UL}, output_writer{nullptr} {
 }
 
 FileHelper::~FileHelper() {
-	if(output_buffer != nullptr) {
-		delete output_buffer;
+	// Waits for the write in flight before its buffer goes away
+	if(output_writer != nullptr) {
+		delete output_writer;
+	}
+
+	for(char *buffer: output_buffers) {
+		if(buffer != nullptr) {
+			delete[] buffer;
+		}
 	}
 
 	output_buffer = nullptr;
@@ -1,4 +1,5 @@
 #ifndef FILE_HELPER_H
+#define FILE_HELPER_H
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -9,27 +10,68 @@
 #include <string>
 #include <cstring>
 
+#include <thread>
+
 using std::runtime_error;
 using std::format;
 
 using std::string;
 
+// Background writes of full output buffers (io_uring, or a writer thread)
+struct OutputWriter;
+
 struct FileHelper {
-	// Space for output buffer
+	// Space for each output buffer
 	constexpr static size_t OUTPUT_BUFFER_LENGTH = 64 * 1024 * 1024;
 
+	// Zeroed bytes guaranteed past the end of a mapped input (at least the terminating '\0')
+	constexpr static size_t INPUT_MAPPING_PADDING = 64;
+
+	// Chunk size of compressed reads and decompressed writes, and requested pipe capacity
+	constexpr static size_t DECOMPRESSION_CHUNK_LENGTH = 1024 * 1024;
+
 	int input_fd;
 	int output_fd;
 
+	// Compressed inputs: input_fd is the read end of a pipe filled by the decompression thread
+	int compressed_fd;
+	std::thread decompression_thread;
+	string decompression_error;
+
+	// Read-only mapping of the input file, or nullptr if the input is not mapped
+	char *input_mapping;
+	size_t input_mapping_length;
+
+	// Output is generated into one buffer while the other one is written in the background
+	// (the second buffer is only allocated once an output fills the first one)
+	char *output_buffers[2];
+
+	// Buffer being filled
 	char *output_buffer;
 	size_t output_buffer_watermark;
 
+	// Bytes of the current output handed to the writer or written (not in the buffer anymore)
+	size_t output_flushed;
+
+	OutputWriter *output_writer;
+
 	int open_input(const char *filename);
+	void check_input();
 	void close_input();
 
+	const char *map_input(size_t *input_length);
+	void unmap_input();
+
 	int open_output(const char *filename);
 	void close_output();
 
+	void flush_output_buffer();
+	void wait_output_writer();
+
+	void flush_gathered(struct iovec *vectors, int count);
+
+	void write_overflowing_output(const char *message, size_t message_size);
+
 	inline void flush_data(const char *buffer, size_t ntowrite) {
 		size_t nwritten = 0;
 
@@ -49,34 +91,42 @@ struct FileHelper {
 		}
 	}
 
-	inline void write_output(const char *message) {
-		size_t message_size = strlen(message);
+	// Position in the current output (counting flushed bytes)
+	inline size_t get_output_position() const {
+		return output_flushed + output_buffer_watermark;
+	}
 
-		size_t remaining = OUTPUT_BUFFER_LENGTH - output_buffer_watermark;
+	// Whether the output from position on is still in the buffer (and can be rewritten)
+	inline bool is_buffered(size_t position) const {
+		return position >= output_flushed;
+	}
 
-		if(message_size > remaining) {
-			if(message_size >= OUTPUT_BUFFER_LENGTH) {
-				flush_data(output_buffer, output_buffer_watermark);
-				flush_data(message, message_size);
+	// Only for buffered positions
+	inline char *get_buffered(size_t position) {
+		return output_buffer + (position - output_flushed);
+	}
 
-				output_buffer_watermark = 0;
-			}
-			else {
-				memcpy(output_buffer + output_buffer_watermark, message, remaining);
-				flush_data(output_buffer, OUTPUT_BUFFER_LENGTH);
+	// Discards the buffered output from position on (only for buffered positions)
+	inline void rewind_output(size_t position) {
+		output_buffer_watermark = position - output_flushed;
+	}
 
-				memcpy(output_buffer, message + remaining, message_size - remaining);
+	inline void write_output(const char *message) {
+		write_output(message, strlen(message));
+	}
 
-				output_buffer_watermark = (message_size - remaining);
-			}
-		}
-		else {
-			memcpy(output_buffer + output_buffer_watermark, message, message_size);
+	inline void write_output(const char *message, size_t message_size) {
+		if(message_size > OUTPUT_BUFFER_LENGTH - output_buffer_watermark) {
+			write_overflowing_output(message, message_size);
 
-			output_buffer_watermark += message_size;
+			return;
 		}
+
+		memcpy(output_buffer + output_buffer_watermark, message, message_size);
+
+		output_buffer_watermark += message_size;
 	}
-	
+
 	FileHelper();
 	~FileHelper();
 };
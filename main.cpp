@@ -5,12 +5,16 @@
 #include <format>
 
 #include <vector>
+#include <utility>
+#include <memory>
 
 #include <unistd.h>
 #include <fcntl.h>
 
 #include "parser.h"
+#include "parallel_parser.h"
 #include "certificate.h"
+#include "binary_certificate.h"
 
 using std::string;
 using std::format;
@@ -47,19 +51,19 @@ inline void read_index_number_pairs(Parser &parser, vector<unsigned long> &index
 	read_index_number_pairs_with_size(parser, indexes, numbers, size);
 }
 
-inline Constraint read_constraint(Parser &parser, unsigned long number_variables, vector<Number> &objective_coefficients) {
-	char *name = parser.get_stable_string(parser.get_token());
-	char *direction_string = parser.get_token();
+inline ConstraintRecord read_constraint(Parser &parser, unsigned long number_variables) {
+	char *name = parser.get_stable_string(parser.get_required_token("constraint name"));
+	Token direction_string = parser.get_required_token("constraint direction");
 
 	Direction direction;
 
-	if(strcmp(direction_string, "E") == 0) {
+	if(direction_string == "E") {
 		direction = Direction::Equal;
 	}
-	else if(strcmp(direction_string, "L") == 0) {
+	else if(direction_string == "L") {
 		direction = Direction::SmallerEqual;
 	}
-	else if(strcmp(direction_string, "G") == 0) {
+	else if(direction_string == "G") {
 		direction = Direction::GreaterEqual;
 	}
 	else {
@@ -68,58 +72,51 @@ inline Constraint read_constraint(Parser &parser, unsigned long number_variables
 
 	Number target = parser.get_number();
 
-	char *coefficient_specification = parser.get_token();
+	Token coefficient_specification = parser.get_required_token("number of coefficients or OBJ");
 
-	vector<unsigned long> constraint_indexes;
-	vector<Number> constraint_numbers;
-
-	if(strcmp(coefficient_specification, "OBJ") == 0) {
-		for(int i = 0; i < objective_coefficients.size(); i++) {
-			if(objective_coefficients[i].is_zero()) {
-				continue;
-			}
+	ConstraintRecord record{name, {}, {}, direction, target, false};
 
-			constraint_indexes.emplace_back(i);
-			constraint_numbers.emplace_back(objective_coefficients[i]);
-		}
+	// The objective row is shared by the constraint store
+	if(coefficient_specification == "OBJ") {
+		record.objective = true;
 	}
 	else {
 		unsigned long number_coefficients = parser.parse_unsigned_long(coefficient_specification);
 
-		read_index_number_pairs_with_size(parser, constraint_indexes, constraint_numbers, number_coefficients);
+		read_index_number_pairs_with_size(parser, record.coefficient_indexes, record.coefficient_numbers, number_coefficients);
 	}
 
-	return Constraint(name, constraint_indexes, constraint_numbers, direction, target);
+	return record;
 }
 
 inline Reason read_reason(Parser &parser) {
 	vector<unsigned long> constraint_indexes;
 	vector<Number> constraint_multipliers;
 
-	char *token;
+	Token token;
 	
-	token = parser.get_token();
+	token = parser.get_required_token("open bracket");
 
-	if(strcmp(token, "{") != 0) {
+	if(token != "{") {
 		throw runtime_error(format("Expected open bracket in line {}\n", parser.get_line_number()));
 	}
 
-	char *type_string = parser.get_token();
+	Token type_string = parser.get_required_token("derivation name");
 
 	ReasonType type;
 
-	if(strcmp(type_string, "asm") == 0) {
+	if(type_string == "asm") {
 		type = ReasonType::TypeASM;
 	}
-	else if(strcmp(type_string, "lin") == 0) {
+	else if(type_string == "lin") {
 		type = ReasonType::TypeLIN;
 		read_index_number_pairs(parser, constraint_indexes, constraint_multipliers);
 	}
-	else if(strcmp(type_string, "rnd") == 0) {
+	else if(type_string == "rnd") {
 		type = ReasonType::TypeRND;
 		read_index_number_pairs(parser, constraint_indexes, constraint_multipliers);
 	}
-	else if(strcmp(type_string, "uns") == 0) {
+	else if(type_string == "uns") {
 		type = ReasonType::TypeUNS;
 
 		// Extracts only four indices
@@ -127,85 +124,58 @@ inline Reason read_reason(Parser &parser) {
 			constraint_indexes.emplace_back(parser.get_unsigned_long());
 		}
 	}
-	else if(strcmp(type_string, "sol") == 0) {
+	else if(type_string == "sol") {
 		type = ReasonType::TypeSOL;
 	}
 	else {
 		throw runtime_error(format("Unexpected derivation name in line {}\n", parser.get_line_number()));
 	}
 
-	token = parser.get_token();
+	token = parser.get_required_token("close bracket");
 
-	if(strcmp(token, "}") != 0) {
+	if(token != "}") {
 		throw runtime_error(format("Expected close bracket in line {}\n", parser.get_line_number()));
 	}
 
 	return Reason(type, constraint_indexes, constraint_multipliers);
 }
 
-int main(int argc, char **argv) {
-	// Checks if the correct parameters were provided
-
-	if(argc < 4) {
-		fprintf(stderr, "usage: %s <vipr_certificate_in> <vipr_certificate_out> <expected_answer> [block_size]\n", argv[0]);
-		fprintf(stderr, "\n");
-		fprintf(stderr, "<expected_answer> should be either \"sat\" or \"unsat\"\n");
-		fprintf(stderr, "[block_size] (optional): # derivations dispatched at once to the checker\n");
-
-		return EXIT_FAILURE;
-	}
-
-	// Arguments #1 and #2
-	char *input_filename = argv[1];
-	char *output_filename = argv[2];
-
-	// Argument #3
-	bool expected_sat;
+inline std::pair<ConstraintRecord, Derivation> read_derivation(Parser &parser, unsigned long number_variables, unsigned long constraint_index) {
+	ConstraintRecord constraint = read_constraint(parser, number_variables);
+	Reason reason = read_reason(parser);
+	long index = parser.get_long();
 
-	if(strcmp(argv[3], "sat") == 0) {
-		expected_sat = true;
-	}
-	else if(strcmp(argv[3], "unsat") == 0) {
-		expected_sat = false;
-	}
-	else {
-		fprintf(stderr, "<expected_answer> should be either \"sat\" or \"unsat\"\n");
-
-		return EXIT_FAILURE;
-	}
-
-	// Argument #4
-	unsigned long block_size = 0;
-
-	if(argc >= 5) {
-		block_size = atoi(argv[4]);
-	}
-
-	// Creates the parser object that will return lines and tokens
-
-	Parser parser(input_filename);
+	return { std::move(constraint), Derivation(constraint_index, reason, index) };
+}
 
-	Certificate certificate;
+/**
+	Reads a text VIPR certificate.
 
-	// Main parsing loop
-
-	// Keep track of the computation time
-	auto begin_time = std::chrono::high_resolution_clock::now();
-
-	char *line;
-	char *token;
+	@param parser Parser over the certificate file
+	@param certificate Certificate that receives the parsed sections
+	@param streaming If true, DER blocks are generated while the DER section is parsed
+	@return EXIT_SUCCESS, or EXIT_FAILURE if the certificate is malformed
+*/
+int read_certificate(Parser &parser, Certificate &certificate, bool streaming) {
+	const char *line;
+	Token token;
 
     while((line = parser.get_line()) != nullptr) {
 		token = parser.get_token();
 
+		// Trailing blank lines: nothing left to parse
+		if(!token) {
+			break;
+		}
+
 		// Comment lines: Ignore
-		if(strcmp(token, "%") == 0) {
+		if(token == "%") {
 			continue;
 		}
 
 		// VAR: Get number of variables (unsigned long) followed by many variable names
 		//      separated by space or new lines
-		if(strcmp(token, "VAR") == 0) {
+		if(token == "VAR") {
 			certificate.number_variables = parser.get_unsigned_long();
 
 			certificate.variable_names.reserve(certificate.number_variables);
@@ -220,7 +190,7 @@ int main(int argc, char **argv) {
 
 		// INT: Get the number of integral variables (unsigned long) followed by many variable indexes
 		//      separated by space or new lines
-		if(strcmp(token, "INT") == 0) {
+		if(token == "INT") {
 			certificate.number_integral_variables = parser.get_unsigned_long();
 
 			for(unsigned long i = 0; i < certificate.number_integral_variables; i++) {
@@ -232,13 +202,13 @@ int main(int argc, char **argv) {
 
 		// OBJ: Followed by "min" or "max" and a sequence of pairs of unsigned long (for indexes)
 		//      and Number (for coefficients) separated by space or new lines
-		if(strcmp(token, "OBJ") == 0) {
-			char *min_or_max = parser.get_token();
+		if(token == "OBJ") {
+			Token min_or_max = parser.get_token();
 
-			if(strcmp(min_or_max, "min") == 0) {
+			if(min_or_max == "min") {
 				certificate.minimization = true;
 			}
-			else if(strcmp(min_or_max, "max") == 0) {
+			else if(min_or_max == "max") {
 				certificate.minimization = false;
 			}
 			else {
@@ -249,28 +219,46 @@ int main(int argc, char **argv) {
 
 			certificate.objective_coefficients.resize(certificate.number_variables);
 			read_coefficients(parser, certificate.objective_coefficients);
+
+			certificate.constraints.set_objective(certificate.objective_coefficients);
 		}
 
-		if(strcmp(token, "CON") == 0) {
+		if(token == "CON") {
 			certificate.number_problem_constraints = parser.get_unsigned_long();
 
 			// Not used
 			unsigned long bound_constraints = parser.get_unsigned_long();
 
-			for(unsigned long i = 0; i < certificate.number_problem_constraints; i++) {
-				certificate.constraints.emplace_back(read_constraint(parser, certificate.number_variables, certificate.objective_coefficients));
+			vector<ConstraintRecord> records;
+
+			// Large sections of mapped inputs are split across threads (the RTP line ends the section)
+			bool parsed = parse_section_in_parallel(parser, certificate.number_problem_constraints, parser.find_line_starting_with(parser.get_position(), "RTP"), records, [&] (Parser &chunk_parser) {
+				return read_constraint(chunk_parser, certificate.number_variables);
+			});
+
+			if(parsed) {
+				for(auto &record: records) {
+					certificate.constraints.add(record);
+				}
+			}
+			else {
+				for(unsigned long i = 0; i < certificate.number_problem_constraints; i++) {
+					ConstraintRecord record = read_constraint(parser, certificate.number_variables);
+
+					certificate.constraints.add(record);
+				}
 			}
 		}
 
-		if(strcmp(token, "RTP") == 0) {
-			char *token = parser.get_token();
+		if(token == "RTP") {
+			Token token = parser.get_token();
 
 			// Infeasible
-			if(strcmp(token, "infeas") == 0) {
+			if(token == "infeas") {
 				certificate.feasible = false;
 			}
 			// Feasible + range
-			else if(strcmp(token, "range") == 0) {
+			else if(token == "range") {
 				certificate.feasible = true;
 
 				certificate.feasible_lower_bound = parser.get_number_or_infinity();
@@ -283,7 +271,7 @@ int main(int argc, char **argv) {
 			}
 		}
 
-		if(strcmp(token, "SOL") == 0) {
+		if(token == "SOL") {
 			certificate.number_solutions = parser.get_unsigned_long();
 
 			for(unsigned long i = 0; i < certificate.number_solutions; i++) {
@@ -304,17 +292,51 @@ int main(int argc, char **argv) {
 			}
 		}
 
-		if(strcmp(token, "DER") == 0) {
+		if(token == "DER") {
 			certificate.number_derived_constraints = parser.get_unsigned_long();
 
-			for(unsigned long i = 0; i < certificate.number_derived_constraints; i++) {
-				Constraint constraint = read_constraint(parser, certificate.number_variables, certificate.objective_coefficients);
-				Reason reason = read_reason(parser);
-				long index = parser.get_long();
+#ifdef PARALLEL
+			// Pipelined mode: every earlier section is complete, so generation starts right away
+			// and each derivation is handed over as soon as it is parsed (in order)
+			if(streaming) {
+				certificate.start_streaming();
+
+				for(unsigned long i = 0; i < certificate.number_derived_constraints; i++) {
+					auto record = read_derivation(parser, certificate.number_variables, i + certificate.number_problem_constraints);
+
+					certificate.constraints.add(record.first);
+					certificate.derivations.emplace_back(std::move(record.second));
+
+					certificate.add_streamed_derivation();
+				}
+
+				continue;
+			}
+#endif /* PARALLEL */
+
+			vector<std::pair<ConstraintRecord, Derivation>> records;
+
+			// Large sections of mapped inputs are split across threads (DER runs until the end of the input)
+			bool parsed = parse_section_in_parallel(parser, certificate.number_derived_constraints, parser.get_mapping_end(), records, [&] (Parser &chunk_parser) {
+				// Constraint indexes are only known when the chunks are spliced together
+				return read_derivation(chunk_parser, certificate.number_variables, 0);
+			});
 
-				certificate.constraints.emplace_back(constraint);
+			if(parsed) {
+				for(unsigned long i = 0; i < certificate.number_derived_constraints; i++) {
+					records[i].second.constraint_index = i + certificate.number_problem_constraints;
+
+					certificate.constraints.add(records[i].first);
+					certificate.derivations.emplace_back(std::move(records[i].second));
+				}
+			}
+			else {
+				for(unsigned long i = 0; i < certificate.number_derived_constraints; i++) {
+					auto record = read_derivation(parser, certificate.number_variables, i + certificate.number_problem_constraints);
 
-				certificate.derivations.emplace_back(Derivation(i + certificate.number_problem_constraints, reason, index));
+					certificate.constraints.add(record.first);
+					certificate.derivations.emplace_back(std::move(record.second));
+				}
 			}
 
 			if(certificate.constraints.size() != certificate.number_problem_constraints + certificate.number_derived_constraints) {
@@ -325,19 +347,420 @@ int main(int argc, char **argv) {
 		}
     }
 
-	if(block_size == 0) {
-		block_size = std::max(1UL, certificate.number_derived_constraints / (2 * 192));
+	return EXIT_SUCCESS;
+}
+
+/**
+	Reads a comma-separated list of derivation types ("asm", "lin", "rnd", "uns", "sol") into
+	the types of a hybrid policy sent to the SMT solver.
+
+	@param list Derivation types (may be empty)
+	@param policy Hybrid policy (output)
+	@return Whether every type was recognized
+*/
+bool read_smt_types(const char *list, HybridPolicy &policy) {
+	constexpr const char *TYPE_NAMES[] = {"asm", "lin", "rnd", "uns", "sol"};
+
+	for(auto &selected: policy.smt_types) {
+		selected = false;
 	}
 
-	auto end_parsing = std::chrono::high_resolution_clock::now();
+	while(*list != '\0') {
+		size_t length = strcspn(list, ",");
+		bool found = false;
+
+		for(int type = ReasonType::TypeASM; type <= ReasonType::TypeSOL; type++) {
+			if(strlen(TYPE_NAMES[type]) == length && strncmp(list, TYPE_NAMES[type], length) == 0) {
+				policy.smt_types[type] = true;
+				found = true;
+			}
+		}
+
+		if(!found) {
+			return false;
+		}
+
+		list += length + (list[length] == ',');
+	}
+
+	return true;
+}
 
-	certificate.precompute();
+/**
+	Reads the fraction of derivations sent to the SMT solver by a hybrid policy.
 
-	auto end_precomputation = std::chrono::high_resolution_clock::now();
+	@param text Fraction, between 0 and 1
+	@param policy Hybrid policy (output)
+	@return Whether the text is a number between 0 and 1
+*/
+bool read_smt_fraction(const char *text, HybridPolicy &policy) {
+	char *end;
+
+	double fraction = strtod(text, &end);
+
+	if(end == text || *end != '\0' || !(fraction >= 0.0 && fraction <= 1.0)) {
+		return false;
+	}
+
+	policy.smt_fraction = fraction;
+
+	return true;
+}
+
+/**
+	Reads a comma-separated list of encoding options ("full-model", "aij-smt", "eq-leq-geq-smt",
+	and "parallel" or "serial"). Encoding options not listed are off; parallelism keeps its
+	default unless listed.
+
+	@param list Encoding options (may be empty)
+	@param mode Encoding mode (output)
+	@return Whether every option was recognized
+*/
+bool read_encoding_mode(const char *list, EncodingMode &mode) {
+	mode.full_model = false;
+	mode.aij_smt = false;
+	mode.eq_leq_geq_smt = false;
+
+	while(*list != '\0') {
+		size_t length = strcspn(list, ",");
+		string option(list, length);
+
+		if(option == "full-model") {
+			mode.full_model = true;
+		}
+		else if(option == "aij-smt") {
+			mode.aij_smt = true;
+		}
+		else if(option == "eq-leq-geq-smt") {
+			mode.eq_leq_geq_smt = true;
+		}
+		else if(option == "parallel") {
+			mode.parallel = true;
+		}
+		else if(option == "serial") {
+			mode.parallel = false;
+		}
+		else {
+			return false;
+		}
+
+		list += length + (list[length] == ',');
+	}
+
+	return true;
+}
+
+// Options of a mode, as given to --mode
+string get_mode_name(const EncodingMode &mode) {
+	string result;
+
+	if(mode.full_model) {
+		result += "full-model,";
+	}
+	if(mode.aij_smt) {
+		result += "aij-smt,";
+	}
+	if(mode.eq_leq_geq_smt) {
+		result += "eq-leq-geq-smt,";
+	}
+
+	result += (mode.parallel ? "parallel" : "serial");
+
+	return result;
+}
+
+/**
+	Generates the SMT formula of the certificate in every mode (each combination of encoding
+	options, serial and parallel), waits for the SMT solver on it, and reports the generation
+	time, the total time and the length of the formula of each mode.
+
+	@param certificate Precomputed certificate
+*/
+void benchmark_modes(Certificate &certificate) {
+	constexpr int NUMBER_MODES = 16;
+
+	string fastest_mode;
+	double fastest_time = 0.0;
+
+	fprintf(stderr, "%-44s %10s %10s %12s %s\n", "Mode", "Generation", "Total", "SMT bytes", "Result");
+
+	for(int combination = 0; combination < NUMBER_MODES; combination++) {
+		EncodingMode mode;
+
+		mode.full_model = (combination & 8) != 0;
+		mode.aij_smt = (combination & 4) != 0;
+		mode.eq_leq_geq_smt = (combination & 2) != 0;
+		mode.parallel = (combination & 1) != 0;
+
+		certificate.setup_mode(mode);
+
+		unsigned long output_length = certificate.get_output_length();
+
+		auto begin_time = std::chrono::high_resolution_clock::now();
+
+		certificate.print_formula();
+
+		auto end_generation = std::chrono::high_resolution_clock::now();
+
+		bool result_ok = certificate.get_evaluation_result();
+
+		auto end_total = std::chrono::high_resolution_clock::now();
+
+		double elapsed_generation = std::chrono::duration<double>(end_generation - begin_time).count();
+		double elapsed_total = std::chrono::duration<double>(end_total - begin_time).count();
+
+		string name = get_mode_name(mode);
+
+		fprintf(stderr, "%-44s %9.3lfs %9.3lfs %12lu %s\n", name.c_str(), elapsed_generation, elapsed_total, certificate.get_output_length() - output_length, (result_ok ? "OK" : "ERR"));
+
+		if(fastest_mode.empty() || elapsed_total < fastest_time) {
+			fastest_mode = name;
+			fastest_time = elapsed_total;
+		}
+	}
+
+	fprintf(stderr, "Fastest mode: --mode=%s\n", fastest_mode.c_str());
+}
+
+int main(int argc, char **argv) {
+	// Options may appear anywhere in the command line
+
+	bool streaming = false;
+	bool compile = false;
+	bool native = false;
+	bool hybrid = false;
+	bool dag = false;
+	bool benchmark = false;
+
+	// Build flags select the default mode
+	EncodingMode mode;
+
+	// By default, hybrid checks send RND and UNS derivations to the SMT solver
+	HybridPolicy hybrid_policy;
+
+	hybrid_policy.smt_types[ReasonType::TypeRND] = true;
+	hybrid_policy.smt_types[ReasonType::TypeUNS] = true;
+
+	vector<char *> arguments;
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--compile") == 0) {
+			compile = true;
+		}
+		else if(strcmp(argv[i], "--native") == 0) {
+			native = true;
+		}
+		else if(strcmp(argv[i], "--hybrid") == 0) {
+			hybrid = true;
+		}
+		else if(strncmp(argv[i], "--hybrid=", 9) == 0) {
+			hybrid = true;
+
+			if(!read_smt_types(argv[i] + 9, hybrid_policy)) {
+				fprintf(stderr, "Unknown derivation type in %s\n", argv[i]);
+
+				return EXIT_FAILURE;
+			}
+		}
+		else if(strncmp(argv[i], "--smt-fraction=", 15) == 0) {
+			hybrid = true;
+
+			if(!read_smt_fraction(argv[i] + 15, hybrid_policy)) {
+				fprintf(stderr, "Invalid SMT fraction in %s\n", argv[i]);
+
+				return EXIT_FAILURE;
+			}
+		}
+		else if(strcmp(argv[i], "--dag") == 0) {
+			dag = true;
+		}
+		else if(strncmp(argv[i], "--mode=", 7) == 0) {
+			if(!read_encoding_mode(argv[i] + 7, mode)) {
+				fprintf(stderr, "Unknown encoding option in %s\n", argv[i]);
+
+				return EXIT_FAILURE;
+			}
+		}
+		else if(strcmp(argv[i], "--benchmark-modes") == 0) {
+			benchmark = true;
+		}
+		else if(strcmp(argv[i], "--stream") == 0) {
+#ifdef PARALLEL
+			streaming = true;
+#else
+			fprintf(stderr, "--stream requires a build with -DPARALLEL (ignored)\n");
+#endif /* PARALLEL */
+		}
+		else if(strncmp(argv[i], "--", 2) == 0) {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+
+			return EXIT_FAILURE;
+		}
+		else {
+			arguments.emplace_back(argv[i]);
+		}
+	}
+
+	if(native && hybrid) {
+		fprintf(stderr, "--native and --hybrid cannot be combined\n");
+
+		return EXIT_FAILURE;
+	}
+
+	if(native && streaming) {
+		fprintf(stderr, "--stream does not apply to native checks (ignored)\n");
+
+		streaming = false;
+	}
+
+	if(native && benchmark) {
+		fprintf(stderr, "--benchmark-modes does not apply to native checks\n");
+
+		return EXIT_FAILURE;
+	}
+
+	// Every mode is generated from the complete certificate
+	if(benchmark && streaming) {
+		fprintf(stderr, "--stream does not apply to --benchmark-modes (ignored)\n");
+
+		streaming = false;
+	}
+
+	if(!mode.parallel && streaming) {
+		fprintf(stderr, "--stream requires parallel generation (ignored)\n");
+
+		streaming = false;
+	}
+
+	// Checks if the correct parameters were provided
+
+	if(arguments.size() < (compile ? 2 : 3)) {
+		fprintf(stderr, "usage: %s [--stream] [--dag] [--mode=<options> | --benchmark-modes] [--native | --hybrid[=<types>] [--smt-fraction=<f>]] <vipr_certificate_in> <vipr_certificate_out> <expected_answer> [block_size]\n", argv[0]);
+		fprintf(stderr, "       %s --compile <vipr_certificate_in> <binary_certificate_out>\n", argv[0]);
+		fprintf(stderr, "\n");
+		fprintf(stderr, "<vipr_certificate_in> can be a text (.vipr) or a compiled binary (.viprb) certificate\n");
+		fprintf(stderr, "<expected_answer> should be either \"sat\" or \"unsat\"\n");
+		fprintf(stderr, "[block_size] (optional): # derivations dispatched at once to the checker\n");
+		fprintf(stderr, "--stream (optional): generate DER blocks while derivations are still being parsed\n");
+		fprintf(stderr, "--native (optional): check solutions and derivations in-process with exact arithmetic instead of generating SMT for them\n");
+		fprintf(stderr, "--hybrid (optional): check derivations natively, except for the <types> (comma-separated, default rnd,uns) sent to SMT\n");
+		fprintf(stderr, "--smt-fraction (optional): also send a random fraction <f> of all derivations to SMT (implies --hybrid)\n");
+		fprintf(stderr, "--mode (optional): comma-separated encoding options full-model, aij-smt and eq-leq-geq-smt (others off), and parallel or serial generation (default: %s)\n", get_mode_name(EncodingMode()).c_str());
+		fprintf(stderr, "--benchmark-modes (optional): generate and check the formula in every mode, and report the times of each\n");
+		fprintf(stderr, "--dag (optional): build DER derivations as a term DAG, written with shared subterms bound by let (or evaluated with --native/--hybrid)\n");
+		fprintf(stderr, "--compile: parse a text certificate once and save it in the binary format\n");
+
+		return EXIT_FAILURE;
+	}
+
+	// Arguments #1 and #2
+	char *input_filename = arguments[0];
+	char *output_filename = arguments[1];
+
+	// Argument #3
+	bool expected_sat = true;
+
+	if(compile) {
+		// No expected answer when only compiling
+	}
+	else if(strcmp(arguments[2], "sat") == 0) {
+		expected_sat = true;
+	}
+	else if(strcmp(arguments[2], "unsat") == 0) {
+		expected_sat = false;
+	}
+	else {
+		fprintf(stderr, "<expected_answer> should be either \"sat\" or \"unsat\"\n");
+
+		return EXIT_FAILURE;
+	}
+
+	// Argument #4
+	unsigned long block_size = 0;
+
+	if(arguments.size() >= 4) {
+		block_size = atoi(arguments[3]);
+	}
+
+	Certificate certificate;
 
 	certificate.setup_output(output_filename, expected_sat, block_size);
 
-	certificate.print_formula();
+	if(hybrid) {
+		certificate.setup_hybrid(hybrid_policy);
+	}
+
+	if(dag) {
+		certificate.setup_dag();
+	}
+
+	certificate.setup_mode(mode);
+
+	// Keep track of the computation time
+	auto begin_time = std::chrono::high_resolution_clock::now();
+
+	// Keeps the parser (or the binary reader) alive: certificate strings live in its arenas (or input)
+	std::unique_ptr<Parser> parser;
+	std::unique_ptr<BinaryCertificateReader> binary_reader;
+
+	if(BinaryCertificateReader::is_binary_certificate(input_filename)) {
+		binary_reader = std::make_unique<BinaryCertificateReader>(input_filename);
+		binary_reader->read(certificate);
+	}
+	else {
+		// Creates the parser object that will return lines and tokens
+		parser = std::make_unique<Parser>(input_filename);
+
+		if(read_certificate(*parser, certificate, streaming && !compile) != EXIT_SUCCESS) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	if(compile) {
+		write_binary_certificate(certificate, output_filename);
+
+		double elapsed_compilation = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin_time).count();
+
+		fprintf(stderr, "Compiled %s into %s in %.3lf seconds\n", input_filename, output_filename, elapsed_compilation);
+
+		return EXIT_SUCCESS;
+	}
+
+	auto end_parsing = std::chrono::high_resolution_clock::now();
+	auto end_precomputation = end_parsing;
+
+	// Numbers were normalized as they were interned (by the parsing threads)
+	NumberPoolStatistics pool_statistics = number_pool.get_statistics();
+
+	if(pool_statistics.normalized_entries != 0) {
+		fprintf(stderr, "Normalized %lu of %lu interned numbers (SMT renderings %lu bytes shorter)\n", pool_statistics.normalized_entries, pool_statistics.number_entries, pool_statistics.saved_bytes);
+	}
+
+#ifdef PARALLEL
+	if(certificate.is_streaming()) {
+		// Dependencies were computed during parsing: only the remaining blocks are left
+		certificate.finish_streaming();
+	}
+#endif /* PARALLEL */
+
+	if(!certificate.is_streaming()) {
+		certificate.precompute();
+
+		end_precomputation = std::chrono::high_resolution_clock::now();
+
+		if(benchmark) {
+			benchmark_modes(certificate);
+
+			return EXIT_SUCCESS;
+		}
+
+		if(native) {
+			certificate.check_native();
+		}
+		else {
+			certificate.print_formula();
+		}
+	}
 
 	auto end_generation = std::chrono::high_resolution_clock::now();
 
@@ -351,7 +774,7 @@ int main(int argc, char **argv) {
 	double elapsed_generation = std::chrono::duration<double>(end_generation - begin_time).count();
 	double elapsed_total = std::chrono::duration<double>(end_total - begin_time).count();
 
-	fprintf(stderr, "Results: %s|%s|%ld|%.3lf|%.3lf|%.3lf|%.3lf|%ld|%ld|%ld|%ld|%d|%d|%d\n", input_filename, (result_ok ? "OK" : "ERR"), block_size, elapsed_parsing, elapsed_precomputation, elapsed_generation, elapsed_total, certificate.number_variables, certificate.number_problem_constraints, certificate.number_derived_constraints, certificate.number_solutions, certificate.feasible ? 1 : 0, certificate.feasible_lower_bound.is_negative_infinity ? 1 : 0, certificate.feasible_upper_bound.is_positive_infinity ? 1 : 0);
+	fprintf(stderr, "Results: %s|%s|%ld|%.3lf|%.3lf|%.3lf|%.3lf|%ld|%ld|%ld|%ld|%d|%d|%d\n", input_filename, (result_ok ? "OK" : "ERR"), certificate.get_block_size(), elapsed_parsing, elapsed_precomputation, elapsed_generation, elapsed_total, certificate.number_variables, certificate.number_problem_constraints, certificate.number_derived_constraints, certificate.number_solutions, certificate.feasible ? 1 : 0, certificate.feasible_lower_bound.is_negative_infinity() ? 1 : 0, certificate.feasible_upper_bound.is_positive_infinity() ? 1 : 0);
 
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,378 @@
+#include "number_pool.h"
+#include "rational.h"
+
+#include <algorithm>
+#include <string>
+
+#include <stdexcept>
+#include <format>
+
+using std::string;
+
+using std::runtime_error;
+using std::format;
+
+NumberPool number_pool;
+
+thread_local NumberPool::CacheSlot NumberPool::cache[NumberPool::CACHE_SLOTS];
+
+NumberPool::NumberPool() {
+	for(auto &shard: shards) {
+		shard.identifiers.resize(SHARD_TABLE_SLOTS, CacheSlot{0, 0});
+		shard.number_entries = 0;
+
+		shard.text_block_watermark = 0;
+		shard.text_block_length = 0;
+
+		shard.normalized_entries = 0;
+		shard.saved_bytes = 0;
+	}
+}
+
+NumberPool::~NumberPool() {
+}
+
+char *NumberPool::Shard::allocate_text(size_t length) {
+	if(text_block_watermark + length > text_block_length) {
+		text_block_length = std::max(length, TEXT_BLOCK_LENGTH);
+
+		text_blocks.emplace_back(new char[text_block_length]);
+		text_block_watermark = 0;
+	}
+
+	char *result = text_blocks.back().get() + text_block_watermark;
+
+	text_block_watermark += length;
+
+	return result;
+}
+
+uint32_t NumberPool::get_entry_flags(const char *text, size_t length) {
+	const char *slash = static_cast<const char *>(memchr(text, '/', length));
+
+	size_t numerator_length = (slash != nullptr ? slash - text : length);
+
+	uint32_t flags = 0;
+
+	if(slash == nullptr) {
+		flags |= NumberIntegral;
+	}
+
+	if(numerator_length == 1 && text[0] == '0') {
+		flags |= NumberZero;
+	}
+
+	if(length > 0 && text[0] == '-') {
+		flags |= NumberNegative;
+	}
+
+	if(length == 3 && memcmp(text, "inf", 3) == 0) {
+		flags |= NumberPositiveInfinity;
+	}
+
+	if(length == 4 && memcmp(text, "-inf", 4) == 0) {
+		flags |= NumberNegativeInfinity;
+	}
+
+	return flags;
+}
+
+// An optional '-' followed by decimal digits
+static inline bool is_integral_text(const char *text, size_t length) {
+	size_t start = (length > 0 && text[0] == '-');
+
+	if(start == length) {
+		return false;
+	}
+
+	for(size_t i = start; i < length; i++) {
+		if(text[i] < '0' || text[i] > '9') {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+	Canonical numerator and denominator of a number text (see NumberEntry).
+
+	@param text Number text
+	@param length Length of the text
+	@param numerator Canonical numerator (set when the result is true)
+	@param denominator Canonical denominator (set when the result is true)
+	@return False if the text is already canonical, or is kept as written (not an integer or
+	fraction, or with a zero denominator)
+*/
+static bool get_canonical_parts(const char *text, size_t length, string &numerator, string &denominator) {
+	const char *slash = static_cast<const char *>(memchr(text, '/', length));
+
+	size_t numerator_length = (slash != nullptr ? slash - text : length);
+
+	if(!is_integral_text(text, numerator_length)) {
+		return false;
+	}
+
+	if(slash == nullptr) {
+		size_t start = (text[0] == '-');
+
+		// Integers only need work for leading zeros and "-0"
+		if(text[start] != '0' || (length == 1)) {
+			return false;
+		}
+	}
+	else {
+		const char *denominator_text = slash + 1;
+		size_t denominator_length = length - numerator_length - 1;
+
+		if(!is_integral_text(denominator_text, denominator_length)) {
+			return false;
+		}
+
+		if(strspn(denominator_text + (denominator_text[0] == '-'), "0") == denominator_length - (denominator_text[0] == '-')) {
+			return false;
+		}
+	}
+
+	Rational value = Rational::parse(text, length);
+
+	numerator = value.get_numerator().to_string();
+	denominator = value.get_denominator().to_string();
+
+	// Fractions already in lowest terms (with a denominator other than 1)
+	return (slash == nullptr || denominator == "1" || numerator.size() + denominator.size() + 1 != length || memcmp(text, numerator.data(), numerator.size()) != 0 || memcmp(slash + 1, denominator.data(), denominator.size()) != 0);
+}
+
+// Length of the SMT rendering of a numerator and a denominator (without it when integral)
+static inline size_t get_smt_length(size_t numerator_length, bool numerator_negative, size_t denominator_length, bool denominator_negative, bool integral) {
+	size_t result = numerator_length + (numerator_negative ? 3 : 0);
+
+	if(!integral) {
+		result += 5 + denominator_length + (denominator_negative ? 3 : 0);
+	}
+
+	return result;
+}
+
+/**
+	Returns the identifier of a number text, creating its entry on first sight.
+
+	@param text Number text (integral, or numerator and denominator separated by '/')
+	@param length Length of the text
+	@return Identifier of the interned number
+*/
+uint32_t NumberPool::intern(const char *text, size_t length) {
+	uint64_t hash = get_number_hash(text, length);
+
+	CacheSlot &slot = cache[hash & (CACHE_SLOTS - 1)];
+
+	// Only identifiers this thread already received are cached: their entries are readable
+	if(slot.id_plus_one != 0 && slot.hash == hash) {
+		NumberEntry &entry = get(slot.id_plus_one - 1);
+
+		if(entry.text_length == length && memcmp(entry.text, text, length) == 0) {
+			return slot.id_plus_one - 1;
+		}
+	}
+
+	uint32_t id = intern_locked(hash, text, length);
+
+	slot.hash = hash;
+	slot.id_plus_one = id + 1;
+
+	return id;
+}
+
+uint32_t NumberPool::intern_locked(uint64_t hash, const char *text, size_t length) {
+	uint32_t shard_index = (hash >> (64 - SHARD_BITS));
+
+	Shard &shard = shards[shard_index];
+
+	std::lock_guard<mutex> lock(shard.serializer);
+
+	size_t mask = shard.identifiers.size() - 1;
+	size_t position = (hash & mask);
+
+	// The low hash bits pick the slot (the high ones picked the shard)
+	while(shard.identifiers[position].id_plus_one != 0) {
+		CacheSlot &slot = shard.identifiers[position];
+
+		if(slot.hash == hash) {
+			NumberEntry &entry = get(slot.id_plus_one - 1);
+
+			if(entry.text_length == length && memcmp(entry.text, text, length) == 0) {
+				return slot.id_plus_one - 1;
+			}
+		}
+
+		position = (position + 1) & mask;
+	}
+
+	uint32_t local = shard.number_entries;
+
+	if(local >= (1UL << (32 - SHARD_BITS)) - 1) {
+		throw runtime_error(format("Error: more than {} distinct numbers in a pool shard\n", local));
+	}
+
+	unsigned int chunk = 63 - __builtin_clzll((static_cast<uint64_t>(local) >> FIRST_CHUNK_BITS) + 1);
+
+	if(!shard.chunks[chunk]) {
+		shard.chunks[chunk].reset(new NumberEntry[1UL << (FIRST_CHUNK_BITS + chunk)]);
+	}
+
+	uint32_t id = (local << SHARD_BITS) | shard_index;
+
+	NumberEntry &entry = shard.chunks[chunk][local - (((1UL << chunk) - 1) << FIRST_CHUNK_BITS)];
+
+	const char *slash = static_cast<const char *>(memchr(text, '/', length));
+
+	size_t numerator_length = (slash != nullptr ? slash - text : length);
+	size_t denominator_length = (slash != nullptr ? length - numerator_length - 1 : 1);
+
+	const char *numerator = text;
+	const char *denominator = (slash != nullptr ? slash + 1 : "1");
+
+	bool integral = (slash == nullptr);
+
+	string canonical_numerator;
+	string canonical_denominator;
+
+	entry.flags = get_entry_flags(text, length);
+	entry.small = false;
+	entry.small_value = 0;
+
+	if(get_canonical_parts(text, length, canonical_numerator, canonical_denominator)) {
+		size_t raw_smt_length = get_smt_length(numerator_length, numerator[0] == '-', denominator_length, denominator[0] == '-', integral);
+
+		integral = (canonical_denominator == "1");
+
+		string canonical = (integral ? canonical_numerator : canonical_numerator + "/" + canonical_denominator);
+
+		entry.flags = get_entry_flags(canonical.c_str(), canonical.size());
+
+		numerator = canonical_numerator.c_str();
+		numerator_length = canonical_numerator.size();
+
+		denominator = canonical_denominator.c_str();
+		denominator_length = canonical_denominator.size();
+
+		if(integral && numerator_length - (numerator[0] == '-') <= Number::MAXIMUM_INLINE_DIGITS) {
+			entry.small = true;
+			entry.small_value = std::stoll(canonical_numerator);
+		}
+
+		shard.normalized_entries++;
+		shard.saved_bytes += raw_smt_length - get_smt_length(numerator_length, numerator[0] == '-', denominator_length, false, integral);
+	}
+
+	// Layout: text, numerator and denominator (each '\0'-terminated), then the SMT rendering,
+	// which is never longer than the text plus 10 bytes ("(/ (- a) (- b))"; canonical forms
+	// are never longer than the text)
+	char *storage = shard.allocate_text((length + 1) + (numerator_length + 1) + (denominator_length + 1) + (length + 11));
+
+	entry.text = storage;
+	entry.text_length = length;
+	memcpy(entry.text, text, length);
+	entry.text[length] = '\0';
+
+	entry.numerator = entry.text + length + 1;
+	memcpy(entry.numerator, numerator, numerator_length);
+	entry.numerator[numerator_length] = '\0';
+
+	entry.denominator = entry.numerator + numerator_length + 1;
+	memcpy(entry.denominator, denominator, denominator_length);
+	entry.denominator[denominator_length] = '\0';
+
+	entry.smt = entry.denominator + denominator_length + 1;
+
+	char *output = entry.smt;
+
+	auto render_integral = [&output] (const char *integral, size_t integral_length) {
+		if(integral[0] == '-') {
+			memcpy(output, "(- ", 3);
+			memcpy(output + 3, integral + 1, integral_length - 1);
+			output[integral_length + 2] = ')';
+
+			output += integral_length + 3;
+		}
+		else {
+			memcpy(output, integral, integral_length);
+
+			output += integral_length;
+		}
+	};
+
+	if(integral) {
+		render_integral(entry.numerator, numerator_length);
+	}
+	else {
+		memcpy(output, "(/ ", 3);
+		output += 3;
+
+		render_integral(entry.numerator, numerator_length);
+		*output++ = ' ';
+		render_integral(entry.denominator, denominator_length);
+		*output++ = ')';
+	}
+
+	*output = '\0';
+
+	entry.smt_length = output - entry.smt;
+
+	shard.identifiers[position] = CacheSlot{hash, id + 1};
+	shard.number_entries++;
+
+	if(2 * shard.number_entries > shard.identifiers.size()) {
+		grow_table(shard);
+	}
+
+	return id;
+}
+
+void NumberPool::grow_table(Shard &shard) {
+	vector<CacheSlot> identifiers(2 * shard.identifiers.size(), CacheSlot{0, 0});
+
+	size_t mask = identifiers.size() - 1;
+
+	for(auto &slot: shard.identifiers) {
+		if(slot.id_plus_one == 0) {
+			continue;
+		}
+
+		size_t position = (slot.hash & mask);
+
+		while(identifiers[position].id_plus_one != 0) {
+			position = (position + 1) & mask;
+		}
+
+		identifiers[position] = slot;
+	}
+
+	shard.identifiers.swap(identifiers);
+}
+
+NumberPoolStatistics NumberPool::get_statistics() {
+	NumberPoolStatistics result{0, 0, 0};
+
+	for(auto &shard: shards) {
+		std::lock_guard<mutex> lock(shard.serializer);
+
+		result.number_entries += shard.number_entries;
+		result.normalized_entries += shard.normalized_entries;
+		result.saved_bytes += shard.saved_bytes;
+	}
+
+	return result;
+}
+
+size_t NumberPool::size() {
+	size_t result = 0;
+
+	for(auto &shard: shards) {
+		std::lock_guard<mutex> lock(shard.serializer);
+
+		result += shard.number_entries;
+	}
+
+	return result;
+}
@@ -0,0 +1,159 @@
+#ifndef NUMBER_POOL_H
+#define NUMBER_POOL_H
+
+#include <cstdint>
+#include <cstring>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::mutex;
+using std::unique_ptr;
+using std::vector;
+
+enum NumberFlags: uint32_t {
+	NumberZero = 1,
+	NumberNegative = 2,
+	NumberIntegral = 4,
+	NumberPositiveInfinity = 8,
+	NumberNegativeInfinity = 16
+};
+
+/**
+	Interned number. Everything but the text describes the canonical form of the number: the
+	fraction in lowest terms with a positive denominator, integral fractions as integers, and a
+	single zero ("6/4", "-0", "007" and "8/-2" are rendered as "(/ 3 2)", "0", "7" and "(- 4)").
+	Texts that are not integers or fractions (infinities) are kept as written.
+*/
+struct NumberEntry {
+	// Text as found in the certificate ("-3", "1/2", "inf")
+	char *text;
+	size_t text_length;
+
+	// Numerator and denominator ("1" for integral numbers)
+	char *numerator;
+	char *denominator;
+
+	// Pre-rendered SMT-LIB literal ("(- 3)", "(/ 1 2)")
+	char *smt;
+	uint32_t smt_length;
+
+	uint32_t flags;
+
+	// Non-canonical texts of small integers ("007", "8/2") are inlined by Number::from_pool
+	bool small;
+	int64_t small_value;
+};
+
+struct NumberPoolStatistics {
+	// Distinct number texts
+	size_t number_entries;
+
+	// Entries whose canonical form differs from their text
+	size_t normalized_entries;
+
+	// Bytes saved by the canonical SMT renderings (once per entry)
+	size_t saved_bytes;
+};
+
+// FNV-1a hash of a number text
+constexpr uint64_t get_number_hash(const char *text, size_t length) {
+	uint64_t result = 14695981039346656037ULL;
+
+	for(size_t i = 0; i < length; i++) {
+		result = (result ^ static_cast<unsigned char>(text[i])) * 1099511628211ULL;
+	}
+
+	return result;
+}
+
+/**
+	Global table of interned numbers: every distinct number text is stored (and rendered)
+	once, and a Number refers to it by the 32-bit identifier of its entry. Canonical small
+	integers are kept inline in the Number instead (see basic_types.h).
+
+	The table is split into shards by text hash, each with its own lock, so that parsing
+	threads can intern concurrently. Entries never move once created: lookups by identifier
+	take no lock. An identifier is only obtained after its entry is complete (under the shard
+	lock), so any thread that receives one can read the entry.
+*/
+class NumberPool {
+public:
+	constexpr static unsigned int SHARD_BITS = 6;
+	constexpr static unsigned int NUMBER_SHARDS = (1U << SHARD_BITS);
+
+	// Entries of a shard live in chunks of doubling sizes (1024, 2048, ...): no reallocation
+	constexpr static unsigned int FIRST_CHUNK_BITS = 10;
+	constexpr static unsigned int MAXIMUM_CHUNKS = (32 - SHARD_BITS - FIRST_CHUNK_BITS + 1);
+
+	// Texts and renderings are copied into blocks of this size (or larger, for huge numbers)
+	constexpr static size_t TEXT_BLOCK_LENGTH = 64 * 1024;
+
+	// Per-thread direct-mapped cache of recent lookups: repeated numbers skip the shard lock
+	constexpr static size_t CACHE_SLOTS = 4096;
+
+	// Initial number of slots of each shard table
+	constexpr static size_t SHARD_TABLE_SLOTS = 1024;
+
+private:
+	struct CacheSlot {
+		uint64_t hash;
+		uint32_t id_plus_one; // 0 for empty slots
+	};
+
+	struct Shard {
+		mutex serializer;
+
+		// Open-addressing table (linear probing), kept at most half full
+		vector<CacheSlot> identifiers;
+
+		uint32_t number_entries;
+		unique_ptr<NumberEntry[]> chunks[MAXIMUM_CHUNKS];
+
+		vector<unique_ptr<char[]>> text_blocks;
+		size_t text_block_watermark;
+		size_t text_block_length;
+
+		size_t normalized_entries;
+		size_t saved_bytes;
+
+		char *allocate_text(size_t length);
+	};
+
+	Shard shards[NUMBER_SHARDS];
+
+	static thread_local CacheSlot cache[CACHE_SLOTS];
+
+	static uint32_t get_entry_flags(const char *text, size_t length);
+
+	uint32_t intern_locked(uint64_t hash, const char *text, size_t length);
+	void grow_table(Shard &shard);
+
+public:
+	NumberPool();
+	virtual ~NumberPool();
+
+	// Returns the identifier of a number text, creating its entry on first sight (thread-safe)
+	uint32_t intern(const char *text, size_t length);
+
+	inline NumberEntry &get(uint32_t id) {
+		Shard &shard = shards[id & (NUMBER_SHARDS - 1)];
+
+		uint32_t local = (id >> SHARD_BITS);
+
+		// Chunk c holds the local indexes [1024 * (2^c - 1), 1024 * (2^(c + 1) - 1))
+		unsigned int chunk = 63 - __builtin_clzll((static_cast<uint64_t>(local) >> FIRST_CHUNK_BITS) + 1);
+
+		return shard.chunks[chunk][local - (((1UL << chunk) - 1) << FIRST_CHUNK_BITS)];
+	}
+
+	// Number of distinct numbers (not synchronized with concurrent interning)
+	size_t size();
+
+	NumberPoolStatistics get_statistics();
+};
+
+extern NumberPool number_pool;
+
+#endif /* NUMBER_POOL_H */
@@ -0,0 +1,137 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include <algorithm>
+#include <vector>
+#include <thread>
+
+#include "parser.h"
+
+using std::vector;
+using std::thread;
+
+// Sections smaller than this (per thread) are not worth splitting
+constexpr size_t PARALLEL_PARSER_MINIMUM_CHUNK = 4 * 1024 * 1024;
+
+/**
+	Parses number_records consecutive records of a memory-mapped input in parallel.
+	The byte range between the parser position and section_end is split at line boundaries,
+	each chunk is parsed by its own Parser view, and the records are appended to records
+	in input order. On success, the parser resumes at section_end with the right line count.
+	Strings kept by the records live in arenas owned by the parser.
+
+	If a chunk fails (for instance, a record spans a chunk boundary) or the number of records
+	does not match, false is returned: the caller then parses the section sequentially (the
+	input is never modified), which also reproduces the exact error messages.
+
+	@param parser Parser positioned right before the first record
+	@param number_records Number of records declared in the section header
+	@param section_end First byte after the section
+	@param records Vector that receives the parsed records
+	@param read_record Callable that parses one record from a Parser
+	@return True if the section was parsed, false if it has to be parsed sequentially
+*/
+template<typename T, typename F>
+bool parse_section_in_parallel(Parser &parser, unsigned long number_records, const char *section_end, vector<T> &records, F &&read_record) {
+	const char *section_begin = parser.get_position();
+
+	if(section_begin == nullptr || section_end == nullptr || section_end <= section_begin) {
+		return false;
+	}
+
+	size_t section_length = section_end - section_begin;
+
+	unsigned long number_chunks = std::min(static_cast<unsigned long>(std::thread::hardware_concurrency()), section_length / PARALLEL_PARSER_MINIMUM_CHUNK);
+
+	if(number_chunks < 2) {
+		return false;
+	}
+
+	// Chunk boundaries: each one is moved forward to the start of the next line
+	vector<const char *> boundaries;
+
+	boundaries.emplace_back(section_begin);
+
+	for(unsigned long chunk = 1; chunk < number_chunks; chunk++) {
+		const char *boundary = std::max(section_begin + (chunk * section_length) / number_chunks, boundaries.back());
+		const char *newline = static_cast<const char *>(memchr(boundary, '\n', section_end - boundary));
+
+		if(newline == nullptr) {
+			break;
+		}
+
+		boundaries.emplace_back(newline + 1);
+	}
+
+	boundaries.emplace_back(section_end);
+
+	number_chunks = boundaries.size() - 1;
+
+	vector<vector<T>> chunk_records(number_chunks);
+	vector<unsigned long> chunk_lines(number_chunks, 0);
+	vector<char> chunk_failed(number_chunks, false);
+
+	// Names copied by the chunk parsers must outlive them
+	size_t first_arena = parser.get_chunk_arena_count();
+
+	vector<Arena *> chunk_arenas;
+
+	for(unsigned long chunk = 0; chunk < number_chunks; chunk++) {
+		chunk_arenas.emplace_back(&parser.add_chunk_arena());
+	}
+
+	vector<thread> threads;
+
+	for(unsigned long chunk = 0; chunk < number_chunks; chunk++) {
+		threads.emplace_back([&] (unsigned long chunk) {
+			Parser chunk_parser(boundaries[chunk], boundaries[chunk + 1], *chunk_arenas[chunk]);
+
+			try {
+				while(chunk_parser.skip_blank_lines()) {
+					chunk_records[chunk].emplace_back(read_record(chunk_parser));
+				}
+			}
+			catch(std::exception &) {
+				chunk_failed[chunk] = true;
+			}
+
+			chunk_lines[chunk] = chunk_parser.get_line_number();
+		},
+		chunk);
+	}
+
+	for(auto &thread: threads) {
+		thread.join();
+	}
+
+	unsigned long total_records = 0;
+	unsigned long total_lines = 0;
+	bool failed = false;
+
+	for(unsigned long chunk = 0; chunk < number_chunks; chunk++) {
+		total_records += chunk_records[chunk].size();
+		total_lines += chunk_lines[chunk];
+
+		failed |= chunk_failed[chunk];
+	}
+
+	if(failed || total_records != number_records) {
+		parser.drop_chunk_arenas(first_arena);
+
+		return false;
+	}
+
+	records.reserve(records.size() + total_records);
+
+	for(auto &chunk: chunk_records) {
+		for(auto &record: chunk) {
+			records.emplace_back(std::move(record));
+		}
+	}
+
+	parser.skip_to(section_end, total_lines);
+
+	return true;
+}
+
+#endif /* PARALLEL_PARSER_H */
@@ -3,20 +3,40 @@
 
 #include "parser.h"
 
-Parser::Parser(char *filename): line{nullptr}, token{nullptr}, eof{false} {
+Parser::Parser(char *filename): mapping{nullptr}, mapping_end{nullptr}, line{nullptr}, eof{false}, strings{&arena} {
     fd = file_helper.open_input(filename);
 
-    buffer.resize(BUFFER_SIZE + 1);
-    buffer[0] = '\0';
+    size_t input_length;
 
-    next_line = &buffer[0];
+    // Regular files are parsed in place; pipes fall back to chunked read() calls
+    mapping = file_helper.map_input(&input_length);
+
+    if(mapping != nullptr) {
+        mapping_end = mapping + input_length;
+
+        next_line = mapping;
+
+        // The whole input is already available
+        eof = true;
+    }
+    else {
+        buffer.resize(BUFFER_SIZE + 1 + SCANNER_PADDING);
+        buffer[0] = '\0';
+
+        next_line = &buffer[0];
+    }
 
     line = nullptr;
-    token = nullptr;
 
     line_number = 0;
 }
 
+Parser::Parser(const char *begin, const char *end, Arena &strings): fd{-1}, mapping{begin}, mapping_end{end}, next_line{begin}, line{nullptr}, line_number{0}, eof{true}, strings{&strings} {
+    // View over a range of an input mapped by another parser: nothing to open
+}
+
 Parser::~Parser() {
-    file_helper.close_input();
+    if(fd != -1) {
+        file_helper.close_input();
+    }
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 
 #include <cstring>
 #include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
 
 #include <format>
 
@@ -10,7 +13,8 @@
 
 #include "basic_types.h"
 #include "file_helper.h"
-#include "LinearAllocator.hpp"
+#include "scanner.h"
+#include "Arena.hpp"
 
 using std::string;
 using std::vector;
@@ -19,6 +23,25 @@ using std::format;
 
 using std::runtime_error;
 
+// View of a token inside the input (not '\0'-terminated)
+struct Token {
+	const char *data;
+	size_t length;
+
+	// Whether a token was found (false at the end of the input)
+	inline explicit operator bool() const {
+		return (data != nullptr);
+	}
+
+	inline bool operator==(const char *text) const {
+		return (data != nullptr && strncmp(data, text, length) == 0 && text[length] == '\0');
+	}
+
+	inline string get_string() const {
+		return string(data, length);
+	}
+};
+
 class Parser {
 	constexpr static long BUFFER_SIZE = 16384;
 
@@ -28,14 +51,17 @@ class Parser {
 	// Data buffer: gets constantly resized down when tokenization consumes all data
 	vector<char> buffer;
 
-	// Points to the first byte of unconsumed data (or nullptr if a new line needs to be sourced)
-	char *next_line;
+	// Read-only memory-mapped input: lines and tokens are views into the mapping (nullptr for pipes)
+	const char *mapping;
 
-	// Points to the last returned line
-	char *line;
+	// Points one past the last byte of the mapped input
+	const char *mapping_end;
+
+	// Points to the first byte of unconsumed data (or nullptr if a new line needs to be sourced)
+	const char *next_line;
 
-	// Points to the last returned token
-	char *token;
+	// Points to the unconsumed part of the current line (or nullptr if a new line needs to be sourced)
+	const char *line;
 
 	// Current line number from the input file
 	unsigned long line_number;
@@ -43,28 +69,58 @@ class Parser {
 	// End-of-file (EOF) flag
 	bool eof;
 
-	// Allocates all permanent strings in a linear buffer, reducing calls to malloc()
-	LinearAllocator<char> linear_allocator;
+	// Allocates all permanent strings in an arena, reducing calls to malloc()
+	Arena arena;
+
+	// Arena that receives the permanent strings: the one above, or one lent by the parser of the whole input
+	Arena *strings;
+
+	// Arenas lent to the parsers of chunks of this input (their strings outlive the chunk parsers)
+	vector<std::unique_ptr<Arena>> chunk_arenas;
 
 	// File helper that provides some useful input/output functions
 	FileHelper file_helper;
 
+	// Line (or line fragment) delimiters: tokens and lines never extend past them
+	static inline bool is_line_end(char character) {
+		return (character == '\n' || character == '\0');
+	}
+
 public:
 	Parser(char *filename);
+	Parser(const char *begin, const char *end, Arena &strings);
 	virtual ~Parser();
 
 	//////////////////////
 	// Memory functions //
 	//////////////////////
 
-	inline char *get_stable_string(char *token) {
-		char *stable_token = linear_allocator.allocate(strlen(token) + 1) ;
+	// Copies a token that outlives parsing (such as a name) into the arena
+	inline char *get_stable_string(Token token) {
+		char *stable_token = strings->allocate<char>(token.length + 1);
 
-		strcpy(stable_token, token);
+		memcpy(stable_token, token.data, token.length);
+		stable_token[token.length] = '\0';
 
 		return stable_token;
 	}
 
+	// Creates an arena for the strings of a chunk parser, kept as long as this parser
+	inline Arena &add_chunk_arena() {
+		chunk_arenas.emplace_back(std::make_unique<Arena>());
+
+		return *chunk_arenas.back();
+	}
+
+	// Releases the arenas added after the first count ones
+	inline void drop_chunk_arenas(size_t count) {
+		chunk_arenas.resize(count);
+	}
+
+	inline size_t get_chunk_arena_count() {
+		return chunk_arenas.size();
+	}
+
 	////////////////////////////
 	// Core parsing functions //
 	////////////////////////////
@@ -73,12 +129,15 @@ public:
 	using conversion_function = T(*)(const char *, char **, int);
 
 	template<typename T, conversion_function<T> F>
-	inline T convert(char *token, int line_number) {
+	inline T convert(Token token, int line_number) {
+		// Only the slow path needs a '\0'-terminated copy of the token
+		string text = token.get_string();
+
 		char *leftover;
 		T converted;
 
 		errno = 0;
-		converted = F(token, &leftover, 10);
+		converted = F(text.c_str(), &leftover, 10);
 
 		if(errno != 0) {
 			throw runtime_error(format("Error in line {}: {}\n", line_number, strerror(errno)));
@@ -91,59 +150,69 @@ public:
 		return converted;
 	} 
 
-	inline long parse_long(char *token) {
+	// Tokens come from the parser buffers, which are padded for the SWAR fast paths;
+	// anything the fast paths reject goes through strtol()/strtoul() for error reporting
+
+	inline long parse_long(Token token) {
+		long value;
+
+		if(parse_signed_swar(token.data, token.length, &value)) {
+			return value;
+		}
+
 		return convert<long, strtol>(token, line_number);
 	}
 
-	inline unsigned long parse_unsigned_long(char *token) {
+	inline unsigned long parse_unsigned_long(Token token) {
+		unsigned long value;
+
+		if(parse_unsigned_swar(token.data, token.length, &value)) {
+			return value;
+		}
+
 		return convert<unsigned long, strtoul>(token, line_number);
 	}
 
-	inline Number parse_number(char *token) {
-		if(strchr(token, '/') == nullptr) {
-			return Number(get_stable_string(token));
-		}
-		else {
-			char *fraction_token = token;
+	inline Number parse_number(Token token) {
+		const char *slash = static_cast<const char *>(memchr(token.data, '/', token.length));
 
-			char *numerator = strsep(&fraction_token, "/");
-			char *numerator_stable = get_stable_string(numerator);
-			char *denominator = strsep(&fraction_token, "/");
-			char *denominator_stable = get_stable_string(denominator);
+		if(slash != nullptr) {
+			const char *leftover = static_cast<const char *>(memchr(slash + 1, '/', token.length - (slash + 1 - token.data)));
 
-			if(fraction_token != nullptr) {
-				throw runtime_error(format("Error in line {}: leftover bytes in token ({})\n", line_number, fraction_token));
+			if(leftover != nullptr) {
+				throw runtime_error(format("Error in line {}: leftover bytes in token ({})\n", line_number, string(leftover + 1, token.data + token.length)));
 			}
-
-			return Number(numerator_stable, denominator_stable);
 		}
+
+		// Small integers are inlined; interned numbers keep their own copy of the text
+		return Number::from_text(token.data, token.length);
 	}
 
-	inline Number parse_number_or_infinity(char *token) {
-		if(strstr(token, "inf") == nullptr) {
+	inline Number parse_number_or_infinity(Token token) {
+		if(std::string_view(token.data, token.length).find("inf") == std::string_view::npos) {
 			return parse_number(token);
 		}
 		else {
-			if(strcmp(token, "inf") == 0) {
-				Number number("inf");
-				number.is_positive_infinity = true;
-
-				return number;
+			if(token == "inf" || token == "-inf") {
+				return Number::from_text(token.data, token.length);
 			}
 
-			if(strcmp(token, "-inf") == 0) {
-				Number number("-inf");
-				number.is_negative_infinity = true;
+			throw runtime_error(format("Error in line {}: extraneous bytes in token ({})\n", line_number, token.get_string()));
+		}
+	}
 
-				return number;
-			}
+	inline Token get_required_token(const char *expected) {
+		Token token = get_token();
 
-			throw runtime_error(format("Error in line {}: extraneous bytes in token ({})\n", line_number, token));
+		if(!token) {
+			throw runtime_error(format("Error in line {}: expected {}\n", line_number, expected));
 		}
+
+		return token;
 	}
 
 	inline long get_long() {
-		char *token = get_token();
+		Token token = get_token();
 
 		if(!token) {
 			throw runtime_error(format("Error in line {}: expected signed integral value\n", line_number));
@@ -153,7 +222,7 @@ public:
 	}
 
 	inline unsigned long get_unsigned_long() {
-		char *token = get_token();
+		Token token = get_token();
 
 		if(!token) {
 			throw runtime_error(format("Error in line {}: expected unsigned integral value\n", line_number));
@@ -163,7 +232,7 @@ public:
 	}
 
 	inline Number get_number() {
-		char *token = get_token();
+		Token token = get_token();
 
 		if(!token) {
 			throw runtime_error(format("Error in line {}: expected numeric value\n", line_number));
@@ -173,7 +242,7 @@ public:
 	}
 
 	inline Number get_number_or_infinity() {
-		char *token = get_token();
+		Token token = get_token();
 
 		if(!token) {
 			throw runtime_error(format("Error in line {}: expected numeric value\n", line_number));
@@ -186,8 +255,48 @@ public:
 	// Tokenization functions //
 	///////////////////////////
 
-	inline char *get_line() {
-		line = strsep(&next_line, "\n");
+	// Returns the line starting at position and moves position to the next line
+	// (nullptr if the line runs into the end of the data); nothing is written to the input
+	inline const char *split_line(const char **position) {
+		const char *start = *position;
+
+		if(start == nullptr) {
+			return nullptr;
+		}
+
+		const char *end = find_line_end(start);
+
+		if(end[0] == '\0') {
+			*position = nullptr;
+		}
+		else {
+			*position = end + 1;
+		}
+
+		return start;
+	}
+
+	inline const char *get_mapped_line() {
+		if(next_line == nullptr || next_line >= mapping_end) {
+			line = nullptr;
+
+			return nullptr;
+		}
+
+		// The mapping is padded with zeroes, so the last line always ends
+		line = split_line(&next_line);
+
+		line_number++;
+
+		return line;
+	}
+
+	inline const char *get_line() {
+		if(mapping != nullptr) {
+			return get_mapped_line();
+		}
+
+		line = split_line(&next_line);
 
 		// If we have some leftover bytes
 		while(next_line == nullptr && !eof) {
@@ -199,8 +308,8 @@ public:
 				memmove(&buffer[0], line, leftover);
 			}
 
-			// Adds the space for the new chunk
-			buffer.resize(leftover + BUFFER_SIZE + 1);
+			// Adds the space for the new chunk (plus the padding read by the scanner)
+			buffer.resize(leftover + BUFFER_SIZE + 1 + SCANNER_PADDING);
 
 			// Reads the new chunk into the larger buffer
 			char *chunk = &buffer[leftover];
@@ -208,13 +317,17 @@ public:
 
 			if((bytes_read = read(fd, chunk, BUFFER_SIZE)) <= 0) {
 				eof = true;
+				bytes_read = 0;
+
+				// Compressed inputs: a failed decompression must not pass for a shorter input
+				file_helper.check_input();
 			}
 
 			chunk[bytes_read] = '\0';
 
 			// Try again
 			next_line = &buffer[0];
-			line = strsep(&next_line, "\n");
+			line = split_line(&next_line);
 		}
 
 		// If EOF, considers the leftover bytes as a line of its own
@@ -231,26 +344,39 @@ public:
 		return line;
 	}
 
-	inline char *get_token() {
+	inline Token get_token() {
 		// If there's no line to get token, obtain one
 		if(line == nullptr) {
 			line = get_line();
 
 			// If the end of file is reached, there is no token
 			if(line == nullptr) {
-				return nullptr;
+				return Token{nullptr, 0};
 			}
 		}
 
 		while(true) {
-			token = strsep(&line, " \t\n");
+			// Skips runs of blanks at once instead of splitting empty tokens
+			while(line[0] == ' ' || line[0] == '\t') {
+				line++;
+			}
 
-			while(token[0] != '\0' && isspace(token[0])) {
+			const char *token = line;
+			const char *token_end = find_token_end(line);
+
+			if(is_line_end(token_end[0])) {
+				line = nullptr;
+			}
+			else {
+				line = token_end + 1;
+			}
+
+			while(token < token_end && isspace(token[0])) {
 				token++;
 			}
 
-			if(token[0] != '\0') {
-				break;
+			if(token < token_end) {
+				return Token{token, static_cast<size_t>(token_end - token)};
 			}
 
 			// If there's no line to get token, obtain one
@@ -259,12 +385,86 @@ public:
 
 				// If the end of file is reached, there is no token
 				if(line == nullptr) {
-					return nullptr;
+					return Token{nullptr, 0};
 				}
 			}
 		}
+	}
 
-		return token;
+	// Skips blank lines; returns false if the input has no more tokens
+	inline bool skip_blank_lines() {
+		while(true) {
+			if(line != nullptr) {
+				while(!is_line_end(line[0]) && isspace(line[0])) {
+					line++;
+				}
+
+				if(!is_line_end(line[0])) {
+					return true;
+				}
+			}
+
+			if(get_line() == nullptr) {
+				return false;
+			}
+		}
+	}
+
+	//////////////////////////////////
+	// Mapped input range functions //
+	//////////////////////////////////
+
+	// Returns the first unconsumed byte of a mapped input if it starts a line, nullptr otherwise
+	inline const char *get_position() {
+		if(mapping == nullptr) {
+			return nullptr;
+		}
+
+		if(line != nullptr) {
+			const char *remainder = line;
+
+			while(!is_line_end(remainder[0]) && isspace(remainder[0])) {
+				remainder++;
+			}
+
+			// Tokens are still pending in the current line
+			if(!is_line_end(remainder[0])) {
+				return nullptr;
+			}
+		}
+
+		return (next_line != nullptr ? next_line : mapping_end);
+	}
+
+	// Resumes parsing at the given position, after lines consumed elsewhere
+	inline void skip_to(const char *position, unsigned long skipped_lines) {
+		next_line = position;
+		line = nullptr;
+
+		line_number += skipped_lines;
+	}
+
+	// Returns the start of the first line in [position, end of input) whose first token is keyword
+	inline const char *find_line_starting_with(const char *position, const char *keyword) {
+		size_t keyword_length = strlen(keyword);
+
+		while(position != nullptr && position < mapping_end) {
+			if(strncmp(position, keyword, keyword_length) == 0 && isspace(position[keyword_length])) {
+				return position;
+			}
+
+			position = static_cast<const char *>(memchr(position, '\n', mapping_end - position));
+
+			if(position != nullptr) {
+				position++;
+			}
+		}
+
+		return nullptr;
+	}
+
+	inline const char *get_mapping_end() {
+		return mapping_end;
 	}
 
 	/////////////////////////////
@@ -274,6 +474,10 @@ public:
 	inline unsigned long get_line_number() {
 		return line_number;
 	}
+
+	inline bool is_memory_mapped() {
+		return (mapping != nullptr);
+	}
 };
 
 #endif /* PARSER_H */
\ No newline at end of file
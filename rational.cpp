@@ -0,0 +1,911 @@
+#include "rational.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <stdexcept>
+#include <format>
+
+using std::runtime_error;
+using std::format;
+
+// Largest power of ten in a limb, and its number of digits
+constexpr uint64_t DECIMAL_CHUNK = 10000000000000000000ULL;
+constexpr size_t DECIMAL_CHUNK_DIGITS = 19;
+
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+
+//////////////////////
+// Helper functions //
+//////////////////////
+
+static inline void trim(vector<uint64_t> &magnitude) {
+	while(!magnitude.empty() && magnitude.back() == 0) {
+		magnitude.pop_back();
+	}
+}
+
+// magnitude = magnitude * factor + addend
+static inline void multiply_add_small(vector<uint64_t> &magnitude, uint64_t factor, uint64_t addend) {
+	uint64_t carry = addend;
+
+	for(auto &limb: magnitude) {
+		uint128_t product = static_cast<uint128_t>(limb) * factor + carry;
+
+		limb = static_cast<uint64_t>(product);
+		carry = static_cast<uint64_t>(product >> 64);
+	}
+
+	if(carry != 0) {
+		magnitude.push_back(carry);
+	}
+}
+
+// magnitude = magnitude / divisor, returning the remainder
+static inline uint64_t divide_small(vector<uint64_t> &magnitude, uint64_t divisor) {
+	uint128_t remainder = 0;
+
+	for(size_t i = magnitude.size(); i-- > 0;) {
+		uint128_t current = (remainder << 64) | magnitude[i];
+
+		magnitude[i] = static_cast<uint64_t>(current / divisor);
+		remainder = current % divisor;
+	}
+
+	trim(magnitude);
+
+	return static_cast<uint64_t>(remainder);
+}
+
+// Adds b, shifted by offset limbs, into a (which is large enough)
+static inline void add_shifted(vector<uint64_t> &a, const vector<uint64_t> &b, size_t offset) {
+	uint64_t carry = 0;
+	size_t i = 0;
+
+	for(; i < b.size(); i++) {
+		uint128_t sum = static_cast<uint128_t>(a[offset + i]) + b[i] + carry;
+
+		a[offset + i] = static_cast<uint64_t>(sum);
+		carry = static_cast<uint64_t>(sum >> 64);
+	}
+
+	for(; carry != 0; i++) {
+		uint128_t sum = static_cast<uint128_t>(a[offset + i]) + carry;
+
+		a[offset + i] = static_cast<uint64_t>(sum);
+		carry = static_cast<uint64_t>(sum >> 64);
+	}
+}
+
+//////////////////////////
+// Integer construction //
+//////////////////////////
+
+Integer::Integer(bool negative, vector<uint64_t> magnitude): small{0}, negative{false} {
+	trim(magnitude);
+
+	if(magnitude.empty()) {
+		return;
+	}
+
+	// Canonical form: anything that fits in an int64_t is stored inline
+	if(magnitude.size() == 1) {
+		if(!negative && magnitude[0] <= static_cast<uint64_t>(INT64_MAX)) {
+			small = static_cast<int64_t>(magnitude[0]);
+
+			return;
+		}
+
+		if(negative && magnitude[0] <= static_cast<uint64_t>(INT64_MAX) + 1) {
+			small = static_cast<int64_t>(0 - magnitude[0]);
+
+			return;
+		}
+	}
+
+	this->negative = negative;
+	limbs = std::move(magnitude);
+}
+
+Integer Integer::from_int128(int128_t value) {
+	if(value >= INT64_MIN && value <= INT64_MAX) {
+		return Integer(static_cast<int64_t>(value));
+	}
+
+	uint128_t magnitude = (value < 0 ? 0 - static_cast<uint128_t>(value) : static_cast<uint128_t>(value));
+
+	return Integer(value < 0, vector<uint64_t>{static_cast<uint64_t>(magnitude), static_cast<uint64_t>(magnitude >> 64)});
+}
+
+/**
+	Parses a decimal integer. Numbers with up to 18 digits are converted directly; longer ones
+	are accumulated in chunks of 19 digits (one limb multiply-add per chunk).
+
+	@param text Optional '-' followed by decimal digits
+	@param length Length of the text
+	@return Parsed integer
+*/
+Integer Integer::parse(const char *text, size_t length) {
+	bool negative = (length > 0 && text[0] == '-');
+
+	const char *digits = text + (negative ? 1 : 0);
+	size_t number_digits = length - (negative ? 1 : 0);
+
+	if(number_digits == 0) {
+		throw runtime_error(format("Error: expected digits in integer ({})\n", string(text, length)));
+	}
+
+	for(size_t i = 0; i < number_digits; i++) {
+		if(digits[i] < '0' || digits[i] > '9') {
+			throw runtime_error(format("Error: invalid digit in integer ({})\n", string(text, length)));
+		}
+	}
+
+	if(number_digits < DECIMAL_CHUNK_DIGITS) {
+		int64_t value = 0;
+
+		for(size_t i = 0; i < number_digits; i++) {
+			value = value * 10 + (digits[i] - '0');
+		}
+
+		return Integer(negative ? -value : value);
+	}
+
+	vector<uint64_t> magnitude;
+	magnitude.reserve(number_digits / DECIMAL_CHUNK_DIGITS + 1);
+
+	// The first chunk takes the leftover digits, so that all the others have exactly 19
+	size_t chunk_length = number_digits % DECIMAL_CHUNK_DIGITS;
+
+	if(chunk_length == 0) {
+		chunk_length = DECIMAL_CHUNK_DIGITS;
+	}
+
+	for(size_t position = 0; position < number_digits; position += chunk_length, chunk_length = DECIMAL_CHUNK_DIGITS) {
+		uint64_t chunk = 0;
+
+		for(size_t i = 0; i < chunk_length; i++) {
+			chunk = chunk * 10 + (digits[position + i] - '0');
+		}
+
+		uint64_t factor = 1;
+
+		for(size_t i = 0; i < chunk_length; i++) {
+			factor *= 10;
+		}
+
+		multiply_add_small(magnitude, factor, chunk);
+	}
+
+	return Integer(negative, std::move(magnitude));
+}
+
+Integer Integer::parse(const char *text) {
+	return parse(text, strlen(text));
+}
+
+string Integer::to_string() const {
+	if(is_small()) {
+		return std::to_string(small);
+	}
+
+	vector<uint64_t> magnitude = limbs;
+	vector<uint64_t> chunks;
+
+	while(!magnitude.empty()) {
+		chunks.push_back(divide_small(magnitude, DECIMAL_CHUNK));
+	}
+
+	string result = (negative ? "-" : "");
+
+	result += std::to_string(chunks.back());
+
+	for(size_t i = chunks.size() - 1; i-- > 0;) {
+		string chunk = std::to_string(chunks[i]);
+
+		result.append(DECIMAL_CHUNK_DIGITS - chunk.size(), '0');
+		result += chunk;
+	}
+
+	return result;
+}
+
+vector<uint64_t> Integer::get_magnitude() const {
+	if(!is_small()) {
+		return limbs;
+	}
+
+	if(small == 0) {
+		return {};
+	}
+
+	// Also correct for INT64_MIN
+	return { (small < 0 ? 0 - static_cast<uint64_t>(small) : static_cast<uint64_t>(small)) };
+}
+
+Integer Integer::abs() const {
+	return (sign() < 0 ? -(*this) : *this);
+}
+
+////////////////////////
+// Integer arithmetic //
+////////////////////////
+
+Integer Integer::operator-() const {
+	if(is_small() && small != INT64_MIN) {
+		return Integer(-small);
+	}
+
+	return Integer(sign() > 0, get_magnitude());
+}
+
+// Sum of two sign-magnitude values
+static Integer add_signed(bool a_negative, const vector<uint64_t> &a, bool b_negative, const vector<uint64_t> &b) {
+	if(a_negative == b_negative) {
+		return Integer(a_negative, Integer::add_magnitudes(a, b));
+	}
+
+	int comparison = Integer::compare_magnitudes(a, b);
+
+	if(comparison == 0) {
+		return Integer(0);
+	}
+
+	if(comparison > 0) {
+		return Integer(a_negative, Integer::subtract_magnitudes(a, b));
+	}
+
+	return Integer(b_negative, Integer::subtract_magnitudes(b, a));
+}
+
+Integer operator+(const Integer &a, const Integer &b) {
+	int64_t result;
+
+	if(a.is_small() && b.is_small() && !__builtin_add_overflow(a.small, b.small, &result)) {
+		return Integer(result);
+	}
+
+	return add_signed(a.sign() < 0, a.get_magnitude(), b.sign() < 0, b.get_magnitude());
+}
+
+Integer operator-(const Integer &a, const Integer &b) {
+	int64_t result;
+
+	if(a.is_small() && b.is_small() && !__builtin_sub_overflow(a.small, b.small, &result)) {
+		return Integer(result);
+	}
+
+	return add_signed(a.sign() < 0, a.get_magnitude(), b.sign() > 0, b.get_magnitude());
+}
+
+Integer operator*(const Integer &a, const Integer &b) {
+	int64_t result;
+
+	if(a.is_small() && b.is_small() && !__builtin_mul_overflow(a.small, b.small, &result)) {
+		return Integer(result);
+	}
+
+	if(a.is_zero() || b.is_zero()) {
+		return Integer(0);
+	}
+
+	return Integer((a.sign() < 0) != (b.sign() < 0), Integer::multiply_magnitudes(a.get_magnitude(), b.get_magnitude()));
+}
+
+void Integer::divide(const Integer &a, const Integer &b, Integer &quotient, Integer &remainder) {
+	if(b.is_zero()) {
+		throw runtime_error("Error: division by zero\n");
+	}
+
+	if(a.is_small() && b.is_small() && !(a.small == INT64_MIN && b.small == -1)) {
+		quotient = Integer(a.small / b.small);
+		remainder = Integer(a.small % b.small);
+
+		return;
+	}
+
+	vector<uint64_t> quotient_magnitude;
+	vector<uint64_t> remainder_magnitude;
+
+	divide_magnitudes(a.get_magnitude(), b.get_magnitude(), quotient_magnitude, remainder_magnitude);
+
+	quotient = Integer((a.sign() < 0) != (b.sign() < 0), std::move(quotient_magnitude));
+	remainder = Integer(a.sign() < 0, std::move(remainder_magnitude));
+}
+
+Integer Integer::floor_divide(const Integer &a, const Integer &b) {
+	Integer quotient;
+	Integer remainder;
+
+	divide(a, b, quotient, remainder);
+
+	// Truncation rounded up a negative quotient
+	if(!remainder.is_zero() && (remainder.sign() != b.sign())) {
+		quotient -= 1;
+	}
+
+	return quotient;
+}
+
+Integer Integer::ceil_divide(const Integer &a, const Integer &b) {
+	Integer quotient;
+	Integer remainder;
+
+	divide(a, b, quotient, remainder);
+
+	// Truncation rounded down a positive quotient
+	if(!remainder.is_zero() && (remainder.sign() == b.sign())) {
+		quotient += 1;
+	}
+
+	return quotient;
+}
+
+// Top 62 bits of a magnitude shifted right by shift bits
+static inline int64_t get_leading_bits(const vector<uint64_t> &magnitude, size_t shift) {
+	size_t limb = shift / 64;
+	size_t bit = shift % 64;
+
+	uint64_t result = (limb < magnitude.size() ? magnitude[limb] >> bit : 0);
+
+	if(bit != 0 && limb + 1 < magnitude.size()) {
+		result |= magnitude[limb + 1] << (64 - bit);
+	}
+
+	return static_cast<int64_t>(result & ((1ULL << 62) - 1));
+}
+
+// a * x + b * y for cofactors below 2^62 (the result must be non-negative)
+static vector<uint64_t> combine_magnitudes(int64_t a, const vector<uint64_t> &x, int64_t b, const vector<uint64_t> &y) {
+	vector<uint64_t> result(x.size());
+
+	int128_t carry = 0;
+
+	for(size_t i = 0; i < x.size(); i++) {
+		int128_t term = carry + static_cast<int128_t>(a) * x[i] + static_cast<int128_t>(b) * (i < y.size() ? y[i] : 0);
+
+		result[i] = static_cast<uint64_t>(term);
+		carry = (term >> 64);
+	}
+
+	trim(result);
+
+	return result;
+}
+
+/**
+	Lehmer's gcd (Knuth, TAOCP vol. 2, algorithm 4.5.2 L): runs Euclid on the leading 62 bits
+	with machine words, and applies the accumulated cofactors to the full numbers at once,
+	replacing up to ~30 multi-precision divisions by one linear combination.
+*/
+Integer Integer::gcd(const Integer &a, const Integer &b) {
+	if(a.is_small() && b.is_small() && a.small != INT64_MIN && b.small != INT64_MIN) {
+		return Integer(std::gcd(a.small, b.small));
+	}
+
+	vector<uint64_t> x = a.get_magnitude();
+	vector<uint64_t> y = b.get_magnitude();
+
+	if(compare_magnitudes(x, y) < 0) {
+		x.swap(y);
+	}
+
+	vector<uint64_t> quotient;
+	vector<uint64_t> remainder;
+
+	while(!y.empty()) {
+		if(x.size() == 1) {
+			return Integer(false, { std::gcd(x[0], y[0]) });
+		}
+
+		size_t bits = 64 * x.size() - __builtin_clzll(x.back());
+		size_t shift = bits - 62;
+
+		int64_t x_leading = get_leading_bits(x, shift);
+		int64_t y_leading = get_leading_bits(y, shift);
+
+		int128_t cofactor_a = 1, cofactor_b = 0, cofactor_c = 0, cofactor_d = 1;
+
+		// Single-precision steps, while both bounds of the quotient agree
+		while(y_leading + cofactor_c != 0 && y_leading + cofactor_d != 0) {
+			int128_t estimate = (x_leading + cofactor_a) / (y_leading + cofactor_c);
+
+			if(estimate != (x_leading + cofactor_b) / (y_leading + cofactor_d)) {
+				break;
+			}
+
+			int128_t next;
+
+			next = cofactor_a - estimate * cofactor_c; cofactor_a = cofactor_c; cofactor_c = next;
+			next = cofactor_b - estimate * cofactor_d; cofactor_b = cofactor_d; cofactor_d = next;
+
+			next = x_leading - estimate * y_leading;
+			x_leading = y_leading;
+			y_leading = static_cast<int64_t>(next);
+		}
+
+		if(cofactor_b == 0) {
+			// No progress on the leading bits (very different sizes): one full division step
+			divide_magnitudes(x, y, quotient, remainder);
+
+			x.swap(y);
+			y.swap(remainder);
+		}
+		else {
+			vector<uint64_t> next_x = combine_magnitudes(static_cast<int64_t>(cofactor_a), x, static_cast<int64_t>(cofactor_b), y);
+			vector<uint64_t> next_y = combine_magnitudes(static_cast<int64_t>(cofactor_c), x, static_cast<int64_t>(cofactor_d), y);
+
+			x.swap(next_x);
+			y.swap(next_y);
+		}
+	}
+
+	return Integer(false, std::move(x));
+}
+
+int Integer::compare(const Integer &a, const Integer &b) {
+	if(a.is_small() && b.is_small()) {
+		return (a.small > b.small) - (a.small < b.small);
+	}
+
+	int a_sign = a.sign();
+	int b_sign = b.sign();
+
+	if(a_sign != b_sign) {
+		return (a_sign > b_sign ? 1 : -1);
+	}
+
+	int comparison = compare_magnitudes(a.get_magnitude(), b.get_magnitude());
+
+	return (a_sign < 0 ? -comparison : comparison);
+}
+
+////////////////////////////////
+// Magnitude (limb) functions //
+////////////////////////////////
+
+int Integer::compare_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b) {
+	if(a.size() != b.size()) {
+		return (a.size() > b.size() ? 1 : -1);
+	}
+
+	for(size_t i = a.size(); i-- > 0;) {
+		if(a[i] != b[i]) {
+			return (a[i] > b[i] ? 1 : -1);
+		}
+	}
+
+	return 0;
+}
+
+vector<uint64_t> Integer::add_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b) {
+	const vector<uint64_t> &longer = (a.size() >= b.size() ? a : b);
+	const vector<uint64_t> &shorter = (a.size() >= b.size() ? b : a);
+
+	vector<uint64_t> result(longer.size() + 1, 0);
+
+	std::copy(longer.begin(), longer.end(), result.begin());
+	add_shifted(result, shorter, 0);
+
+	trim(result);
+
+	return result;
+}
+
+// Requires a >= b
+vector<uint64_t> Integer::subtract_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b) {
+	vector<uint64_t> result(a.size());
+
+	uint64_t borrow = 0;
+
+	for(size_t i = 0; i < a.size(); i++) {
+		uint64_t subtrahend = (i < b.size() ? b[i] : 0);
+
+		uint128_t difference = static_cast<uint128_t>(a[i]) - subtrahend - borrow;
+
+		result[i] = static_cast<uint64_t>(difference);
+		borrow = static_cast<uint64_t>(difference >> 64) & 1;
+	}
+
+	trim(result);
+
+	return result;
+}
+
+vector<uint64_t> Integer::multiply_schoolbook(const vector<uint64_t> &a, const vector<uint64_t> &b) {
+	if(a.empty() || b.empty()) {
+		return {};
+	}
+
+	vector<uint64_t> result(a.size() + b.size(), 0);
+
+	for(size_t i = 0; i < a.size(); i++) {
+		uint64_t carry = 0;
+
+		for(size_t j = 0; j < b.size(); j++) {
+			uint128_t product = static_cast<uint128_t>(a[i]) * b[j] + result[i + j] + carry;
+
+			result[i + j] = static_cast<uint64_t>(product);
+			carry = static_cast<uint64_t>(product >> 64);
+		}
+
+		result[i + b.size()] = carry;
+	}
+
+	trim(result);
+
+	return result;
+}
+
+/**
+	Karatsuba multiplication: three half-size products instead of four. Operands of very
+	different sizes are split along the longer one, which reduces to balanced products.
+*/
+vector<uint64_t> Integer::multiply_karatsuba(const vector<uint64_t> &a, const vector<uint64_t> &b) {
+	if(std::min(a.size(), b.size()) < KARATSUBA_THRESHOLD) {
+		return multiply_schoolbook(a, b);
+	}
+
+	size_t half = std::max(a.size(), b.size()) / 2;
+
+	auto low = [half] (const vector<uint64_t> &x) {
+		vector<uint64_t> result(x.begin(), x.begin() + std::min(half, x.size()));
+		trim(result);
+		return result;
+	};
+
+	auto high = [half] (const vector<uint64_t> &x) {
+		return (x.size() > half ? vector<uint64_t>(x.begin() + half, x.end()) : vector<uint64_t>());
+	};
+
+	vector<uint64_t> a0 = low(a), a1 = high(a);
+	vector<uint64_t> b0 = low(b), b1 = high(b);
+
+	vector<uint64_t> result(a.size() + b.size() + 1, 0);
+
+	// Unbalanced operands: b = b0, so a * b = a0 * b + (a1 * b) << half
+	if(b1.empty() || a1.empty()) {
+		const vector<uint64_t> &whole = (b1.empty() ? b : a);
+
+		add_shifted(result, multiply_karatsuba(b1.empty() ? a0 : b0, whole), 0);
+		add_shifted(result, multiply_karatsuba(b1.empty() ? a1 : b1, whole), half);
+
+		trim(result);
+
+		return result;
+	}
+
+	vector<uint64_t> z0 = multiply_karatsuba(a0, b0);
+	vector<uint64_t> z2 = multiply_karatsuba(a1, b1);
+
+	// z1 = (a0 + a1) * (b0 + b1) - z0 - z2 (never negative)
+	vector<uint64_t> z1 = multiply_karatsuba(add_magnitudes(a0, a1), add_magnitudes(b0, b1));
+
+	z1 = subtract_magnitudes(subtract_magnitudes(z1, z0), z2);
+
+	add_shifted(result, z0, 0);
+	add_shifted(result, z1, half);
+	add_shifted(result, z2, 2 * half);
+
+	trim(result);
+
+	return result;
+}
+
+vector<uint64_t> Integer::multiply_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b) {
+	if(std::min(a.size(), b.size()) < KARATSUBA_THRESHOLD) {
+		return multiply_schoolbook(a, b);
+	}
+
+	return multiply_karatsuba(a, b);
+}
+
+/**
+	Long division of magnitudes (Knuth, TAOCP vol. 2, algorithm 4.3.1 D).
+
+	@param a Dividend
+	@param b Divisor (non-zero)
+	@param quotient Receives a / b
+	@param remainder Receives a % b
+*/
+void Integer::divide_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b, vector<uint64_t> &quotient, vector<uint64_t> &remainder) {
+	if(compare_magnitudes(a, b) < 0) {
+		quotient.clear();
+		remainder = a;
+
+		return;
+	}
+
+	if(b.size() == 1) {
+		quotient = a;
+
+		uint64_t rest = divide_small(quotient, b[0]);
+
+		remainder.clear();
+
+		if(rest != 0) {
+			remainder.push_back(rest);
+		}
+
+		return;
+	}
+
+	size_t n = b.size();
+	size_t m = a.size() - n;
+
+	// Normalization: the top bit of the divisor must be set for the quotient estimates
+	int shift = __builtin_clzll(b.back());
+
+	vector<uint64_t> vn(n);
+	vector<uint64_t> un(a.size() + 1);
+
+	for(size_t i = n - 1; i > 0; i--) {
+		vn[i] = (b[i] << shift) | (shift != 0 ? b[i - 1] >> (64 - shift) : 0);
+	}
+
+	vn[0] = b[0] << shift;
+
+	un[a.size()] = (shift != 0 ? a.back() >> (64 - shift) : 0);
+
+	for(size_t i = a.size() - 1; i > 0; i--) {
+		un[i] = (a[i] << shift) | (shift != 0 ? a[i - 1] >> (64 - shift) : 0);
+	}
+
+	un[0] = a[0] << shift;
+
+	quotient.assign(m + 1, 0);
+
+	for(size_t j = m + 1; j-- > 0;) {
+		// Estimates the quotient digit from the top two limbs, then corrects it (at most twice)
+		uint128_t numerator = (static_cast<uint128_t>(un[j + n]) << 64) | un[j + n - 1];
+
+		uint128_t estimate = numerator / vn[n - 1];
+		uint128_t rest = numerator % vn[n - 1];
+
+		while(estimate >> 64 != 0 || estimate * vn[n - 2] > ((rest << 64) | un[j + n - 2])) {
+			estimate--;
+			rest += vn[n - 1];
+
+			if(rest >> 64 != 0) {
+				break;
+			}
+		}
+
+		// Multiplies and subtracts
+		int128_t borrow = 0;
+		int128_t difference;
+
+		for(size_t i = 0; i < n; i++) {
+			uint128_t product = estimate * vn[i];
+
+			difference = static_cast<int128_t>(un[i + j]) - borrow - static_cast<int128_t>(static_cast<uint64_t>(product));
+			un[i + j] = static_cast<uint64_t>(difference);
+			borrow = static_cast<int128_t>(product >> 64) - (difference >> 64);
+		}
+
+		difference = static_cast<int128_t>(un[j + n]) - borrow;
+		un[j + n] = static_cast<uint64_t>(difference);
+
+		quotient[j] = static_cast<uint64_t>(estimate);
+
+		// Estimate one too large: adds the divisor back
+		if(difference < 0) {
+			quotient[j]--;
+
+			uint64_t carry = 0;
+
+			for(size_t i = 0; i < n; i++) {
+				uint128_t sum = static_cast<uint128_t>(un[i + j]) + vn[i] + carry;
+
+				un[i + j] = static_cast<uint64_t>(sum);
+				carry = static_cast<uint64_t>(sum >> 64);
+			}
+
+			un[j + n] += carry;
+		}
+	}
+
+	trim(quotient);
+
+	// Denormalizes the remainder
+	remainder.assign(n, 0);
+
+	for(size_t i = 0; i < n; i++) {
+		remainder[i] = (un[i] >> shift) | (shift != 0 ? un[i + 1] << (64 - shift) : 0);
+	}
+
+	trim(remainder);
+}
+
+///////////////////////////
+// Rational construction //
+///////////////////////////
+
+Rational::Rational(Integer numerator, Integer denominator): numerator{std::move(numerator)}, denominator{std::move(denominator)} {
+	normalize();
+}
+
+Rational::Rational(Number number) {
+	if(number.is_inline()) {
+		*this = Rational(number.get_inline_value());
+		return;
+	}
+
+	NumberEntry &entry = number.get_entry();
+
+	if((entry.flags & (NumberPositiveInfinity | NumberNegativeInfinity)) != 0) {
+		throw runtime_error(format("Error: infinite value ({}) used as a rational\n", entry.text));
+	}
+
+	*this = parse(entry.text, entry.text_length);
+}
+
+void Rational::normalize() {
+	if(denominator.is_zero()) {
+		throw runtime_error("Error: rational with zero denominator\n");
+	}
+
+	if(denominator.sign() < 0) {
+		numerator = -numerator;
+		denominator = -denominator;
+	}
+
+	if(is_integral()) {
+		return;
+	}
+
+	Integer divisor = Integer::gcd(numerator, denominator);
+
+	if(divisor.is_small() && divisor.get_small() == 1) {
+		return;
+	}
+
+	Integer reduced_numerator;
+	Integer reduced_denominator;
+	Integer remainder;
+
+	Integer::divide(numerator, divisor, reduced_numerator, remainder);
+	Integer::divide(denominator, divisor, reduced_denominator, remainder);
+
+	numerator = std::move(reduced_numerator);
+	denominator = std::move(reduced_denominator);
+}
+
+Rational Rational::parse(const char *text, size_t length) {
+	const char *slash = static_cast<const char *>(memchr(text, '/', length));
+
+	if(slash == nullptr) {
+		return Rational(Integer::parse(text, length));
+	}
+
+	return Rational(Integer::parse(text, slash - text), Integer::parse(slash + 1, length - (slash + 1 - text)));
+}
+
+string Rational::to_string() const {
+	if(is_integral()) {
+		return numerator.to_string();
+	}
+
+	return numerator.to_string() + "/" + denominator.to_string();
+}
+
+/////////////////////////
+// Rational arithmetic //
+/////////////////////////
+
+Integer Rational::floor() const {
+	if(is_integral()) {
+		return numerator;
+	}
+
+	return Integer::floor_divide(numerator, denominator);
+}
+
+Integer Rational::ceil() const {
+	if(is_integral()) {
+		return numerator;
+	}
+
+	return Integer::ceil_divide(numerator, denominator);
+}
+
+Rational Rational::operator-() const {
+	Rational result;
+
+	result.numerator = -numerator;
+	result.denominator = denominator;
+
+	return result;
+}
+
+Rational Rational::get_reduced(Integer numerator, Integer denominator) {
+	Rational result;
+
+	result.numerator = std::move(numerator);
+	result.denominator = std::move(denominator);
+
+	return result;
+}
+
+static inline Integer divide_exact(const Integer &a, const Integer &b) {
+	Integer quotient;
+	Integer remainder;
+
+	Integer::divide(a, b, quotient, remainder);
+
+	return quotient;
+}
+
+static inline bool is_one(const Integer &value) {
+	return (value.is_small() && value.get_small() == 1);
+}
+
+/**
+	Sum in lowest terms without a gcd of the (large) result (Knuth, TAOCP vol. 2, 4.5.1):
+	only the denominators, and then a factor of their gcd, are reduced.
+*/
+Rational Rational::add(const Rational &a, const Integer &b_numerator, const Integer &b_denominator) {
+	if(a.is_integral() && is_one(b_denominator)) {
+		return Rational(a.numerator + b_numerator);
+	}
+
+	Integer divisor = Integer::gcd(a.denominator, b_denominator);
+
+	if(is_one(divisor)) {
+		return get_reduced(a.numerator * b_denominator + b_numerator * a.denominator, a.denominator * b_denominator);
+	}
+
+	Integer a_denominator_reduced = divide_exact(a.denominator, divisor);
+
+	Integer sum = a.numerator * divide_exact(b_denominator, divisor) + b_numerator * a_denominator_reduced;
+
+	if(sum.is_zero()) {
+		return Rational();
+	}
+
+	Integer sum_divisor = Integer::gcd(sum, divisor);
+
+	return get_reduced(divide_exact(sum, sum_divisor), a_denominator_reduced * divide_exact(b_denominator, sum_divisor));
+}
+
+Rational operator+(const Rational &a, const Rational &b) {
+	return Rational::add(a, b.numerator, b.denominator);
+}
+
+Rational operator-(const Rational &a, const Rational &b) {
+	return Rational::add(a, -b.numerator, b.denominator);
+}
+
+// Product in lowest terms: cross-reduces before multiplying
+Rational operator*(const Rational &a, const Rational &b) {
+	if(a.is_integral() && b.is_integral()) {
+		return Rational(a.numerator * b.numerator);
+	}
+
+	if(a.is_zero() || b.is_zero()) {
+		return Rational();
+	}
+
+	Integer divisor1 = Integer::gcd(a.numerator, b.denominator);
+	Integer divisor2 = Integer::gcd(b.numerator, a.denominator);
+
+	return Rational::get_reduced(divide_exact(a.numerator, divisor1) * divide_exact(b.numerator, divisor2), divide_exact(a.denominator, divisor2) * divide_exact(b.denominator, divisor1));
+}
+
+Rational operator/(const Rational &a, const Rational &b) {
+	if(b.is_zero()) {
+		throw runtime_error("Error: division by zero\n");
+	}
+
+	return Rational(a.numerator * b.denominator, a.denominator * b.numerator);
+}
+
+int Rational::compare(const Rational &a, const Rational &b) {
+	if(a.is_integral() && b.is_integral()) {
+		return Integer::compare(a.numerator, b.numerator);
+	}
+
+	// Denominators are positive: cross-multiplication keeps the order
+	return Integer::compare(a.numerator * b.denominator, b.numerator * a.denominator);
+}
@@ -0,0 +1,242 @@
+#ifndef RATIONAL_H
+#define RATIONAL_H
+
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include "basic_types.h"
+
+using std::string;
+using std::vector;
+
+/**
+	Exact arbitrary-precision integer.
+
+	Values that fit in an int64_t are kept inline and handled with overflow-checked machine
+	arithmetic; only results that overflow are moved to a sign-magnitude representation with
+	64-bit limbs (least significant first). Every operation returns a canonical value: an
+	Integer that fits in 64 bits is always stored inline.
+*/
+class Integer {
+	// Inline value (when limbs is empty)
+	int64_t small;
+
+	// Large values: sign and magnitude
+	bool negative;
+	vector<uint64_t> limbs;
+
+public:
+	// Limbs from which multiplications switch from schoolbook to Karatsuba
+	constexpr static size_t KARATSUBA_THRESHOLD = 48;
+
+	Integer(): small{0}, negative{false} {}
+	Integer(int64_t value): small{value}, negative{false} {}
+
+	Integer(bool negative, vector<uint64_t> magnitude);
+
+	// Canonical Integer of a 128-bit machine value
+	static Integer from_int128(__int128 value);
+
+	// Parses an optional '-' followed by decimal digits (throws runtime_error otherwise)
+	static Integer parse(const char *text, size_t length);
+	static Integer parse(const char *text);
+
+	string to_string() const;
+
+	inline bool is_small() const {
+		return limbs.empty();
+	}
+
+	inline int64_t get_small() const {
+		return small;
+	}
+
+	inline int sign() const {
+		if(is_small()) {
+			return (small > 0) - (small < 0);
+		}
+
+		return (negative ? -1 : 1);
+	}
+
+	inline bool is_zero() const {
+		return (is_small() && small == 0);
+	}
+
+	// Magnitude as limbs (also for inline values)
+	vector<uint64_t> get_magnitude() const;
+
+	Integer operator-() const;
+
+	friend Integer operator+(const Integer &a, const Integer &b);
+	friend Integer operator-(const Integer &a, const Integer &b);
+	friend Integer operator*(const Integer &a, const Integer &b);
+
+	// Truncated division (quotient rounded towards zero, remainder with the sign of a)
+	static void divide(const Integer &a, const Integer &b, Integer &quotient, Integer &remainder);
+
+	// Floor and ceiling of a / b
+	static Integer floor_divide(const Integer &a, const Integer &b);
+	static Integer ceil_divide(const Integer &a, const Integer &b);
+
+	// Non-negative greatest common divisor (gcd(0, 0) = 0)
+	static Integer gcd(const Integer &a, const Integer &b);
+
+	static int compare(const Integer &a, const Integer &b);
+
+	Integer abs() const;
+
+	friend inline bool operator==(const Integer &a, const Integer &b) {
+		return compare(a, b) == 0;
+	}
+
+	friend inline bool operator!=(const Integer &a, const Integer &b) {
+		return compare(a, b) != 0;
+	}
+
+	friend inline bool operator<(const Integer &a, const Integer &b) {
+		return compare(a, b) < 0;
+	}
+
+	friend inline bool operator<=(const Integer &a, const Integer &b) {
+		return compare(a, b) <= 0;
+	}
+
+	friend inline bool operator>(const Integer &a, const Integer &b) {
+		return compare(a, b) > 0;
+	}
+
+	friend inline bool operator>=(const Integer &a, const Integer &b) {
+		return compare(a, b) >= 0;
+	}
+
+	inline Integer &operator+=(const Integer &other) {
+		return (*this = *this + other);
+	}
+
+	inline Integer &operator-=(const Integer &other) {
+		return (*this = *this - other);
+	}
+
+	inline Integer &operator*=(const Integer &other) {
+		return (*this = *this * other);
+	}
+
+	////////////////////////////////
+	// Magnitude (limb) functions //
+	////////////////////////////////
+
+	static int compare_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b);
+
+	static vector<uint64_t> add_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b);
+	static vector<uint64_t> subtract_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b);
+
+	static vector<uint64_t> multiply_schoolbook(const vector<uint64_t> &a, const vector<uint64_t> &b);
+	static vector<uint64_t> multiply_karatsuba(const vector<uint64_t> &a, const vector<uint64_t> &b);
+	static vector<uint64_t> multiply_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b);
+
+	static void divide_magnitudes(const vector<uint64_t> &a, const vector<uint64_t> &b, vector<uint64_t> &quotient, vector<uint64_t> &remainder);
+};
+
+/**
+	Exact rational number: numerator and positive denominator, always in lowest terms.
+	Integral values (denominator 1) skip all gcd computations.
+*/
+class Rational {
+	Integer numerator;
+	Integer denominator;
+
+	void normalize();
+
+	// Skips normalization (the caller guarantees lowest terms and a positive denominator)
+	static Rational get_reduced(Integer numerator, Integer denominator);
+
+	static Rational add(const Rational &a, const Integer &b_numerator, const Integer &b_denominator);
+
+public:
+	Rational(): numerator{0}, denominator{1} {}
+	Rational(int64_t value): numerator{value}, denominator{1} {}
+	Rational(Integer value): numerator{std::move(value)}, denominator{1} {}
+	Rational(Integer numerator, Integer denominator);
+
+	// Converts an interned certificate number (infinities are rejected)
+	Rational(Number number);
+
+	// Parses "a" or "a/b" with decimal a and b
+	static Rational parse(const char *text, size_t length);
+
+	string to_string() const;
+
+	inline const Integer &get_numerator() const {
+		return numerator;
+	}
+
+	inline const Integer &get_denominator() const {
+		return denominator;
+	}
+
+	inline bool is_integral() const {
+		return (denominator.is_small() && denominator.get_small() == 1);
+	}
+
+	inline int sign() const {
+		return numerator.sign();
+	}
+
+	inline bool is_zero() const {
+		return numerator.is_zero();
+	}
+
+	Integer floor() const;
+	Integer ceil() const;
+
+	Rational operator-() const;
+
+	friend Rational operator+(const Rational &a, const Rational &b);
+	friend Rational operator-(const Rational &a, const Rational &b);
+	friend Rational operator*(const Rational &a, const Rational &b);
+	friend Rational operator/(const Rational &a, const Rational &b);
+
+	static int compare(const Rational &a, const Rational &b);
+
+	friend inline bool operator==(const Rational &a, const Rational &b) {
+		// Lowest terms: equal values have equal representations
+		return (a.numerator == b.numerator && a.denominator == b.denominator);
+	}
+
+	friend inline bool operator!=(const Rational &a, const Rational &b) {
+		return !(a == b);
+	}
+
+	friend inline bool operator<(const Rational &a, const Rational &b) {
+		return compare(a, b) < 0;
+	}
+
+	friend inline bool operator<=(const Rational &a, const Rational &b) {
+		return compare(a, b) <= 0;
+	}
+
+	friend inline bool operator>(const Rational &a, const Rational &b) {
+		return compare(a, b) > 0;
+	}
+
+	friend inline bool operator>=(const Rational &a, const Rational &b) {
+		return compare(a, b) >= 0;
+	}
+
+	inline Rational &operator+=(const Rational &other) {
+		return (*this = *this + other);
+	}
+
+	inline Rational &operator-=(const Rational &other) {
+		return (*this = *this - other);
+	}
+
+	inline Rational &operator*=(const Rational &other) {
+		return (*this = *this * other);
+	}
+};
+
+#endif /* RATIONAL_H */
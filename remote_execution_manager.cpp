@@ -49,6 +49,10 @@ RemoteExecutionManager::~RemoteExecutionManager() {
 			delete dispatch;
 		}
 	}
+
+	for(auto *dispatch: delayed_dispatches) {
+		delete dispatch;
+	}
 }
 
 /**
@@ -242,7 +246,7 @@ RemoteExecutionManager::ClearingResult RemoteExecutionManager::clear_dispatches(
 }
 
 /**
-	Waits until all previous dispatches were successful.
+	Kills the running dispatches and drops the queued ones.
 */
 void RemoteExecutionManager::kill_dispatches() {
 	// Serialize concurrent calls to this method
@@ -259,4 +263,11 @@ void RemoteExecutionManager::kill_dispatches() {
 
 		run_local(command_line, nullptr, nullptr);
 	}
+
+	// Queued dispatches were never started: they are dropped
+	for(auto *dispatch: delayed_dispatches) {
+		delete dispatch;
+	}
+
+	delayed_dispatches.clear();
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif /* __AVX2__ || __SSE4_2__ */
+
+// Readable bytes required past the end of any scanned data (a '\0'): the vector loads
+// below may read (but never use) up to this many bytes after the end of the data
+constexpr size_t SCANNER_PADDING = 32;
+
+////////////////////////
+// Delimiter scanning //
+////////////////////////
+
+// Returns the first token delimiter (' ', '\t', '\n' or '\0') at or after position
+inline const char *find_token_end(const char *position) {
+#if defined(__AVX2__)
+	const __m256i spaces = _mm256_set1_epi8(' ');
+	const __m256i tabs = _mm256_set1_epi8('\t');
+	const __m256i newlines = _mm256_set1_epi8('\n');
+	const __m256i zeroes = _mm256_setzero_si256();
+
+	while(true) {
+		__m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(position));
+
+		__m256i blanks = _mm256_or_si256(_mm256_cmpeq_epi8(data, spaces), _mm256_cmpeq_epi8(data, tabs));
+		__m256i ends = _mm256_or_si256(_mm256_cmpeq_epi8(data, newlines), _mm256_cmpeq_epi8(data, zeroes));
+
+		uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(blanks, ends));
+
+		if(mask != 0) {
+			return position + __builtin_ctz(mask);
+		}
+
+		position += 32;
+	}
+#elif defined(__SSE4_2__)
+	const __m128i delimiters = _mm_setr_epi8(' ', '\t', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+	while(true) {
+		__m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+
+		// Implicit-length compare: stops at the first '\0' of the data as well
+		int index = _mm_cmpistri(delimiters, data, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+
+		if(index < 16) {
+			return position + index;
+		}
+
+		if(_mm_cmpistrz(delimiters, data, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT)) {
+			return position + strlen(position);
+		}
+
+		position += 16;
+	}
+#else
+	while(*position != ' ' && *position != '\t' && *position != '\n' && *position != '\0') {
+		position++;
+	}
+
+	return position;
+#endif /* __AVX2__ */
+}
+
+// Returns the first '\n' or '\0' at or after position
+inline const char *find_line_end(const char *position) {
+#if defined(__AVX2__)
+	const __m256i newlines = _mm256_set1_epi8('\n');
+	const __m256i zeroes = _mm256_setzero_si256();
+
+	while(true) {
+		__m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(position));
+
+		uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(data, newlines), _mm256_cmpeq_epi8(data, zeroes)));
+
+		if(mask != 0) {
+			return position + __builtin_ctz(mask);
+		}
+
+		position += 32;
+	}
+#else
+	// The C library already vectorizes this search
+	return position + strcspn(position, "\n");
+#endif /* __AVX2__ */
+}
+
+//////////////////////////////////
+// SWAR decimal integer parsing //
+//////////////////////////////////
+
+// Marks (with the high bit) every byte of a little-endian word that is not an ASCII digit;
+// borrows and carries only propagate upwards, so the lowest marked byte is always exact
+inline uint64_t swar_non_digits(uint64_t word) {
+	return ((word - 0x3030303030303030ULL) | (word + 0x4646464646464646ULL)) & 0x8080808080808080ULL;
+}
+
+// Converts the first length (1 to 8) ASCII digits of a little-endian word
+inline uint64_t swar_digits_value(uint64_t word, unsigned int length) {
+	// Keeps only the digits and moves them to the top: the bytes shifted in act as leading zeroes
+	word = (length == 8 ? word : (word & ((1ULL << (8 * length)) - 1))) << (8 * (8 - length));
+
+	word = ((word & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+	word = ((word & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+
+	return ((word & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+}
+
+// Marks the bytes of a little-endian word that lie past its first length (1 to 8) bytes
+inline uint64_t swar_prefix_mask(unsigned int length) {
+	return (length == 8 ? ~0ULL : ((1ULL << (8 * length)) - 1));
+}
+
+/**
+	Parses a token of 1 to 16 decimal digits without branches per digit.
+	Anything else (signs, other bytes, longer numbers) is left to the caller's slow path,
+	which keeps the regular error reporting.
+
+	@param token Token followed by at least 16 readable bytes (see SCANNER_PADDING)
+	@param length Length of the token
+	@param value Receives the converted value
+	@return True if the fast path applied
+*/
+inline bool parse_unsigned_swar(const char *token, size_t length, unsigned long *value) {
+	constexpr uint64_t POWERS_OF_TEN[] = { 1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL };
+
+	if(length == 0 || length > 16) {
+		return false;
+	}
+
+	uint64_t low;
+	memcpy(&low, token, sizeof(uint64_t));
+
+	if(length <= 8) {
+		if((swar_non_digits(low) & swar_prefix_mask(length)) != 0) {
+			return false;
+		}
+
+		*value = swar_digits_value(low, length);
+
+		return true;
+	}
+
+	uint64_t high;
+	memcpy(&high, token + 8, sizeof(uint64_t));
+
+	unsigned int high_length = length - 8;
+
+	if(swar_non_digits(low) != 0 || (swar_non_digits(high) & swar_prefix_mask(high_length)) != 0) {
+		return false;
+	}
+
+	*value = swar_digits_value(low, 8) * POWERS_OF_TEN[high_length] + swar_digits_value(high, high_length);
+
+	return true;
+}
+
+// Signed variant of parse_unsigned_swar: accepts one leading '-'
+inline bool parse_signed_swar(const char *token, size_t length, long *value) {
+	bool negative = (length > 0 && token[0] == '-');
+
+	unsigned long magnitude;
+
+	if(!parse_unsigned_swar(token + (negative ? 1 : 0), length - (negative ? 1 : 0), &magnitude)) {
+		return false;
+	}
+
+	// 16 digits always fit in a long
+	*value = (negative ? -static_cast<long>(magnitude) : static_cast<long>(magnitude));
+
+	return true;
+}
+
+#endif /* SCANNER_H */
@@ -0,0 +1,108 @@
+#ifndef SMT_FORMAT_H
+#define SMT_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+
+/**
+	Formatting primitives of the SMT emission, with every length known without strlen.
+
+	Operator prefixes ("(and ") are built at compile time from the operator names, so that
+	opening an operator is a single write of a known length. Integers are formatted from the
+	last digit backwards, two digits at a time, through a table of the 100 digit pairs.
+*/
+
+// Longest operator prefix: "(" + name + " "
+constexpr size_t MAXIMUM_OPERATOR_PREFIX_LENGTH = 16;
+
+struct OperatorPrefix {
+	char text[MAXIMUM_OPERATOR_PREFIX_LENGTH];
+	size_t length;
+};
+
+// Prefix "(name " of each operator name, at compile time
+template<size_t NUMBER_OPERATORS>
+constexpr std::array<OperatorPrefix, NUMBER_OPERATORS> make_operator_prefixes(const char *const (&names)[NUMBER_OPERATORS]) {
+	std::array<OperatorPrefix, NUMBER_OPERATORS> prefixes{};
+
+	for(size_t op = 0; op < NUMBER_OPERATORS; op++) {
+		OperatorPrefix &prefix = prefixes[op];
+
+		prefix.text[prefix.length++] = '(';
+
+		for(const char *name = names[op]; *name != '\0'; name++) {
+			// Not a constant expression (compilation error) if the prefix does not fit
+			if(prefix.length == MAXIMUM_OPERATOR_PREFIX_LENGTH - 1) {
+				throw "Operator name too long";
+			}
+
+			prefix.text[prefix.length++] = *name;
+		}
+
+		prefix.text[prefix.length++] = ' ';
+	}
+
+	return prefixes;
+}
+
+// Room for 20 digits, or "(- " + 19 digits + ")"
+constexpr size_t MAXIMUM_INTEGER_LENGTH = 24;
+
+constexpr std::array<char, 200> DIGIT_PAIRS = [] {
+	std::array<char, 200> pairs{};
+
+	for(int i = 0; i < 100; i++) {
+		pairs[2 * i] = '0' + i / 10;
+		pairs[2 * i + 1] = '0' + i % 10;
+	}
+
+	return pairs;
+}();
+
+/**
+	Writes the decimal digits of value so that they end right before end.
+
+	@return Where the digits start
+*/
+inline char *format_unsigned(uint64_t value, char *end) {
+	char *output = end;
+
+	while(value >= 100) {
+		output -= 2;
+		memcpy(output, &DIGIT_PAIRS[2 * (value % 100)], 2);
+
+		value /= 100;
+	}
+
+	if(value >= 10) {
+		output -= 2;
+		memcpy(output, &DIGIT_PAIRS[2 * value], 2);
+	}
+	else {
+		*--output = '0' + value;
+	}
+
+	return output;
+}
+
+/**
+	Writes value as an SMT integer ("(- 5)" for -5) so that it ends right before end.
+
+	@return Where the text starts
+*/
+inline char *format_smt_integer(int64_t value, char *end) {
+	if(value >= 0) {
+		return format_unsigned(value, end);
+	}
+
+	*--end = ')';
+
+	char *output = format_unsigned(-static_cast<uint64_t>(value), end) - 3;
+	memcpy(output, "(- ", 3);
+
+	return output;
+}
+
+#endif /* SMT_FORMAT_H */
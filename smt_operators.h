@@ -0,0 +1,55 @@
+#ifndef SMT_OPERATORS_H
+#define SMT_OPERATORS_H
+
+#include "smt_format.h"
+
+// SMT-LIB operators emitted for the certificate, shared by the text emitters and the term DAG
+
+constexpr int OP_ASSERT = 0;
+constexpr int OP_NOT = 1;
+constexpr int OP_AND = 2;
+constexpr int OP_OR = 3;
+constexpr int OP_EQ = 4;
+constexpr int OP_NEQ = 5;
+constexpr int OP_PLUS = 6;
+constexpr int OP_MINUS = 7;
+constexpr int OP_TIMES = 8;
+constexpr int OP_DIVIDE = 9;
+constexpr int OP_LEQ = 10;
+constexpr int OP_GEQ = 11;
+constexpr int OP_L = 12;
+constexpr int OP_G = 13;
+constexpr int OP_INTEGRAL = 14;
+constexpr int OP_RND_DOWN = 15;
+constexpr int OP_ITE = 16;
+constexpr int OP_IMPLICATION = 17;
+constexpr int OP_LET = 18;
+
+constexpr const char *OP_STRINGS[] = {
+	"assert",
+	"not",
+	"and",
+	"or",
+	"=",
+	"distinct",
+	"+",
+	"-",
+	"*",
+	"/",
+	"<=",
+	">=",
+	"<",
+	">",
+	"is_int",
+	"to_int",
+	"ite",
+	"=>",
+	"let"
+};
+
+// "(op " of every operator, with its length
+constexpr auto OP_PREFIXES = make_operator_prefixes(OP_STRINGS);
+
+constexpr int NUMBER_OPERATORS = sizeof(OP_STRINGS) / sizeof(OP_STRINGS[0]);
+
+#endif /* SMT_OPERATORS_H */
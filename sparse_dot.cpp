@@ -0,0 +1,119 @@
+#include "sparse_dot.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif /* __AVX2__ */
+
+typedef __int128 int128_t;
+
+// Adds c * v when both are inline integers
+static inline bool add_integral_term(Number coefficient, Number value, int128_t &sum) {
+	if((coefficient.bits & value.bits & Number::INLINE_TAG) == 0) {
+		return false;
+	}
+
+	sum += static_cast<int128_t>(coefficient.get_inline_value()) * value.get_inline_value();
+
+	return true;
+}
+
+bool sparse_dot_integral(const unsigned long *indexes, const Number *coefficients, unsigned long number_coefficients, const Number *values, int128_t &result) {
+	if(number_coefficients > SPARSE_DOT_MAXIMUM_INTEGRAL_LENGTH) {
+		return false;
+	}
+
+	int128_t sum = 0;
+	unsigned long position = 0;
+
+#ifdef __AVX2__
+	// Blocks of four terms accumulated in the lanes before they are added to sum
+	constexpr unsigned long FLUSH_BLOCKS = 1024;
+
+	const __m256i tag = _mm256_set1_epi64x(Number::INLINE_TAG);
+
+	// Inline values in [-2^26, 2^26) have their bits in [-2^34, 2^34): products stay below 2^52
+	const __m256i lower = _mm256_set1_epi64x(-(1LL << 34) - 1);
+	const __m256i upper = _mm256_set1_epi64x(1LL << 34);
+
+	__m256i lanes = _mm256_setzero_si256();
+	unsigned long pending = 0;
+
+	auto flush = [&] {
+		alignas(32) int64_t partial[4];
+
+		_mm256_store_si256(reinterpret_cast<__m256i *>(partial), lanes);
+
+		sum += static_cast<int128_t>(partial[0]) + partial[1] + partial[2] + partial[3];
+
+		lanes = _mm256_setzero_si256();
+		pending = 0;
+	};
+
+	for(; position + 4 <= number_coefficients; position += 4) {
+		__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(coefficients + position));
+		__m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indexes + position));
+		__m256i v = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(values), i, sizeof(Number));
+
+		// Every coefficient and value is an inline integer
+		if(!_mm256_testc_si256(_mm256_and_si256(_mm256_and_si256(c, v), tag), tag)) {
+			return false;
+		}
+
+		__m256i small_c = _mm256_and_si256(_mm256_cmpgt_epi64(c, lower), _mm256_cmpgt_epi64(upper, c));
+		__m256i small_v = _mm256_and_si256(_mm256_cmpgt_epi64(v, lower), _mm256_cmpgt_epi64(upper, v));
+
+		if(_mm256_movemask_epi8(_mm256_and_si256(small_c, small_v)) == -1) {
+			// The low 32 bits of the logical shift are the (signed) small value
+			lanes = _mm256_add_epi64(lanes, _mm256_mul_epi32(_mm256_srli_epi64(c, Number::PAYLOAD_SHIFT), _mm256_srli_epi64(v, Number::PAYLOAD_SHIFT)));
+
+			if(++pending == FLUSH_BLOCKS) {
+				flush();
+			}
+		}
+		else {
+			for(unsigned long k = position; k < position + 4; k++) {
+				add_integral_term(coefficients[k], values[indexes[k]], sum);
+			}
+		}
+	}
+
+	flush();
+#endif /* __AVX2__ */
+
+	for(; position < number_coefficients; position++) {
+		if(!add_integral_term(coefficients[position], values[indexes[position]], sum)) {
+			return false;
+		}
+	}
+
+	result = sum;
+
+	return true;
+}
+
+Rational sparse_dot_exact(const unsigned long *indexes, const Number *coefficients, unsigned long number_coefficients, const Number *values) {
+	Rational result;
+
+	for(unsigned long position = 0; position < number_coefficients; position++) {
+		const Number &coefficient = coefficients[position];
+		const Number &value = values[indexes[position]];
+
+		if(coefficient.is_zero() || value.is_zero()) {
+			continue;
+		}
+
+		result += Rational(coefficient) * Rational(value);
+	}
+
+	return result;
+}
+
+Rational sparse_dot(const unsigned long *indexes, const Number *coefficients, unsigned long number_coefficients, const Number *values) {
+	int128_t result;
+
+	if(sparse_dot_integral(indexes, coefficients, number_coefficients, values, result)) {
+		return Rational(Integer::from_int128(result));
+	}
+
+	return sparse_dot_exact(indexes, coefficients, number_coefficients, values);
+}
@@ -0,0 +1,39 @@
+#ifndef SPARSE_DOT_H
+#define SPARSE_DOT_H
+
+#include "basic_types.h"
+#include "rational.h"
+
+/**
+	Exact dot products of a sparse row (column indexes and coefficients, as in a Constraint)
+	against a dense vector of certificate numbers.
+
+	Almost every term of a certificate is a product of two inline integers (at most 16 digits),
+	which fits in 107 bits: the integral kernel accumulates those in a 128-bit integer, and is
+	vectorized with AVX2 when available (gathers of the dense values, and 32-bit products in
+	four 64-bit lanes while the operands are small). Rows with a term that is not an inline
+	integer (a fraction, a long integer or an infinity) go through the exact rational path.
+*/
+
+// Rows longer than this always take the exact path (the 128-bit sum could overflow)
+constexpr unsigned long SPARSE_DOT_MAXIMUM_INTEGRAL_LENGTH = (1UL << 20);
+
+/**
+	Integral kernel.
+
+	@param indexes Column indexes of the row
+	@param coefficients Coefficients of the row
+	@param number_coefficients Length of the row
+	@param values Dense vector indexed by column
+	@param result Dot product (only set when the kernel succeeds)
+	@return False if some term is not a product of inline integers (or the row is too long)
+*/
+bool sparse_dot_integral(const unsigned long *indexes, const Number *coefficients, unsigned long number_coefficients, const Number *values, __int128 &result);
+
+// Scalar exact path (one rational multiply-add per non-zero term)
+Rational sparse_dot_exact(const unsigned long *indexes, const Number *coefficients, unsigned long number_coefficients, const Number *values);
+
+// Integral kernel, falling back to the exact path for rows it cannot handle
+Rational sparse_dot(const unsigned long *indexes, const Number *coefficients, unsigned long number_coefficients, const Number *values);
+
+#endif /* SPARSE_DOT_H */
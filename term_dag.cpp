@@ -0,0 +1,758 @@
+#include "term_dag.h"
+
+#include "smt_operators.h"
+
+#include <new>
+
+//////////////////////////
+// Building and sharing //
+//////////////////////////
+
+constexpr size_t INITIAL_TABLE_CAPACITY = 1024;
+
+static inline uint64_t mix_hash(uint64_t hash, uint64_t value) {
+	hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+
+	return hash * 0xBF58476D1CE4E5B9ULL;
+}
+
+TermDag::TermDag(): arena{ArenaTransparentHugePages, 64UL * 1024 * 1024}, number_terms{0}, table(INITIAL_TABLE_CAPACITY, Slot{nullptr, 0}), generation{1}, result{nullptr}, operand_mark{0} {
+	empty_mark = arena.get_mark();
+}
+
+void TermDag::grow_table() {
+	vector<Slot> old_table(table.size() * 2, Slot{nullptr, 0});
+
+	old_table.swap(table);
+
+	size_t mask = table.size() - 1;
+
+	for(Slot &slot: old_table) {
+		if(slot.generation != generation) {
+			continue;
+		}
+
+		size_t position = slot.term->hash & mask;
+
+		while(table[position].generation == generation) {
+			position = (position + 1) & mask;
+		}
+
+		table[position] = slot;
+	}
+}
+
+DagTerm *TermDag::intern(DagKind kind, int op, int64_t value, Number number, DagTerm **children, uint32_t number_children) {
+	uint64_t hash = mix_hash(mix_hash(mix_hash(kind, op), value), number.bits);
+
+	for(uint32_t i = 0; i < number_children; i++) {
+		hash = mix_hash(hash, children[i]->id);
+	}
+
+	auto is_equal = [&] (DagTerm *term) {
+		if(term->hash != hash || term->kind != kind || term->op != op || term->value != value || term->number.bits != number.bits || term->number_children != number_children) {
+			return false;
+		}
+
+		for(uint32_t i = 0; i < number_children; i++) {
+			if(term->children[i] != children[i]) {
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	size_t mask = table.size() - 1;
+	size_t position = hash & mask;
+
+	for(; table[position].generation == generation; position = (position + 1) & mask) {
+		if(is_equal(table[position].term)) {
+			return table[position].term;
+		}
+	}
+
+	DagTerm *term = new (arena.allocate<DagTerm>(1)) DagTerm{kind, op, number_terms++, number_children, hash, value, number, nullptr};
+
+	if(number_children != 0) {
+		term->children = arena.allocate<DagTerm *>(number_children);
+
+		std::copy(children, children + number_children, term->children);
+	}
+
+	table[position] = Slot{term, generation};
+
+	// Load factor at most 1/2
+	if(2 * static_cast<size_t>(number_terms) > table.size()) {
+		grow_table();
+	}
+
+	return term;
+}
+
+void TermDag::clear() {
+	arena.rewind(empty_mark);
+
+	number_terms = 0;
+	generation++;
+
+	frames.clear();
+	operands.clear();
+
+	result = nullptr;
+}
+
+DagTerm *TermDag::make_boolean(bool value) {
+	return intern(DagBoolean, NO_DAG_OPERATOR, value, Number(), nullptr, 0);
+}
+
+DagTerm *TermDag::make_integer(int64_t value) {
+	return intern(DagInteger, NO_DAG_OPERATOR, value, Number(), nullptr, 0);
+}
+
+void TermDag::add(DagTerm *term) {
+	if(frames.empty()) {
+		result = term;
+	}
+	else {
+		operands.push_back(term);
+	}
+}
+
+void TermDag::begin(int op) {
+	frames.push_back(Frame{op, operands.size()});
+}
+
+void TermDag::end() {
+	Frame frame = frames.back();
+	frames.pop_back();
+
+	DagTerm *term = make_operator(frame.op, operands.data() + frame.first_operand, operands.size() - frame.first_operand);
+
+	operands.resize(frame.first_operand);
+
+	add(term);
+}
+
+void TermDag::add_boolean(bool value) {
+	add(make_boolean(value));
+}
+
+void TermDag::add_integer(int64_t value) {
+	add(make_integer(value));
+}
+
+void TermDag::add_number(Number number) {
+	if(number.is_inline()) {
+		add_integer(number.get_inline_value());
+	}
+	else {
+		add(intern(DagNumber, NO_DAG_OPERATOR, 0, number, nullptr, 0));
+	}
+}
+
+/////////////
+// Folding //
+/////////////
+
+static inline bool is_boolean(DagTerm *term, bool value) {
+	return (term->kind == DagBoolean && term->value == value);
+}
+
+// Whether the term is a finite constant number (and its value)
+static bool get_constant(DagTerm *term, Rational &value) {
+	if(term->kind == DagInteger) {
+		value = Rational(term->value);
+		return true;
+	}
+
+	if(term->kind == DagNumber && !term->number.is_positive_infinity() && !term->number.is_negative_infinity()) {
+		value = Rational(term->number);
+		return true;
+	}
+
+	return false;
+}
+
+static bool compare_constants(int op, int comparison) {
+	switch(op) {
+		case OP_EQ:
+			return (comparison == 0);
+		case OP_NEQ:
+			return (comparison != 0);
+		case OP_LEQ:
+			return (comparison <= 0);
+		case OP_GEQ:
+			return (comparison >= 0);
+		case OP_L:
+			return (comparison < 0);
+		default:
+			return (comparison > 0);
+	}
+}
+
+/**
+	Folds and, or: drops neutral and repeated operands, inlines the operands of nested terms
+	with the same operator, and collapses to a constant (no operands left, or an absorbing
+	operand) or to its single operand.
+*/
+DagTerm *TermDag::fold_associative(int op, DagTerm **children, uint32_t number_children) {
+	bool neutral = (op == OP_AND);
+
+	vector<DagTerm *> folded;
+
+	operand_mark++;
+
+	if(operand_marks.size() < number_terms) {
+		operand_marks.resize(number_terms, 0);
+	}
+
+	auto add_operand = [&] (DagTerm *term) {
+		if(operand_marks[term->id] != operand_mark) {
+			operand_marks[term->id] = operand_mark;
+			folded.push_back(term);
+		}
+	};
+
+	for(uint32_t i = 0; i < number_children; i++) {
+		DagTerm *child = children[i];
+
+		if(is_boolean(child, !neutral)) {
+			return make_boolean(!neutral);
+		}
+
+		if(is_boolean(child, neutral)) {
+			continue;
+		}
+
+		if(child->kind == DagOperator && child->op == op) {
+			for(uint32_t k = 0; k < child->number_children; k++) {
+				add_operand(child->children[k]);
+			}
+		}
+		else {
+			add_operand(child);
+		}
+	}
+
+	if(folded.empty()) {
+		return make_boolean(neutral);
+	}
+
+	if(folded.size() == 1) {
+		return folded[0];
+	}
+
+	return intern(DagOperator, op, 0, Number(), folded.data(), folded.size());
+}
+
+DagTerm *TermDag::make_operator(int op, DagTerm **children, uint32_t number_children) {
+	auto make = [&] {
+		return intern(DagOperator, op, 0, Number(), children, number_children);
+	};
+
+	switch(op) {
+		case OP_AND:
+		case OP_OR:
+			return fold_associative(op, children, number_children);
+		case OP_PLUS:
+		case OP_TIMES: {
+			// Inlines nested sums (products) and combines the integer operands
+			int64_t neutral = (op == OP_PLUS ? 0 : 1);
+			int64_t constant = neutral;
+
+			vector<DagTerm *> folded;
+
+			auto add_operand = [&] (DagTerm *term) {
+				int64_t combined;
+
+				if(term->kind != DagInteger) {
+					folded.push_back(term);
+				}
+				else if(op == OP_PLUS ? __builtin_add_overflow(constant, term->value, &combined) : __builtin_mul_overflow(constant, term->value, &combined)) {
+					folded.push_back(term);
+				}
+				else {
+					constant = combined;
+				}
+			};
+
+			for(uint32_t i = 0; i < number_children; i++) {
+				if(children[i]->kind == DagOperator && children[i]->op == op) {
+					for(uint32_t k = 0; k < children[i]->number_children; k++) {
+						add_operand(children[i]->children[k]);
+					}
+				}
+				else {
+					add_operand(children[i]);
+				}
+			}
+
+			// Products with a zero factor are zero (every operand is finite)
+			if(op == OP_TIMES && constant == 0) {
+				return make_integer(0);
+			}
+
+			if(constant != neutral || folded.empty()) {
+				folded.push_back(make_integer(constant));
+			}
+
+			if(folded.size() == 1) {
+				return folded[0];
+			}
+
+			return intern(DagOperator, op, 0, Number(), folded.data(), folded.size());
+		}
+		case OP_NOT:
+			if(number_children == 1 && children[0]->kind == DagBoolean) {
+				return make_boolean(!children[0]->value);
+			}
+
+			if(number_children == 1 && children[0]->kind == DagOperator && children[0]->op == OP_NOT) {
+				return children[0]->children[0];
+			}
+			break;
+		case OP_IMPLICATION:
+			if(number_children != 2) {
+				break;
+			}
+
+			if(is_boolean(children[0], false) || is_boolean(children[1], true) || children[0] == children[1]) {
+				return make_boolean(true);
+			}
+
+			if(is_boolean(children[0], true)) {
+				return children[1];
+			}
+			break;
+		case OP_ITE:
+			if(number_children == 3 && children[0]->kind == DagBoolean) {
+				return children[children[0]->value ? 1 : 2];
+			}
+
+			if(number_children == 3 && children[1] == children[2]) {
+				return children[1];
+			}
+			break;
+		case OP_MINUS:
+			if(number_children == 1 && children[0]->kind == DagInteger && children[0]->value != INT64_MIN) {
+				return make_integer(-children[0]->value);
+			}
+			break;
+		case OP_EQ:
+		case OP_NEQ:
+		case OP_LEQ:
+		case OP_GEQ:
+		case OP_L:
+		case OP_G: {
+			if(number_children != 2) {
+				break;
+			}
+
+			// Equal terms have equal (finite) values
+			if(children[0] == children[1]) {
+				return make_boolean(op == OP_EQ || op == OP_LEQ || op == OP_GEQ);
+			}
+
+			Rational a;
+			Rational b;
+
+			if(get_constant(children[0], a) && get_constant(children[1], b)) {
+				return make_boolean(compare_constants(op, Rational::compare(a, b)));
+			}
+			break;
+		}
+		case OP_INTEGRAL: {
+			Rational a;
+
+			if(number_children == 1 && get_constant(children[0], a)) {
+				return make_boolean(a.is_integral());
+			}
+			break;
+		}
+		case OP_RND_DOWN:
+			if(number_children == 1 && children[0]->kind == DagInteger) {
+				return children[0];
+			}
+			break;
+	}
+
+	return make();
+}
+
+///////////////////
+// Text backend //
+///////////////////
+
+static inline void append_integer(int64_t value, string &output) {
+	char buffer[MAXIMUM_INTEGER_LENGTH];
+
+	char *end = buffer + MAXIMUM_INTEGER_LENGTH;
+	char *start = format_smt_integer(value, end);
+
+	output.append(start, end - start);
+}
+
+static inline size_t get_integer_length(int64_t value) {
+	char buffer[MAXIMUM_INTEGER_LENGTH];
+
+	char *end = buffer + MAXIMUM_INTEGER_LENGTH;
+
+	return end - format_smt_integer(value, end);
+}
+
+static inline size_t get_name_length(uint32_t id) {
+	char buffer[MAXIMUM_INTEGER_LENGTH];
+
+	char *end = buffer + MAXIMUM_INTEGER_LENGTH;
+
+	return 1 + (end - format_unsigned(id, end));
+}
+
+static inline void append_name(uint32_t id, string &output) {
+	char buffer[MAXIMUM_INTEGER_LENGTH];
+
+	char *end = buffer + MAXIMUM_INTEGER_LENGTH;
+	char *start = format_unsigned(id, end);
+
+	output.append("t");
+	output.append(start, end - start);
+}
+
+void TermDag::write_atom(DagTerm *term, string &output) {
+	switch(term->kind) {
+		case DagBoolean:
+			output.append(term->value ? "true" : "false");
+			break;
+		case DagInteger:
+			append_integer(term->value, output);
+			break;
+		default: {
+			NumberEntry &entry = term->number.get_entry();
+
+			output.append(entry.smt, entry.smt_length);
+			break;
+		}
+	}
+}
+
+// Operators reachable from term, children before parents, and how many times each is used
+static void get_operators(DagTerm *term, uint32_t number_terms, vector<DagTerm *> &order, vector<uint32_t> &uses) {
+	uses.assign(number_terms, 0);
+
+	vector<std::pair<DagTerm *, uint32_t>> stack;
+
+	uses[term->id] = 1;
+	stack.emplace_back(term, 0);
+
+	while(!stack.empty()) {
+		auto &[current, next] = stack.back();
+
+		if(next == current->number_children) {
+			if(current->kind == DagOperator) {
+				order.push_back(current);
+			}
+
+			stack.pop_back();
+			continue;
+		}
+
+		DagTerm *child = current->children[next++];
+
+		if(uses[child->id]++ == 0) {
+			stack.emplace_back(child, 0);
+		}
+	}
+}
+
+void TermDag::write_smt(DagTerm *term, string &output) {
+	vector<DagTerm *> order;
+	vector<uint32_t> uses;
+
+	get_operators(term, number_terms, order, uses);
+
+	// Length of each term as printed (bound subterms by their names), and the let level of bound terms
+	vector<size_t> lengths(number_terms, 0);
+	vector<uint32_t> levels(number_terms, 0);
+	vector<bool> bound(number_terms, false);
+
+	uint32_t maximum_level = 0;
+
+	auto get_length = [&] (DagTerm *child) -> size_t {
+		if(bound[child->id]) {
+			return get_name_length(child->id);
+		}
+
+		switch(child->kind) {
+			case DagBoolean:
+				return (child->value ? 4 : 5);
+			case DagInteger:
+				return get_integer_length(child->value);
+			case DagNumber:
+				return child->number.get_entry().smt_length;
+			default:
+				return lengths[child->id];
+		}
+	};
+
+	for(DagTerm *current: order) {
+		size_t length = OP_PREFIXES[current->op].length + current->number_children;
+		uint32_t level = 0;
+
+		for(uint32_t i = 0; i < current->number_children; i++) {
+			DagTerm *child = current->children[i];
+
+			length += get_length(child);
+			level = std::max(level, levels[child->id]);
+		}
+
+		lengths[current->id] = length;
+
+		// "(name value) " once and the name at every use, instead of the value at every use
+		size_t name_length = get_name_length(current->id);
+		size_t count = uses[current->id];
+
+		if(current != term && count > 1 && count * length > length + name_length + 4 + count * name_length) {
+			bound[current->id] = true;
+			level++;
+
+			maximum_level = std::max(maximum_level, level);
+		}
+
+		levels[current->id] = level;
+	}
+
+	auto write_term = [&] (auto &&write_term, DagTerm *current, bool definition) -> void {
+		if(bound[current->id] && !definition) {
+			append_name(current->id, output);
+			return;
+		}
+
+		if(current->kind != DagOperator) {
+			write_atom(current, output);
+			return;
+		}
+
+		output.append(OP_PREFIXES[current->op].text, OP_PREFIXES[current->op].length);
+
+		for(uint32_t i = 0; i < current->number_children; i++) {
+			if(i != 0) {
+				output.append(" ");
+			}
+
+			write_term(write_term, current->children[i], false);
+		}
+
+		output.append(")");
+	};
+
+	// One let per level: bindings only refer to those of lower levels
+	for(uint32_t level = 1; level <= maximum_level; level++) {
+		output.append("(let (");
+
+		for(DagTerm *current: order) {
+			if(bound[current->id] && levels[current->id] == level) {
+				output.append("(");
+				append_name(current->id, output);
+				output.append(" ");
+				write_term(write_term, current, true);
+				output.append(") ");
+			}
+		}
+
+		output.append(") ");
+	}
+
+	write_term(write_term, term, true);
+
+	output.append(maximum_level, ')');
+}
+
+////////////////////////
+// Evaluation backend //
+////////////////////////
+
+Rational TermDag::evaluate(DagTerm *term) {
+	vector<Rational> values(number_terms);
+	vector<bool> evaluated(number_terms, false);
+
+	auto evaluate_term = [&] (auto &&evaluate_term, DagTerm *current) -> Rational {
+		if(evaluated[current->id]) {
+			return values[current->id];
+		}
+
+		auto get = [&] (uint32_t i) {
+			return evaluate_term(evaluate_term, current->children[i]);
+		};
+
+		auto is_true = [&] (uint32_t i) {
+			return !get(i).is_zero();
+		};
+
+		// Chained comparison of consecutive operands
+		auto compare_all = [&] (int op) {
+			for(uint32_t i = 0; i + 1 < current->number_children; i++) {
+				if(!compare_constants(op, Rational::compare(get(i), get(i + 1)))) {
+					return false;
+				}
+			}
+
+			return true;
+		};
+
+		Rational value;
+
+		switch(current->kind) {
+			case DagBoolean:
+			case DagInteger:
+				value = Rational(current->value);
+				break;
+			case DagNumber:
+				value = Rational(current->number);
+				break;
+			case DagOperator:
+				switch(current->op) {
+					case OP_ASSERT:
+						value = get(0);
+						break;
+					case OP_NOT:
+						value = Rational(!is_true(0));
+						break;
+					case OP_AND:
+					case OP_OR: {
+						bool absorbing = (current->op == OP_OR);
+						bool result = !absorbing;
+
+						for(uint32_t i = 0; i < current->number_children; i++) {
+							if(is_true(i) == absorbing) {
+								result = absorbing;
+								break;
+							}
+						}
+
+						value = Rational(result);
+						break;
+					}
+					case OP_IMPLICATION:
+						value = Rational(!is_true(0) || is_true(1));
+						break;
+					case OP_ITE:
+						value = get(is_true(0) ? 1 : 2);
+						break;
+					case OP_PLUS:
+						for(uint32_t i = 0; i < current->number_children; i++) {
+							value += get(i);
+						}
+						break;
+					case OP_MINUS:
+						value = (current->number_children == 1 ? -get(0) : get(0));
+
+						for(uint32_t i = 1; i < current->number_children; i++) {
+							value -= get(i);
+						}
+						break;
+					case OP_TIMES:
+						value = Rational(1);
+
+						for(uint32_t i = 0; i < current->number_children; i++) {
+							value *= get(i);
+						}
+						break;
+					case OP_DIVIDE:
+						value = get(0);
+
+						for(uint32_t i = 1; i < current->number_children; i++) {
+							value = value / get(i);
+						}
+						break;
+					case OP_NEQ: {
+						bool distinct = true;
+
+						for(uint32_t i = 0; i < current->number_children && distinct; i++) {
+							for(uint32_t k = i + 1; k < current->number_children && distinct; k++) {
+								distinct = (get(i) != get(k));
+							}
+						}
+
+						value = Rational(distinct);
+						break;
+					}
+					case OP_EQ:
+					case OP_LEQ:
+					case OP_GEQ:
+					case OP_L:
+					case OP_G:
+						value = Rational(compare_all(current->op));
+						break;
+					case OP_INTEGRAL:
+						value = Rational(get(0).is_integral());
+						break;
+					case OP_RND_DOWN:
+						value = Rational(get(0).floor());
+						break;
+					default:
+						throw runtime_error(format("Error evaluating the operator {}\n", OP_STRINGS[current->op]));
+				}
+				break;
+		}
+
+		evaluated[current->id] = true;
+		values[current->id] = value;
+
+		return value;
+	};
+
+	return evaluate_term(evaluate_term, term);
+}
+
+//////////////////
+// Cost backend //
+//////////////////
+
+DagCost TermDag::get_cost(DagTerm *term) {
+	vector<DagTerm *> order;
+	vector<uint32_t> uses;
+
+	get_operators(term, number_terms, order, uses);
+
+	DagCost cost{0, 0, 0};
+
+	for(uint32_t id = 0; id < number_terms; id++) {
+		cost.dag_nodes += (uses[id] != 0);
+	}
+
+	// Sizes of the trees under each term
+	vector<unsigned long> tree_nodes(number_terms, 1);
+	vector<unsigned long> tree_lengths(number_terms, 0);
+
+	auto get_atom_length = [] (DagTerm *atom) -> unsigned long {
+		switch(atom->kind) {
+			case DagBoolean:
+				return (atom->value ? 4 : 5);
+			case DagInteger:
+				return get_integer_length(atom->value);
+			default:
+				return atom->number.get_entry().smt_length;
+		}
+	};
+
+	for(DagTerm *current: order) {
+		unsigned long nodes = 1;
+		unsigned long length = OP_PREFIXES[current->op].length + current->number_children;
+
+		for(uint32_t i = 0; i < current->number_children; i++) {
+			DagTerm *child = current->children[i];
+
+			nodes += tree_nodes[child->id];
+			length += (child->kind == DagOperator ? tree_lengths[child->id] : get_atom_length(child));
+		}
+
+		tree_nodes[current->id] = nodes;
+		tree_lengths[current->id] = length;
+	}
+
+	cost.tree_nodes = tree_nodes[term->id];
+	cost.tree_length = (term->kind == DagOperator ? tree_lengths[term->id] : get_atom_length(term));
+
+	return cost;
+}
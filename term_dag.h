@@ -0,0 +1,153 @@
+#ifndef TERM_DAG_H
+#define TERM_DAG_H
+
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include "Arena.hpp"
+#include "basic_types.h"
+#include "rational.h"
+
+using std::string;
+using std::vector;
+
+// Operator of atoms
+constexpr int NO_DAG_OPERATOR = -1;
+
+enum DagKind {
+	DagBoolean,
+	DagInteger,
+	DagNumber,
+	DagOperator
+};
+
+/**
+	Node of the term DAG. Atoms are booleans, inline integers (value) and other certificate
+	numbers (number); operators (op, an index in OP_STRINGS) have their operands in children.
+	Nodes are hash-consed, so equal terms are the same node.
+*/
+struct DagTerm {
+	DagKind kind;
+	int op;
+
+	// Dense in creation order: backends keep per-node data in vectors indexed by id
+	uint32_t id;
+	uint32_t number_children;
+
+	uint64_t hash;
+
+	// Value of booleans (0 or 1) and inline integers
+	int64_t value;
+	Number number;
+
+	DagTerm **children;
+};
+
+// Size of a term printed as a tree (shared subterms repeated) and as a DAG (each node once)
+struct DagCost {
+	unsigned long tree_nodes;
+	unsigned long dag_nodes;
+
+	// Length of the SMT-LIB text without sharing
+	unsigned long tree_length;
+};
+
+/**
+	Hash-consed term DAG in an arena, an intermediate representation between the certificate
+	rules and their backends.
+
+	Terms are built like they are printed: begin(op), the operands (atoms or nested operators)
+	and end(). Operators are folded as they are built, like the text emitters fold them, and
+	equal subterms are shared. Backends then write the SMT-LIB text of a term (binding shared
+	subterms with let), evaluate it with exact arithmetic, or compute its cost.
+
+	clear() releases every term at once, so that a DAG is reused across derivations.
+*/
+class TermDag {
+	struct Frame {
+		int op;
+		size_t first_operand;
+	};
+
+	Arena arena;
+	Arena::Mark empty_mark;
+
+	uint32_t number_terms;
+
+	// Open addressing (power of two capacity); slots of other generations are empty
+	struct Slot {
+		DagTerm *term;
+		uint32_t generation;
+	};
+
+	vector<Slot> table;
+	uint32_t generation;
+
+	vector<Frame> frames;
+	vector<DagTerm *> operands;
+
+	DagTerm *result;
+
+	// Operands already added to the and/or being folded (marks by term id)
+	vector<uint64_t> operand_marks;
+	uint64_t operand_mark;
+
+	DagTerm *intern(DagKind kind, int op, int64_t value, Number number, DagTerm **children, uint32_t number_children);
+	void grow_table();
+
+	void add(DagTerm *term);
+
+	DagTerm *make_operator(int op, DagTerm **children, uint32_t number_children);
+	DagTerm *fold_associative(int op, DagTerm **children, uint32_t number_children);
+
+	void write_atom(DagTerm *term, string &output);
+
+public:
+	TermDag();
+
+	TermDag(const TermDag &) = delete;
+	TermDag &operator=(const TermDag &) = delete;
+
+	// Builder
+	void begin(int op);
+	void end();
+
+	void add_boolean(bool value);
+	void add_integer(int64_t value);
+	void add_number(Number number);
+
+	// The term built last outside of operators (nullptr if none)
+	inline DagTerm *get_result() {
+		return result;
+	}
+
+	inline bool is_building() {
+		return !frames.empty();
+	}
+
+	DagTerm *make_boolean(bool value);
+	DagTerm *make_integer(int64_t value);
+
+	void clear();
+
+	inline uint32_t get_number_terms() {
+		return number_terms;
+	}
+
+	// Backends
+
+	/**
+		Appends the SMT-LIB text of a term. Operators used more than once are bound with let
+		(names t<id>) when that makes the text shorter.
+	*/
+	void write_smt(DagTerm *term, string &output);
+
+	// Exact value of a term (booleans are 0 or 1); throws on values SMT-LIB cannot express
+	Rational evaluate(DagTerm *term);
+
+	DagCost get_cost(DagTerm *term);
+};
+
+#endif /* TERM_DAG_H */